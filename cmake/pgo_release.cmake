@@ -0,0 +1,108 @@
+# release pipeline: plain build, instrumented build, training run, profile guided + lto rebuild,
+# then times the plain build against the tuned one on a session neither of them trained on.
+#
+# usage: cmake [-DBUILD_ROOT=<dir>] [-DTRAINING_TICKS=<ticks per phase>] [-DMEASURE_RUNS=<n>] -P cmake/pgo_release.cmake
+# extra configure arguments (a generator, a compiler) go in -DCONFIGURE_ARGS="-G;Ninja"
+
+cmake_minimum_required(VERSION 3.9)
+
+get_filename_component(SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR}/.. ABSOLUTE)
+if(NOT BUILD_ROOT)
+    set(BUILD_ROOT ${SOURCE_DIR}/build-release)
+endif()
+if(NOT TRAINING_TICKS)
+    set(TRAINING_TICKS 3600)
+endif()
+if(NOT MEASURE_RUNS)
+    set(MEASURE_RUNS 3)
+endif()
+
+set(TRAINING_SEED 1)
+set(MEASURE_SEED 2) # a different match than the one the profiles came from
+set(PLAIN_DIR ${BUILD_ROOT}/plain)
+set(TUNED_DIR ${BUILD_ROOT}/tuned)
+set(PROFILE_DIR ${BUILD_ROOT}/profiles)
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "failed: ${ARGN}")
+    endif()
+endfunction()
+
+function(configure_and_build directory)
+    run_step(${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${directory} -DCMAKE_BUILD_TYPE=Release ${CONFIGURE_ARGS} ${ARGN})
+    run_step(${CMAKE_COMMAND} --build ${directory} --config Release --target Game)
+endfunction()
+
+# single + multi config generators put the executable in different places
+function(find_game directory result)
+    foreach(candidate ${directory}/Game ${directory}/Game.exe ${directory}/Release/Game ${directory}/Release/Game.exe)
+        if(EXISTS ${candidate} AND NOT IS_DIRECTORY ${candidate})
+            set(${result} ${candidate} PARENT_SCOPE)
+            return()
+        endif()
+    endforeach()
+    message(FATAL_ERROR "no Game executable in ${directory}!")
+endfunction()
+
+# best of MEASURE_RUNS, in microseconds per tick
+function(measure_game game result)
+    set(best "")
+    foreach(run RANGE 1 ${MEASURE_RUNS})
+        execute_process(COMMAND ${game} --training ${TRAINING_TICKS} ${MEASURE_SEED}
+                        OUTPUT_VARIABLE output RESULT_VARIABLE exitCode)
+        string(REGEX MATCH "([0-9.]+) us per tick over" line "${output}")
+        if(NOT exitCode EQUAL 0 OR NOT line)
+            message(FATAL_ERROR "the training workload didn't report a tick time:\n${output}")
+        endif()
+        if(best STREQUAL "" OR CMAKE_MATCH_1 LESS best)
+            set(best ${CMAKE_MATCH_1})
+        endif()
+    endforeach()
+    set(${result} ${best} PARENT_SCOPE)
+endfunction()
+
+message(STATUS "building the plain release")
+configure_and_build(${PLAIN_DIR} -DPONG_PGO=OFF -DPONG_LTO=OFF)
+
+message(STATUS "building the instrumented release")
+file(REMOVE_RECURSE ${PROFILE_DIR})
+file(MAKE_DIRECTORY ${PROFILE_DIR})
+configure_and_build(${TUNED_DIR} -DPONG_PGO=GENERATE -DPONG_LTO=OFF -DPONG_PGO_DIR=${PROFILE_DIR})
+
+message(STATUS "training on ${TRAINING_TICKS} ticks per phase")
+find_game(${TUNED_DIR} instrumentedGame)
+run_step(${instrumentedGame} --training ${TRAINING_TICKS} ${TRAINING_SEED})
+
+# clang leaves raw profiles that have to be merged, gcc's .gcda files get read as they are
+file(GLOB rawProfiles ${PROFILE_DIR}/*.profraw)
+if(rawProfiles)
+    find_program(LLVM_PROFDATA NAMES llvm-profdata llvm-profdata-19 llvm-profdata-18 llvm-profdata-17 llvm-profdata-16 llvm-profdata-15 llvm-profdata-14)
+    if(NOT LLVM_PROFDATA)
+        message(FATAL_ERROR "clang profiles need llvm-profdata to merge them!")
+    endif()
+    run_step(${LLVM_PROFDATA} merge -output=${PROFILE_DIR}/pong.profdata ${rawProfiles})
+endif()
+
+# same build directory as the instrumented one, so gcc can match profiles to objects
+message(STATUS "building the profile guided + lto release")
+configure_and_build(${TUNED_DIR} -DPONG_PGO=USE -DPONG_LTO=ON -DPONG_PGO_DIR=${PROFILE_DIR})
+
+find_game(${PLAIN_DIR} plainGame)
+find_game(${TUNED_DIR} tunedGame)
+measure_game(${plainGame} plainTime)
+measure_game(${tunedGame} tunedTime)
+
+# cmake can't divide decimals, so the ratio is worked out in hundredths
+string(REPLACE "." "" plainDigits ${plainTime})
+string(REPLACE "." "" tunedDigits ${tunedTime})
+math(EXPR speedup "${plainDigits} * 100 / ${tunedDigits}")
+math(EXPR speedupWhole "${speedup} / 100")
+math(EXPR speedupFraction "${speedup} % 100")
+if(speedupFraction LESS 10)
+    set(speedupFraction 0${speedupFraction})
+endif()
+
+message(STATUS "plain release ${plainTime} us per tick, pgo + lto ${tunedTime} us per tick (${speedupWhole}.${speedupFraction}x)")
+message(STATUS "shipping build: ${tunedGame}")
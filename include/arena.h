@@ -0,0 +1,84 @@
+#ifndef PONG_ARENA_H
+#define PONG_ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "platform.h"
+
+#define FRAME_ARENA_SIZE (256 * 1024)  // in bytes
+#define ARENA_ALIGNMENT 16             // in bytes
+#define MAX_TRACKED_ALLOCATORS 32
+#define ALLOCATOR_PREWARM_STRIDE 4096  // in bytes, the smallest page size we care about
+
+// linear "bump" allocator over a fixed block of memory, freed all at once
+typedef struct Arena {
+    const char *name;
+    unsigned char *memory;
+    size_t capacity;
+    size_t used;
+    size_t highWaterMark;
+    int failedAllocations;
+} Arena;
+
+// fixed-size block allocator with an intrusive free list of element indices
+typedef struct Pool {
+    const char *name;
+    unsigned char *memory;
+    size_t elementSize;
+    int capacity;
+    int freeHead;
+    int usedCount;
+    int highWaterMark;
+    int failedAllocations;
+} Pool;
+
+// one world's scratch memory, and every arena + pool it has initialized (for reporting)
+typedef struct AllocatorRegistry {
+    _Alignas(ARENA_ALIGNMENT) unsigned char frameArenaMemory[FRAME_ARENA_SIZE];
+    Arena frameArena;
+    Arena *trackedArenas[MAX_TRACKED_ALLOCATORS];
+    int trackedArenaCount;
+    Pool *trackedPools[MAX_TRACKED_ALLOCATORS];
+    int trackedPoolCount;
+} AllocatorRegistry;
+
+void InitArena(Arena *arena, const char *name, void *memory, size_t capacity);
+void *AllocateFromArena(Arena *arena, size_t size);
+void ResetArena(Arena *arena);
+size_t GetArenaMarker(const Arena *arena);
+void RewindArenaTo(Arena *arena, size_t marker);
+
+void InitPool(Pool *pool, const char *name, void *memory, size_t elementSize, int capacity);
+void *AllocateFromPool(Pool *pool);
+void ReleaseToPool(Pool *pool, void *element);
+int GetPoolIndex(const Pool *pool, const void *element);
+void *GetPoolElement(const Pool *pool, int index);
+void ResetPool(Pool *pool);
+
+// transient memory that is only valid until the start of the next frame, the current world's
+void InitFrameArenas();
+void ResetFrameArenas();
+void *FrameAllocate(size_t size);
+Arena *GetFrameArena();
+
+void ReportMemoryHighWaterMarks();
+// touches every page of every arena + pool so the os has them mapped before gameplay needs them
+void PrewarmTrackedAllocators();
+// every arena + pool the current world has initialized, for reporting
+int GetTrackedArenaCount();
+const Arena *GetTrackedArena(int index);
+int GetTrackedPoolCount();
+const Pool *GetTrackedPool(int index);
+
+#define FRAME_ALLOCATE_ARRAY(TYPE, COUNT) ((TYPE *) FrameAllocate(sizeof(TYPE) * (COUNT)))
+
+// declares backing storage + a pool over it, call INIT_STATIC_POOL before use.
+// simulation state lives in the world, so these go inside a module's part of it
+#define DECLARE_STATIC_POOL(NAME, TYPE, CAPACITY) \
+    TYPE NAME ## Storage[CAPACITY];                \
+    Pool NAME
+
+#define INIT_STATIC_POOL(NAME) \
+    InitPool(&NAME, #NAME, NAME ## Storage, sizeof(NAME ## Storage[0]), (int) (sizeof(NAME ## Storage) / sizeof(NAME ## Storage[0])))
+
+#endif // PONG_ARENA_H
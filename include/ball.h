@@ -1,7 +1,12 @@
 #ifndef PONG_BALL_H
 #define PONG_BALL_H
 
-#define MAX_BALLS 10
+#include "hazard.h"
+#include "arena.h"
+#include "fixed_math.h"
+
+#define MAX_BALLS 512               // room for a big field, a screen sized one is packed way before this
+#define CROWDED_BALL_COUNT 64       // as many as a screen sized field can take and stay playable
 #define BALL_SIZE 35                // in pixels
 #define BALL_MIN_SIZE 15            // in pixels
 #define BALL_SPEED 10               // in pixels per second
@@ -10,14 +15,67 @@
 #define BALL_ACCELERATION_TIME 0.5f // in seconds
 #define BALL_SPAWN_TIME 1           // in seconds
 
+#define BALL_TRAIL_LENGTH 20          // in samples
+#define BALL_TRAIL_SAMPLE_TIME 0.05f  // in seconds
+#define BALL_TRAIL_WIDTH 4            // in pixels
+#define BALL_TRAIL_MIN_ALPHA 60       // oldest trail segment alpha, still visible since it still hurts
+
 #define MAX_BOUNCE_EFFECTS 16
 #define BOUNCE_EFFECT_DURATION 1.5f // in seconds
 #define BOUNCE_EFFECT_MAX_SIZE 5    // multiple of original size
 #define BOUNCE_EFFECT_WIDTH 2       // in pixels
 
+typedef struct BounceEffect {
+    int startTick;
+    Vector2 position;
+    Color color;
+} BounceEffect;
+
+typedef enum BallState {
+    BALL_STATE_SPAWNING,
+    BALL_STATE_ACTIVE,
+} BallState;
+
+typedef struct BallInstance {
+    union {
+        struct {
+            SimVector2 velocity;
+            float timeSinceBounce;
+        } active;
+        struct {
+            int startTick;
+        } spawning;
+    };
+    SimScalar size;
+    SimVector2 position;
+    Color color;
+    BallState state;
+    int skippedTickCount; // ticks slept through in a reduced chunk, made up for on the next update
+
+    // ring buffer of where the ball has been, trailHead is the next slot to write
+    SimVector2 trail[BALL_TRAIL_LENGTH];
+    int trailHead;
+    int trailCount;
+    float trailSampleTime;
+} BallInstance;
+
+// one world's balls + the bounce effects they've set off
+typedef struct BallWorld {
+    BallInstance spawnedBalls[MAX_BALLS];
+    int spawnedBallCount;
+    DECLARE_STATIC_POOL(bounceEffectPool, BounceEffect, MAX_BOUNCE_EFFECTS);
+    // pool indices of the bounce effects currently playing, kept dense for iteration
+    int activeBounceEffects[MAX_BOUNCE_EFFECTS];
+    int activeBounceEffectCount;
+    // BALL_MAX_SPEED unless something (like a difficulty sweep) wants to try another
+    float maxSpeed;
+} BallWorld;
+
 void InitBalls();
 void UpdateBalls(float deltaTime);
 void RenderBalls();
 void SpawnBall();
+// balls + trail segments overlapping area, returns how many were written
+int GatherBallHazards(Rectangle area, Hazard *hazards, int capacity);
 
 #endif // PONG_BALL_H
\ No newline at end of file
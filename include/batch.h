@@ -0,0 +1,12 @@
+#ifndef PONG_BATCH_H
+#define PONG_BATCH_H
+
+#define BATCH_MAX_MATCH_TICKS (SIMULATION_TICK_RATE * 60 * 2) // a bot that lasts this long counts as surviving
+#define BATCH_DEFAULT_WORLDS_PER_SETTING 200
+#define MAX_BATCH_THREADS 64
+
+// plays worldsPerSetting bot matches for every ball count + max speed combination,
+// spread over threadCount threads (0 for one per core), and prints how long the bot survived
+int RunBatch(int worldsPerSetting, int threadCount);
+
+#endif // PONG_BATCH_H
@@ -0,0 +1,33 @@
+#ifndef PONG_BOT_H
+#define PONG_BOT_H
+
+#include "input.h"
+#include "player.h"
+
+#define BOT_LOOKAHEAD_STEPS 3          // how many future positions each move is checked at
+#define BOT_LOOKAHEAD_STEP_TIME 0.1f   // in seconds between those positions
+#define BOT_SAFE_DISTANCE 60           // in pixels of clearance before a hazard starts to worry us
+#define BOT_WALL_DISTANCE 40           // in pixels, same idea but for the edges of the screen
+#define BOT_OBJECTIVE_WEIGHT 2.0f      // how much a pixel closer to an objective is worth
+#define BOT_PERSISTENCE_BONUS 200.0f   // keeps the bot from dithering between two equal moves
+#define BOT_MAX_HAZARDS 2048           // the rest get ignored, the bot is in trouble anyway
+#define SOAK_TEST_MINUTES 10
+#define SOAK_TEST_BALL_COUNT CROWDED_BALL_COUNT
+
+// one world's bot, its moves + how long it took to pick them
+typedef struct BotWorld {
+    PlayerInput previousMoves[MAX_PLAYERS];
+    int decisionCount;
+    double totalDecisionTime;
+    double maxDecisionTime;
+} BotWorld;
+
+void InitBot();
+// dodges balls, trails + bullets and goes for objectives, reads the world as it is right now
+PlayerInput GetBotInput(int player);
+
+// plays headless bot matches back to back at ballCount balls, reports frame-time spikes,
+// pool exhaustion and memory that outlives a tick, returns 0 if nothing leaked
+int RunSoakTest(int tickCount, int ballCount);
+
+#endif // PONG_BOT_H
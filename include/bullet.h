@@ -0,0 +1,36 @@
+#ifndef PONG_BULLET_H
+#define PONG_BULLET_H
+
+#include <raylib.h>
+#include "hazard.h"
+#include "fixed_math.h"
+
+#define MAX_BULLETS 32768
+#define BULLET_SIZE 6             // in pixels
+#define BULLET_CULL_MARGIN 50     // in pixels past the edge of the play field
+#define BULLET_RENDER_SIDES 8
+
+// one world's bullets, structure-of-arrays. live bullets are always packed into [0, count)
+// so updating is a straight run over memory with no holes to skip
+typedef struct BulletWorld {
+    SimScalar positionX[MAX_BULLETS];
+    SimScalar positionY[MAX_BULLETS];
+    SimScalar velocityX[MAX_BULLETS];
+    SimScalar velocityY[MAX_BULLETS];
+    SimScalar size[MAX_BULLETS];
+    Color color[MAX_BULLETS];
+    int count;
+} BulletWorld;
+
+void InitBullets();
+void UpdateBullets(float deltaTime);
+void RenderBullets();
+
+// reserves up to count contiguous slots, returns how many we actually got
+int ReserveBullets(int count, int *firstIndex);
+void SetBullet(int index, Vector2 position, Vector2 velocity, float size, Color color);
+int GetBulletCount();
+// bullets overlapping area, returns how many were written
+int GatherBulletHazards(Rectangle area, Hazard *hazards, int capacity);
+
+#endif // PONG_BULLET_H
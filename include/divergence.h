@@ -0,0 +1,16 @@
+#ifndef PONG_DIVERGENCE_H
+#define PONG_DIVERGENCE_H
+
+#include "game.h"
+
+#define DIVERGENCE_CHECK_TICKS (SIMULATION_TICK_RATE * 60 * 5)
+#define DIVERGENCE_CHECK_BALL_COUNT 32
+#define DIVERGENCE_SLOWDOWN_TOLERANCE 0.05 // optimized can be this much slower than reference before it fails
+
+// plays the same bot match (same seed, same inputs) in a reference world and an optimized one,
+// a tick each in turn, and compares a hash of the whole world after every tick.
+// reports the first tick + piece of state where they disagree, returns 0 if they never did
+// and the optimized world wasn't slower than the reference one
+int RunDivergenceCheck(int tickCount, int ballCount);
+
+#endif // PONG_DIVERGENCE_H
@@ -0,0 +1,52 @@
+#ifndef PONG_FIELD_H
+#define PONG_FIELD_H
+
+#include <raylib.h>
+#include "game.h"
+
+#define MAX_FIELD_WIDTH 16384           // in pixels, 16.16 fixed point has room for twice this
+#define MAX_FIELD_HEIGHT 16384          // in pixels
+#define FIELD_CHUNK_SIZE 400            // in pixels
+#define MAX_FIELD_CHUNK_COLUMNS ((MAX_FIELD_WIDTH + FIELD_CHUNK_SIZE - 1) / FIELD_CHUNK_SIZE)
+#define MAX_FIELD_CHUNK_ROWS ((MAX_FIELD_HEIGHT + FIELD_CHUNK_SIZE - 1) / FIELD_CHUNK_SIZE)
+#define FIELD_ACTIVE_CHUNK_RADIUS 2     // in chunks around each player, simulated every tick
+#define FIELD_REDUCED_CHUNK_RADIUS 6    // in chunks around each player, simulated every FIELD_REDUCED_TICK_INTERVAL ticks
+#define FIELD_REDUCED_TICK_INTERVAL 4   // anything further than FIELD_REDUCED_CHUNK_RADIUS sleeps
+#define FIELD_CULL_MARGIN 4             // in pixels, anything this close to the view still gets drawn
+
+// how often things in a chunk get simulated, by how close the nearest player is
+typedef enum ChunkActivity {
+    CHUNK_ACTIVE,
+    CHUNK_REDUCED,
+    CHUNK_ASLEEP,
+} ChunkActivity;
+
+// one world's field, and which of its chunks are simulated how often
+typedef struct FieldWorld {
+    int width;
+    int height;
+    unsigned char chunkActivities[MAX_FIELD_CHUNK_ROWS][MAX_FIELD_CHUNK_COLUMNS];
+    int chunkColumns;
+    int chunkRows;
+} FieldWorld;
+
+// the field defaults to the size of the screen, which keeps every chunk active and the camera still.
+// call it before a match starts, every peer in a netplay match has to use the same size
+void SetFieldSize(int width, int height);
+Vector2 GetFieldSize();
+// the screen sized part of the field a camera looking at focus sees, pushed back inside the field at the edges.
+// matches start out looking at the middle of the field
+Rectangle GetViewAround(Vector2 focus);
+Vector2 GetFieldCenter();
+
+// recomputed from where the players are, once per tick before anything that asks
+void UpdateChunkActivity();
+ChunkActivity GetChunkActivity(Vector2 position);
+
+// rendering only looks at what's inside the view, headless runs that never set one see everything
+void SetFieldView(Rectangle view);
+bool IsCircleInView(Vector2 center, float radius);
+bool IsRectangleInView(Rectangle rect);
+Camera2D GetFieldCamera();
+
+#endif // PONG_FIELD_H
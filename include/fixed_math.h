@@ -0,0 +1,95 @@
+#ifndef PONG_FIXED_MATH_H
+#define PONG_FIXED_MATH_H
+
+#include <raylib.h>
+#include <raymath.h>
+
+#define FIXED_FRACTION_BITS 16
+#define FIXED_ONE (1 << FIXED_FRACTION_BITS)
+#define FIXED_TRIG_TABLE_STEPS 256 // per quarter turn for sin, per [0, 1] for atan
+
+// 16.16, a play field a few thousand pixels across still leaves plenty of headroom for speeds.
+// every operation is plain integer math, so it comes out the same on every compiler + cpu
+typedef int Fixed;
+
+typedef struct FixedVector2 {
+    Fixed x;
+    Fixed y;
+} FixedVector2;
+
+// rounds to the nearest step, for constants + things that start out as floats (random draws, input)
+Fixed FixedFromFloat(float value);
+float FixedToFloat(Fixed value);
+FixedVector2 FixedVector2FromVector2(Vector2 vector);
+Vector2 FixedVector2ToVector2(FixedVector2 vector);
+
+// products + quotients round towards negative infinity
+Fixed FixedMultiply(Fixed a, Fixed b);
+Fixed FixedDivide(Fixed a, Fixed b);
+Fixed FixedAbs(Fixed value);
+Fixed FixedClamp(Fixed value, Fixed min, Fixed max);
+Fixed FixedLerp(Fixed start, Fixed end, Fixed amount);
+
+FixedVector2 FixedVector2Zero();
+FixedVector2 FixedVector2Add(FixedVector2 a, FixedVector2 b);
+FixedVector2 FixedVector2Scale(FixedVector2 vector, Fixed scale);
+Fixed FixedVector2Length(FixedVector2 vector);
+FixedVector2 FixedVector2Normalize(FixedVector2 vector); // zero length vectors stay zero, like Vector2Normalize
+FixedVector2 FixedVector2Lerp(FixedVector2 start, FixedVector2 end, Fixed amount);
+FixedVector2 FixedVector2MoveTowards(FixedVector2 vector, FixedVector2 target, Fixed maxDistance);
+
+// in degrees, interpolated off tables instead of going through libm. atan2 is in (-180, 180] like atan2f
+Fixed FixedSinDegrees(Fixed degrees);
+Fixed FixedCosDegrees(Fixed degrees);
+Fixed FixedAtan2Degrees(Fixed y, Fixed x);
+
+// what positions, velocities + sizes in the simulation are stored as. floats by default,
+// 16.16 fixed point when built with PONG_FIXED_POINT. either way everything outside of the
+// simulation (rendering, the bot, collision queries) only ever sees floats
+#ifdef PONG_FIXED_POINT
+typedef Fixed SimScalar;
+typedef FixedVector2 SimVector2;
+#define SIM_FROM_FLOAT(VALUE) FixedFromFloat(VALUE)
+#define SIM_TO_FLOAT(VALUE) FixedToFloat(VALUE)
+#define SimVector2FromVector2 FixedVector2FromVector2
+#define SimVector2ToVector2 FixedVector2ToVector2
+#define SimMultiply FixedMultiply
+#define SimDivide FixedDivide
+#define SimAbs FixedAbs
+#define SimClamp FixedClamp
+#define SimLerp FixedLerp
+#define SimVector2Zero FixedVector2Zero
+#define SimVector2Add FixedVector2Add
+#define SimVector2Scale FixedVector2Scale
+#define SimVector2Normalize FixedVector2Normalize
+#define SimVector2Lerp FixedVector2Lerp
+#define SimVector2MoveTowards FixedVector2MoveTowards
+#define SimScaleAddSpan FixedScaleAddSpan
+#define SimSinDegrees FixedSinDegrees
+#define SimCosDegrees FixedCosDegrees
+#define SimAtan2Degrees FixedAtan2Degrees
+#else
+typedef float SimScalar;
+typedef Vector2 SimVector2;
+#define SIM_FROM_FLOAT(VALUE) (VALUE)
+#define SIM_TO_FLOAT(VALUE) (VALUE)
+#define SimVector2FromVector2(VECTOR) (VECTOR)
+#define SimVector2ToVector2(VECTOR) (VECTOR)
+#define SimMultiply(A, B) ((A) * (B))
+#define SimDivide(A, B) ((A) / (B))
+#define SimAbs fabsf
+#define SimClamp Clamp
+#define SimLerp Lerp
+#define SimVector2Zero Vector2Zero
+#define SimVector2Add Vector2Add
+#define SimVector2Scale Vector2Scale
+#define SimVector2Normalize Vector2Normalize
+#define SimVector2Lerp Vector2Lerp
+#define SimVector2MoveTowards Vector2MoveTowards
+#define SimScaleAddSpan ScaleAddSpan
+#define SimSinDegrees(DEGREES) sinf((DEGREES) * DEG2RAD)
+#define SimCosDegrees(DEGREES) cosf((DEGREES) * DEG2RAD)
+#define SimAtan2Degrees(Y, X) (atan2f(Y, X) * RAD2DEG)
+#endif
+
+#endif // PONG_FIXED_MATH_H
@@ -0,0 +1,31 @@
+#ifndef PONG_FRAME_PACER_H
+#define PONG_FRAME_PACER_H
+
+#include <stdbool.h>
+
+#define FALLBACK_TARGET_FPS 60        // when the monitor won't tell us its refresh rate
+#define IDLE_TARGET_FPS 10            // for screens where nothing moves
+#define MIN_SPIN_TIME 0.0005          // in seconds, always spin at least this close to a deadline
+#define SLEEP_OVERSHOOT_SAMPLES 64    // how many recent sleeps the overshoot estimate remembers
+
+typedef struct FramePacerStats {
+    int frameCount;
+    int missedDeadlineCount;  // frames whose work alone ran past their deadline
+    double worstLateness;     // in seconds, how far past a deadline we actually woke up
+    double totalSleepTime;    // in seconds
+    double totalSpinTime;     // in seconds
+    double sleepOvershoot;    // in seconds, current estimate of how much a short sleep overshoots
+} FramePacerStats;
+
+// targetFps of 0 uses the monitor's refresh rate (FALLBACK_TARGET_FPS without a window),
+// negative doesn't wait at all
+void InitFramePacer(int targetFps);
+// idle frames wait for the next window event when the keyboard drives the local player,
+// otherwise they run at IDLE_TARGET_FPS
+void SetFramePacerIdle(bool isIdle);
+// call right after each frame is drawn, returns once it's time to start the next one
+void WaitForNextFrame();
+FramePacerStats GetFramePacerStats();
+void ReportFramePacerStats();
+
+#endif // PONG_FRAME_PACER_H
@@ -1,15 +1,46 @@
 #ifndef PONG_GAME_H
 #define PONG_GAME_H
 
+#include "input.h"
+
 #define GAME_WIDTH 800
 #define GAME_HEIGHT 600
+#define SIMULATION_TICK_RATE 60                            // in ticks per second
+#define SIMULATION_TICK_TIME (1.0f / SIMULATION_TICK_RATE) // in seconds
+#define MAX_TICKS_PER_FRAME 4 // past this the game slows down instead of spiraling
+#define STARTING_BALL_COUNT 8
 
 typedef enum GameState {
     GAME_STATE_PLAYING,
     GAME_STATE_OVER
 } GameState;
 
+// one world's match state, plus the key to the restart world prepared for it
+typedef struct GameWorld {
+    GameState currentState;
+    int startingBallCount;
+    bool isReferenceSimulation;
+    bool isRestartPrepared;
+    unsigned int restartSnapshotLoadCount;
+    int restartBallCount;
+    int restartPlayerCount;
+    double subsystemStartTime;
+} GameWorld;
+
 void RunGame();
+// advances the world by exactly one tick, inputs has one entry per player
+void SimulateTick(const PlayerInput *inputs);
+void RenderGame();
+// records everything in the world into the render list, without submitting it
+void RecordGameWorld();
 void ChangeGameStateTo(GameState newState);
+GameState GetGameState();
+// takes effect the next time a match starts
+void SetStartingBallCount(int count);
+// swaps every optimized update (span math, bounds-checked trail collision) for its plain scalar
+// version, the oracle the divergence check holds the optimized ones to. span math levels are
+// process wide, so only flip this while a single thread is simulating
+void SetReferenceSimulation(bool isReference);
+bool IsReferenceSimulation();
 
-#endif // PONG_GAME_H
\ No newline at end of file
+#endif // PONG_GAME_H
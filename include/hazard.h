@@ -0,0 +1,14 @@
+#ifndef PONG_HAZARD_H
+#define PONG_HAZARD_H
+
+#include <raylib.h>
+
+// anything that ends the game on touch, as a moving capsule (start == end for circles)
+typedef struct Hazard {
+    Vector2 start;
+    Vector2 end;
+    Vector2 velocity; // in pixels per second
+    float radius;     // in pixels
+} Hazard;
+
+#endif // PONG_HAZARD_H
@@ -0,0 +1,64 @@
+#ifndef PONG_INPUT_H
+#define PONG_INPUT_H
+
+#include <raylib.h>
+#include <stdbool.h>
+
+// everything a player can do in one tick, packed so it's cheap to store + send
+typedef unsigned char PlayerInput;
+
+#define SYNTHETIC_INPUT_PERIOD 0.1234 // in seconds, deliberately out of step with the frame + tick rates
+#define INPUT_SAMPLE_RATE 1000        // in hertz, how often the sampling thread looks at its source
+#define INPUT_EVENT_QUEUE_CAPACITY 256 // power of two
+#define MAX_LATCHED_KEYS 16            // different keys pressed in one frame
+
+typedef enum PlayerInputButton {
+    INPUT_UP = 1 << 0,
+    INPUT_DOWN = 1 << 1,
+    INPUT_LEFT = 1 << 2,
+    INPUT_RIGHT = 1 << 3,
+    INPUT_CONFIRM = 1 << 4,
+} PlayerInputButton;
+
+// one button going down or up, queued until the tick it happened during takes it
+typedef struct InputEvent {
+    double time; // when it changed, as closely as the source can tell
+    PlayerInputButton button;
+    bool isDown;
+} InputEvent;
+
+// where the local player's input comes from
+typedef enum InputSource {
+    INPUT_SOURCE_KEYBOARD,
+    INPUT_SOURCE_BOT,
+    INPUT_SOURCE_SYNTHETIC, // flips between up + down on a fixed schedule on a thread of its own, for headless tests
+} InputSource;
+
+// the synthetic source gets sampled at INPUT_SAMPLE_RATE by a thread, switching away from it stops the thread
+void SetLocalInputSource(InputSource source);
+InputSource GetLocalInputSource();
+void StopInputSampling();
+// keyboard events come from here, raylib only updates key state when the main thread polls the window.
+// call every time it does (once per frame, more while the frame pacer waits), taps that came
+// and went between two polls still make it through
+void PollLocalInput();
+// whether a confirm press is queued and waiting for a tick
+bool HasPressedLocalInput();
+// use instead of IsKeyPressed: a press seen by any poll since the last ClearKeyPresses,
+// taken so only the first caller sees it
+bool TakeKeyPress(int key);
+// whether any key went down that nothing's taken yet
+bool HasLatchedKeyPress();
+// once a frame after game code has looked, so a press nothing wanted doesn't fire later
+void ClearKeyPresses();
+// call once per simulation tick with the time the tick's slice of real time ends at, events after it
+// stay queued for later ticks. a button that went down at any point during the tick counts as held
+// for all of it, so short taps aren't lost. player is who the local input controls
+PlayerInput TakeLocalInput(int player, double tickEndTime);
+// where the slice of real time a tick stands for ends, given the time built up for ticks (this one included).
+// the last tick of a frame takes everything up to now, so input doesn't wait a frame for time nothing's simulated yet
+double GetTickEndTime(double now, double tickAccumulator);
+
+Vector2 GetInputDirection(PlayerInput input);
+
+#endif // PONG_INPUT_H
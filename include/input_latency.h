@@ -0,0 +1,36 @@
+#ifndef PONG_INPUT_LATENCY_H
+#define PONG_INPUT_LATENCY_H
+
+#include <stdbool.h>
+
+#define INPUT_LATENCY_MAX_SAMPLES 1024       // recent samples kept for percentiles + dumps
+#define INPUT_LATENCY_MAX_IN_FLIGHT 16       // sampled changes that haven't been presented yet
+#define INPUT_LATENCY_BUCKET_TIME 0.002      // in seconds, width of each overlay histogram bar
+#define INPUT_LATENCY_BUCKET_COUNT 32        // the last bar collects everything slower
+#define INPUT_LATENCY_DUMP_PATH "input_latency.csv"
+#define INPUT_LATENCY_TEST_SECONDS 10
+
+// one input change, from when it was sampled to the end of the frame that first showed it
+typedef struct InputLatencySample {
+    double sampledToConsumed;   // in seconds, waiting for a tick to run
+    double consumedToPresented; // in seconds, rest of the frame + drawing it
+} InputLatencySample;
+
+void InitInputLatency();
+// sampledTime is when the input actually changed, if the source knows better than "right now"
+void RecordInputSampled(double sampledTime);
+// a tick took the local input
+void RecordInputConsumed();
+// call right after EndDrawing
+void RecordFramePresented();
+
+// F3 toggles the overlay, F4 dumps the recent samples to INPUT_LATENCY_DUMP_PATH
+void HandleInputLatencyKeys();
+void RenderInputLatencyOverlay();
+bool DumpInputLatency(const char *path);
+
+// drives the game headless with synthetic input at targetFps (same meaning as the frame pacer's)
+// for the given number of seconds, then prints a summary and dumps the samples
+int RunInputLatencyTest(int seconds, int targetFps);
+
+#endif // PONG_INPUT_LATENCY_H
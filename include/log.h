@@ -0,0 +1,24 @@
+#ifndef PONG_LOG_H
+#define PONG_LOG_H
+
+#define LOG_RING_RECORDS 256          // per thread, power of two
+#define LOG_MAX_ARGUMENTS 6
+#define MAX_LOG_THREADS 32            // rings aren't given back, threads past this many lose their messages
+#define LOG_RATE_LIMIT_TIME 1.0       // in seconds, the same message gets through at most once per this long
+#define LOG_RATE_LIMIT_SLOTS 32       // per thread, messages are told apart by their format string
+#define LOG_WRITER_SLEEP_TIME 0.01    // in seconds
+#define LOG_LINE_CAPACITY 512         // in bytes
+
+// printf for the hot path. the caller only copies its arguments into a ring of its own,
+// a writer thread does the formatting + writing later. repeats inside LOG_RATE_LIMIT_TIME
+// are only counted, the next one that gets through says how many were skipped.
+// the format has to be a literal and %s arguments have to outlive the message (names, literals),
+// both get read on the writer thread. no trailing newline, every message is one line.
+// before StartLogger (or after StopLogger) messages get written straight away
+void LogMessage(const char *format, ...);
+
+void StartLogger();
+// writes whatever's still waiting
+void StopLogger();
+
+#endif // PONG_LOG_H
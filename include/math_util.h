@@ -4,11 +4,17 @@
 #include <raylib.h>
 #include <raymath.h>
 
+void SeedRandom(unsigned int seed);
+unsigned int RandomUInt();
+int RandomInt(int min, int max); // inclusive
 float RandomFloat();
 Vector2 RandomPointOnUnitCircle();
 Color RandomColor();
 
 Vector2 GetRectPosition(Rectangle rect);
+Rectangle GetSegmentBounds(Vector2 start, Vector2 end, float radius);
+float DistanceSqrPointToSegment(Vector2 point, Vector2 start, Vector2 end);
+bool CheckCollisionCapsuleRec(Vector2 start, Vector2 end, float radius, Rectangle rect);
 
 float SmoothStop2(float t);
 float SmoothStop3(float t);
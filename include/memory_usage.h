@@ -0,0 +1,92 @@
+#ifndef PONG_MEMORY_USAGE_H
+#define PONG_MEMORY_USAGE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MAX_STATIC_MEMORY_REGIONS 64
+#define MEMORY_BUDGET_PATH "memory_budgets.txt" // copied next to the executable with the other assets
+#define MEMORY_CHECK_NETWORK_SECONDS 2            // of loopback netplay, then of spectating
+#define MEMORY_CHECK_SPECTATORS 4
+
+// who the bytes belong to, budgets are set per subsystem
+typedef enum MemoryTag {
+    MEMORY_TAG_BALLS,
+    MEMORY_TAG_PLAYERS,
+    MEMORY_TAG_OBJECTIVES,
+    MEMORY_TAG_PARTICLES,
+    MEMORY_TAG_BULLETS,
+    MEMORY_TAG_PATTERNS,
+    MEMORY_TAG_TIMERS,
+    MEMORY_TAG_SCRATCH,   // frame arenas
+    MEMORY_TAG_SNAPSHOTS, // whole worlds kept around for restarts, saves + checks
+    MEMORY_TAG_REWIND,
+    MEMORY_TAG_NETWORK,   // netplay + spectator buffers
+    MEMORY_TAG_SOUNDS,    // decoded sound effects
+    MEMORY_TAG_MUSIC,
+    MEMORY_TAG_RAYLIB,    // everything raylib allocates itself, sound buffers included. PONG_DEBUG_MEMORY builds only
+    MEMORY_TAG_COUNT,
+} MemoryTag;
+
+typedef struct MemoryUsage {
+    size_t staticBytes;    // registered static arrays + buffers, always there once registered
+    size_t heapBytes;      // currently allocated
+    size_t peakHeapBytes;
+    long long allocationCount; // heap allocations made so far
+} MemoryUsage;
+
+typedef struct StaticMemoryRegion {
+    MemoryTag tag;
+    const char *name;
+    size_t size;
+    size_t elementSize;
+    int capacity;       // 0 for plain regions
+    const int *count;
+    int peakCount;
+} StaticMemoryRegion;
+
+// like the snapshot regions, every world registers its own copies
+typedef struct StaticMemoryRegistry {
+    StaticMemoryRegion regions[MAX_STATIC_MEMORY_REGIONS];
+    int regionCount;
+} StaticMemoryRegistry;
+
+// static memory that belongs to a subsystem. like snapshot regions, registering the same
+// name twice is a no-op so it's safe to do from Init functions, and it's per world
+void RegisterStaticMemory(MemoryTag tag, const char *name, size_t size);
+// same, but also reports how full the array gets: *count out of capacity elements
+void RegisterStaticArrayMemory(MemoryTag tag, const char *name, size_t elementSize, int capacity, const int *count);
+// remembers the fullest each registered array has been, once per tick is plenty
+void SampleStaticArrayOccupancy();
+
+// memory from somewhere we don't own (raylib), safe from any thread
+void TrackHeapAllocation(MemoryTag tag, size_t size);
+void TrackHeapRelease(MemoryTag tag, size_t size);
+
+MemoryUsage GetMemoryUsage(MemoryTag tag);
+const char *GetMemoryTagName(MemoryTag tag);
+// per subsystem bytes + allocations, then how full every registered array and pool got
+void ReportMemoryUsage();
+// budget file lines are "<subsystem> <bytes>", # starts a comment. a subsystem whose static bytes
+// plus peak heap bytes go past its budget fails the check, and so does one with a budget that
+// measured nothing at all. ones without a budget are unlimited
+bool CheckMemoryBudgets(const char *path);
+
+// the training workload with the rewind buffers set up like the windowed game has them, a bit
+// of loopback netplay + spectating, sounds and music (any tracks given), then the usage report.
+// returns 0 if every subsystem stayed within its budget
+int RunMemoryCheck(const char *budgetPath, int phaseTicks, const char **musicPaths, int musicCount);
+
+#ifdef PONG_DEBUG_MEMORY
+// raylib gets built with its RL_MALLOC family pointed at these (see CMakeLists.txt)
+void *TrackedRaylibMalloc(size_t size);
+void *TrackedRaylibCalloc(size_t count, size_t size);
+void *TrackedRaylibRealloc(void *memory, size_t size);
+void TrackedRaylibFree(void *memory);
+#endif
+
+#define REGISTER_STATIC_MEMORY(TAG, VARIABLE) RegisterStaticMemory(TAG, #VARIABLE, sizeof(VARIABLE))
+#define REGISTER_STATIC_ARRAY_MEMORY(TAG, ARRAY, COUNT) \
+    RegisterStaticArrayMemory(TAG, #ARRAY, sizeof((ARRAY)[0]), (int) (sizeof(ARRAY) / sizeof((ARRAY)[0])), &(COUNT))
+
+#endif // PONG_MEMORY_USAGE_H
@@ -0,0 +1,51 @@
+#ifndef PONG_METRICS_H
+#define PONG_METRICS_H
+
+#include <stdbool.h>
+
+#define MAX_METRICS 64
+#define METRICS_DEFAULT_PORT 9464
+#define METRICS_HISTOGRAM_BUCKET_COUNT 12
+#define METRICS_RESPONSE_CAPACITY (32 * 1024) // in bytes
+
+typedef enum MetricType {
+    METRIC_TYPE_COUNTER,
+    METRIC_TYPE_GAUGE,
+    METRIC_TYPE_HISTOGRAM,
+} MetricType;
+
+// owned by whoever records into it (usually a static in the module), the registry just points at it
+typedef struct Metric {
+    const char *name;
+    const char *help;
+    const char *labels; // optional, prometheus style e.g. subsystem="balls"
+    MetricType type;
+    double value;       // running total for counters + histograms, latest for gauges
+    // histograms only, every histogram measures a duration in seconds
+    unsigned long long observationCount;
+    unsigned long long bucketCounts[METRICS_HISTOGRAM_BUCKET_COUNT];
+} Metric;
+
+// safe to call every Init, re-registering keeps the values collected so far
+void RegisterCounter(Metric *metric, const char *name, const char *help);
+void RegisterGauge(Metric *metric, const char *name, const char *help);
+void RegisterHistogram(Metric *metric, const char *name, const char *labels, const char *help);
+
+// cheap enough for the hot path, no locks, no allocation
+void AddToCounter(Metric *metric, double amount);
+void SetGauge(Metric *metric, double value);
+void ObserveHistogram(Metric *metric, double seconds);
+// re-simulated ticks already happened once, so rollback mutes recording while it replays them.
+// part of the world, batch workers simulating worlds of their own mute theirs
+// (metrics have to be registered from the main thread before they start)
+void SetMetricsMuted(bool isMuted);
+
+// serves the registry (plus arena + pool usage) as prometheus text on http://127.0.0.1:port/metrics
+bool StartMetricsServer(unsigned short port);
+void StopMetricsServer();
+// answers any waiting scrape, call once per frame
+void PollMetricsServer();
+// returns the number of bytes written
+int FormatMetrics(char *buffer, int capacity);
+
+#endif // PONG_METRICS_H
@@ -0,0 +1,22 @@
+#ifndef PONG_MUSIC_H
+#define PONG_MUSIC_H
+
+#include <stdbool.h>
+
+#define MUSIC_SAMPLE_RATE 44100           // in hertz, tracks at any other rate get skipped
+#define MUSIC_CHANNELS 2                  // mono tracks get copied to both sides
+#define MUSIC_RING_FRAMES 8192            // decoded audio waiting for the device, about 190 ms. power of two
+#define MUSIC_DECODE_FRAMES 1024          // how much the worker decodes + mixes in one go
+#define MUSIC_DEVICE_BUFFER_FRAMES 1024   // how much the audio device asks for at a time
+#define MUSIC_CROSSFADE_TIME 3.0f         // in seconds
+#define MUSIC_WORKER_SLEEP_TIME 0.005     // in seconds, how long the worker waits while the ring is full
+#define MUSIC_VOLUME 0.6f
+#define MAX_MUSIC_TRACKS 16
+
+// streams tracks (.ogg or .qoa) one after another, crossfading into the next as each one ends
+// and going back to the first after the last. decoding happens on a worker thread, so the game
+// thread never pays for it. needs the audio device, paths have to stay valid until StopMusic
+bool StartMusic(const char **paths, int count);
+void StopMusic();
+
+#endif // PONG_MUSIC_H
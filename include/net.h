@@ -0,0 +1,86 @@
+#ifndef PONG_NET_H
+#define PONG_NET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAX_PACKET_SIZE 512           // in bytes, keep under a typical MTU
+#define MAX_SIMULATED_PACKETS 256     // in flight per simulated channel
+
+// IPv4 address + port, both in host byte order
+typedef struct NetAddress {
+    unsigned int host;
+    unsigned short port;
+} NetAddress;
+
+// one direction of a fake network, packets come out after a delay (or not at all)
+typedef struct SimulatedPacket {
+    double deliveryTime;
+    int size;
+    unsigned char data[MAX_PACKET_SIZE];
+} SimulatedPacket;
+
+typedef struct SimulatedChannel {
+    double now;         // in seconds, advanced by whoever drives the test
+    float latency;      // in seconds, one way
+    float jitter;       // in seconds, random extra delay on top of latency
+    float lossPercent;
+    unsigned int randomState;
+    SimulatedPacket packets[MAX_SIMULATED_PACKETS];
+    int packetCount;
+    int sentCount;
+    int droppedCount;
+} SimulatedChannel;
+
+typedef enum NetLinkType {
+    NET_LINK_UDP,
+    NET_LINK_SIMULATED,
+} NetLinkType;
+
+// where a rollback session sends + receives its packets
+typedef struct NetLink {
+    NetLinkType type;
+    union {
+        struct {
+            intptr_t socket;
+            NetAddress peer;
+            bool hasPeer;
+        } udp;
+        struct {
+            SimulatedChannel *outgoing;
+            SimulatedChannel *incoming;
+        } simulated;
+    };
+} NetLink;
+
+bool InitNet();
+void CloseNet();
+
+// non-blocking, pass port 0 to let the OS pick one
+bool OpenUdpSocket(unsigned short port, intptr_t *socket);
+void CloseUdpSocket(intptr_t socket);
+bool ResolveNetAddress(const char *host, unsigned short port, NetAddress *address);
+bool SendUdp(intptr_t socket, NetAddress to, const void *data, int size);
+// returns the packet size, or -1 if nothing is waiting
+int ReceiveUdp(intptr_t socket, NetAddress *from, void *buffer, int capacity);
+
+// non-blocking, only accepts connections from this machine unless it's lan visible
+bool OpenTcpListener(unsigned short port, bool isLanVisible, intptr_t *socket);
+// returns false if nobody is waiting to connect
+bool AcceptTcpConnection(intptr_t listener, intptr_t *socket);
+// returns the number of bytes read, 0 if the other side hung up, or -1 if nothing is waiting
+int ReceiveTcp(intptr_t socket, void *buffer, int capacity);
+bool SendTcp(intptr_t socket, const void *data, int size);
+// returns how many bytes went out, 0 if the socket's buffer is full, or -1 if the other side is gone
+int SendTcpPartial(intptr_t socket, const void *data, int size);
+// blocks until connected, the socket is non-blocking from then on
+bool ConnectTcp(NetAddress address, intptr_t *socket);
+void CloseTcpSocket(intptr_t socket);
+
+void InitSimulatedChannel(SimulatedChannel *channel, float latency, float jitter, float lossPercent, unsigned int seed);
+
+bool SendOverLink(NetLink *link, const void *data, int size);
+// returns the packet size, or -1 if nothing is waiting
+int ReceiveFromLink(NetLink *link, void *buffer, int capacity);
+
+#endif // PONG_NET_H
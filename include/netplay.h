@@ -0,0 +1,24 @@
+#ifndef PONG_NETPLAY_H
+#define PONG_NETPLAY_H
+
+#include <stdbool.h>
+
+#define NETPLAY_DEFAULT_PORT 7777
+#define LOOPBACK_TEST_TICKS (60 * 60 * 2) // two minutes of play
+#define LOOPBACK_TEST_LATENCY 0.1f         // in seconds, one way
+#define LOOPBACK_TEST_LOSS 5.0f            // in percent
+
+bool StartNetplayHost(unsigned short port);
+bool StartNetplayJoin(const char *host, unsigned short port);
+void StopNetplay();
+bool IsNetplayActive();
+// whoever this machine is playing as, the first player outside of netplay
+int GetLocalPlayer();
+void UpdateNetplay(float frameTime);
+void RenderNetplayStatus();
+
+// plays a headless two player match against itself over a fake lossy network,
+// returns 0 if both sides stayed in sync
+int RunLoopbackTest(int tickCount, float latency, float lossPercent);
+
+#endif // PONG_NETPLAY_H
@@ -1,17 +1,38 @@
 #ifndef PONG_OBJECTIVE_H
 #define PONG_OBJECTIVE_H
 
-extern int gCollectedObjectives;
-extern int gHighScoreObjectives;
+#include <raylib.h>
+#include "timer_wheel.h"
+
+#define OBJECTIVE_GROUP_SIZE 3
 
 typedef enum ObjectiveState {
     OBJECTIVE_STATE_ACTIVE,
     OBJECTIVE_STATE_DELAYED
 } ObjectiveState;
 
+typedef struct Objective {
+    Vector2 position;
+    float size;
+    bool isCollected;
+} Objective;
+
+// one world's objectives + score
+typedef struct ObjectiveWorld {
+    Objective instances[OBJECTIVE_GROUP_SIZE];
+    TimerId timer;
+    ObjectiveState currentState;
+    int collectedCount;
+    int highScore;
+} ObjectiveWorld;
+
 void InitObjectives();
 void ChangeObjectiveStateTo(ObjectiveState state);
 void UpdateObjectives(float deltaTime);
 void RenderObjectives();
+// drawn straight away, text isn't part of the render list
+void RenderScore();
+// returns false if there's nothing to collect right now
+bool GetNearestObjective(Vector2 position, Vector2 *result);
 
 #endif // PONG_OBJECTIVE_H
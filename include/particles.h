@@ -2,7 +2,31 @@
 #define PONG_PARTICLES_H
 
 #include <raylib.h>
+#include "arena.h"
 
+#define MAX_PARTICLES 100
+#define MAX_PARTICLE_BURSTS 10
+
+typedef struct ParticleInstance {
+    Vector2 position;
+    Vector2 velocity;
+} ParticleInstance;
+
+typedef struct ParticleBurstInstance {
+    ParticleInstance particles[MAX_PARTICLES];
+    int particleCount;
+    Color color;
+    int startTick;
+} ParticleBurstInstance;
+
+typedef struct ParticleWorld {
+    DECLARE_STATIC_POOL(burstPool, ParticleBurstInstance, MAX_PARTICLE_BURSTS);
+    // pool indices of the bursts currently playing, kept dense for iteration
+    int activeBursts[MAX_PARTICLE_BURSTS];
+    int activeBurstCount;
+} ParticleWorld;
+
+void InitParticles();
 void PlayParticleBurst(Vector2 position, Color color, int amount);
 void UpdateParticles(float deltaTime);
 void RenderParticles();
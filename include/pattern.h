@@ -0,0 +1,90 @@
+#ifndef PONG_PATTERN_H
+#define PONG_PATTERN_H
+
+#include <raylib.h>
+
+#define MAX_EMITTERS 16
+#define MAX_PATTERN_INSTRUCTIONS 64
+#define MAX_PATTERN_LOOP_DEPTH 4
+#define MAX_PATTERN_STEPS_PER_TICK 256 // stops a pattern with no waits from hanging the game
+#define PATTERN_DEFAULT_SPEED 150      // in pixels per second
+
+typedef enum PatternId {
+    PATTERN_SPIRAL,
+    PATTERN_RING_BURST,
+    PATTERN_AIMED_FAN,
+    PATTERN_FLOWER,
+    PATTERN_COUNT
+} PatternId;
+
+typedef enum PatternOp {
+    PATTERN_OP_HALT,
+    PATTERN_OP_RING,   // count bullets evenly around the emitter's angle
+    PATTERN_OP_AIMED,  // count bullets fanned out across spread degrees, centered on the player
+    PATTERN_OP_ROTATE, // turn the emitter
+    PATTERN_OP_WAIT,
+    PATTERN_OP_REPEAT, // count = 0 repeats forever
+    PATTERN_OP_END,    // closes the innermost repeat
+    PATTERN_OP_COLOR,
+    PATTERN_OP_SIZE,
+} PatternOp;
+
+// 12 bytes, a whole boss phase fits in a couple of cache lines
+typedef struct PatternInstruction {
+    unsigned char op;
+    unsigned short count;
+    union {
+        struct {
+            float speed;  // in pixels per second
+            float spread; // in degrees
+        } shot;
+        float degrees;
+        float seconds;
+        float size;
+        Color color;
+        int repeatStart; // instruction index just past the matching REPEAT
+    };
+} PatternInstruction;
+
+typedef struct PatternProgram {
+    const char *name;
+    PatternInstruction instructions[MAX_PATTERN_INSTRUCTIONS];
+    int instructionCount;
+} PatternProgram;
+
+typedef struct Emitter {
+    bool isActive;
+    PatternId pattern;
+    int programCounter;
+    float waitTime;
+    float angle; // in degrees
+    Vector2 position;
+    Color color;
+    float bulletSize;
+    int loopsRemaining[MAX_PATTERN_LOOP_DEPTH]; // -1 loops forever
+    int loopDepth;
+} Emitter;
+
+// one world's emitters, the compiled programs they run are shared by every world
+typedef struct PatternWorld {
+    Emitter emitters[MAX_EMITTERS];
+    int nextBossStage;
+} PatternWorld;
+
+// compiles a pattern script, one command per line:
+//   ring <count> <speed>
+//   aimed <count> <spread degrees> <speed>
+//   rotate <degrees>
+//   wait <seconds>
+//   repeat <count> ... end     (repeat 0 loops forever)
+//   color <r> <g> <b>
+//   size <pixels>
+bool CompilePattern(const char *name, const char *source, PatternProgram *program);
+
+void LoadPatterns();
+void InitPatterns();
+void UpdatePatterns(float deltaTime);
+int StartEmitter(PatternId pattern, Vector2 position);
+void StopEmitter(int emitter);
+
+#endif // PONG_PATTERN_H
@@ -0,0 +1,34 @@
+#ifndef PONG_PLATFORM_H
+#define PONG_PLATFORM_H
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+typedef void *ThreadHandle;
+#else
+#include <pthread.h>
+typedef pthread_t ThreadHandle;
+#endif
+
+// for the little that really is per thread: which world it simulates, its log ring
+#define THREAD_LOCAL _Thread_local
+
+typedef void (*ThreadFunction)(void *userData);
+
+typedef struct Thread {
+    ThreadHandle handle;
+    ThreadFunction function;
+    void *userData;
+} Thread;
+
+// high resolution clock that works before (or without) a window, in seconds
+double GetMonotonicTime();
+// only as precise as the OS scheduler, expect to oversleep by up to a millisecond or so
+void SleepSeconds(double seconds);
+
+// thread has to stay alive (not move) until it's joined
+bool StartThread(Thread *thread, ThreadFunction function, void *userData);
+void JoinThread(Thread *thread);
+int GetProcessorCount();
+
+#endif // PONG_PLATFORM_H
@@ -2,19 +2,38 @@
 #define PONG_PLAYER_H
 
 #include <raymath.h>
+#include "input.h"
+#include "fixed_math.h"
 
+#define MAX_PLAYERS 2
 #define PLAYER_WIDTH 25           // in pixels
 #define PLAYER_HEIGHT 28          // in pixels
 #define PLAYER_SPEED 500          // in pixels per second
 #define PLAYER_ACCELERATION 4000  // in pixels per second per second
 #define PLAYER_DECELERATION 15   // in weird lerp units LOL
 #define PLAYER_SQUISH_AMOUNT 0.4f // in percent size
+#define PLAYER_SPAWN_SPACING 80   // in pixels between players
 
-extern Vector2 gPlayerPosition;
+typedef struct PlayerInstance {
+    SimVector2 position;
+    SimVector2 velocity;
+    SimVector2 size;
+} PlayerInstance;
 
-void InitPlayer();
-void UpdatePlayer(float deltaTime);
-void RenderPlayer();
-Rectangle GetPlayerRect();
+// one world's players, only the first count are playing
+typedef struct PlayerWorld {
+    PlayerInstance instances[MAX_PLAYERS];
+    int count;
+} PlayerWorld;
 
-#endif // PONG_PLAYER_H
\ No newline at end of file
+void SetPlayerCount(int count);
+void InitPlayers();
+void UpdatePlayer(int player, PlayerInput input, float deltaTime);
+void RenderPlayers();
+Vector2 GetPlayerPosition(int player);
+Rectangle GetPlayerRect(int player);
+Vector2 GetNearestPlayerPosition(Vector2 position);
+// returns the first player overlapping the circle, or -1
+int FindPlayerTouchingCircle(Vector2 center, float radius);
+
+#endif // PONG_PLAYER_H
@@ -0,0 +1,103 @@
+#ifndef PONG_RENDER_LIST_H
+#define PONG_RENDER_LIST_H
+
+#include <raylib.h>
+#include "bullet.h"
+
+#define MAX_RENDER_COMMANDS (MAX_BULLETS + 8192) // every bullet, plus room for everything else
+#define RENDER_BENCHMARK_FRAMES 3600
+
+// drawn bottom to top, anything inside a layer is free to be reordered
+typedef enum RenderLayer {
+    RENDER_LAYER_BACKGROUND, // objectives, particles, trails
+    RENDER_LAYER_HAZARDS,    // balls, bounce effects, bullets
+    RENDER_LAYER_PLAYERS,
+    RENDER_LAYER_COUNT,
+} RenderLayer;
+
+typedef enum RenderBlend {
+    RENDER_BLEND_ALPHA,
+    RENDER_BLEND_ADDITIVE,
+    RENDER_BLEND_COUNT,
+} RenderBlend;
+
+typedef enum RenderPrimitive {
+    RENDER_PRIMITIVE_TRIANGLE,
+    RENDER_PRIMITIVE_RECTANGLE,
+    RENDER_PRIMITIVE_CIRCLE,
+    RENDER_PRIMITIVE_RING,
+    RENDER_PRIMITIVE_LINE,
+    RENDER_PRIMITIVE_POLY,
+    RENDER_PRIMITIVE_COUNT,
+} RenderPrimitive;
+
+// the rlgl mode raylib draws a primitive with. its vertex buffer only gets flushed (a draw call)
+// when this, the blend mode or the texture changes, and the shapes we use all share a texture
+typedef enum RenderDrawMode {
+    RENDER_DRAW_MODE_LINES,
+    RENDER_DRAW_MODE_TRIANGLES,
+    RENDER_DRAW_MODE_QUADS,
+    RENDER_DRAW_MODE_COUNT,
+} RenderDrawMode;
+
+typedef struct RenderCommand {
+    unsigned char layer;
+    unsigned char blend;
+    unsigned char primitive;
+    Color color;
+    union {
+        struct { Vector2 a, b, c; } triangle; // counter clockwise, like raylib wants
+        struct { Vector2 position, size; } rectangle;
+        struct { Vector2 center; float radius; } circle;
+        struct { Vector2 center; float innerRadius, outerRadius; } ring;
+        struct { Vector2 start, end; float thickness; } line;
+        struct { Vector2 center; float radius; int sides; } poly;
+    };
+} RenderCommand;
+
+// a run of commands that share all of their gpu state, a backend can draw it in one go.
+// primitives can be mixed in it, in the order they were recorded
+typedef struct RenderBatch {
+    RenderLayer layer;
+    RenderBlend blend;
+    RenderDrawMode drawMode;
+    const RenderCommand *commands;
+    int commandCount;
+} RenderBatch;
+
+typedef struct RenderBackend {
+    const char *name;
+    void (*SubmitBatch)(const RenderBatch *batch);
+} RenderBackend;
+
+typedef struct RenderListStats {
+    int commandCount;
+    int batchCount;         // blend + draw mode changes, i.e. raylib draw calls
+    int unsortedBatchCount; // how many drawing in recorded order would have taken
+    int droppedCount;       // recorded past MAX_RENDER_COMMANDS
+} RenderListStats;
+
+extern const RenderBackend gRaylibRenderBackend;
+// draws nothing, just counts + checksums what it's given so submission can run without a gpu
+extern const RenderBackend gRecordingRenderBackend;
+
+// applies to everything recorded after it, until the list is submitted
+void SetRenderBlend(RenderBlend blend);
+void RecordTriangle(RenderLayer layer, Vector2 a, Vector2 b, Vector2 c, Color color);
+void RecordRectangle(RenderLayer layer, Vector2 position, Vector2 size, Color color);
+void RecordCircle(RenderLayer layer, Vector2 center, float radius, Color color);
+void RecordRing(RenderLayer layer, Vector2 center, float innerRadius, float outerRadius, Color color);
+void RecordLine(RenderLayer layer, Vector2 start, Vector2 end, float thickness, Color color);
+void RecordPoly(RenderLayer layer, Vector2 center, int sides, float radius, Color color);
+
+// sorts everything recorded this frame by layer, blend + draw mode, hands it to the backend
+// one batch per combination, then empties the list
+void SubmitRenderList(const RenderBackend *backend);
+RenderListStats GetRenderListStats();
+unsigned int GetRecordingBackendChecksum();
+
+// records + submits frames of a bot match to the recording backend and reports how it went,
+// then the same for frames that switch primitive + blend every command
+int RunRenderBenchmark(int frameCount);
+
+#endif // PONG_RENDER_LIST_H
@@ -0,0 +1,30 @@
+#ifndef PONG_REWIND_H
+#define PONG_REWIND_H
+
+#include <stdbool.h>
+#include "game.h"
+
+#define REWIND_MEMORY_BUDGET (8 * 1024 * 1024)              // in bytes, keyframes + deltas together
+#define REWIND_GROUP_COUNT 8                                // keyframe groups, the oldest is overwritten first
+#define REWIND_GROUP_CAPACITY (REWIND_MEMORY_BUDGET / REWIND_GROUP_COUNT)
+#define REWIND_KEYFRAME_INTERVAL SIMULATION_TICK_RATE       // in ticks, also the most deltas a seek has to apply
+#define REWIND_INSTANT_SECONDS 5
+
+// the last few seconds of world state, so the game can be stepped back through (death frames)
+// or rewound and played on from there. each group is a full snapshot (keyframe) followed by
+// one delta per tick holding only the blocks that changed since the tick before.
+// a group that runs out of room starts the next one early, so under load the history gets
+// shorter instead of the memory getting bigger. main thread only, the buffers are shared
+void InitRewind();
+// forgets everything, for when the world gets replaced (restarts, quick loads)
+void ResetRewind();
+// call after every simulated tick, saves the world as it is now as the newest tick
+void RecordRewindTick();
+int GetOldestRewindTick();
+int GetNewestRewindTick(); // -1 if nothing's been recorded
+// loads the world as it was at the end of a recorded tick, applying at most REWIND_KEYFRAME_INTERVAL - 1 deltas
+bool SeekRewind(int tick);
+// forgets every tick after this one, so recording can carry on from a world that was seeked to
+void TruncateRewind(int tick);
+
+#endif // PONG_REWIND_H
@@ -0,0 +1,62 @@
+#ifndef PONG_ROLLBACK_H
+#define PONG_ROLLBACK_H
+
+#include <stddef.h>
+#include "input.h"
+#include "net.h"
+#include "player.h"
+#include "snapshot.h"
+
+#define ROLLBACK_MAX_TICKS 10            // furthest we predict past the last remote input we've heard
+#define ROLLBACK_SNAPSHOT_SLOTS (ROLLBACK_MAX_TICKS + 1)
+#define ROLLBACK_INPUT_DELAY 2           // in ticks, hides a little latency without rolling back at all
+#define ROLLBACK_INPUT_HISTORY 128       // in ticks
+#define ROLLBACK_REDUNDANT_INPUTS 32     // unacked inputs are resent this far back to ride out packet loss
+#define ROLLBACK_TIME_SYNC_THRESHOLD 2   // in ticks of lead over the peer before we ease off
+#define ROLLBACK_TIME_SYNC_INTERVAL 20   // in ticks between skipped ticks
+#define ROLLBACK_PACKET_MAGIC 0x504F4E47 // "PONG"
+
+typedef struct RollbackSession {
+    NetLink *link;
+    int localPlayer;
+    int remotePlayer;
+    unsigned int seed;
+    bool isConnected;
+
+    int currentTick; // the next tick to simulate
+    PlayerInput inputs[MAX_PLAYERS][ROLLBACK_INPUT_HISTORY];
+    int confirmedTicks[MAX_PLAYERS];   // newest tick with a known (not predicted) input
+    int firstMispredictedTick;         // -1 if every prediction so far held up
+    int remoteAckTick;                 // newest local input the peer told us it has
+    int remoteTick;                    // the peer's currentTick when it last sent
+    int remoteAdvantage;               // how far the peer thinks it's ahead of us
+    int lastTimeSyncTick;
+
+    // world state before each of the last few ticks
+    unsigned char snapshots[ROLLBACK_SNAPSHOT_SLOTS][WORLD_SNAPSHOT_CAPACITY];
+    size_t snapshotSizes[ROLLBACK_SNAPSHOT_SLOTS];
+    int snapshotTicks[ROLLBACK_SNAPSHOT_SLOTS];
+
+    // hashes of world states both sides agree are final, swapped to catch desyncs
+    unsigned int checksums[ROLLBACK_INPUT_HISTORY];
+    int checksumTicks[ROLLBACK_INPUT_HISTORY];
+    int lastChecksumTick;
+    int desyncTick; // -1 while in sync
+
+    // stats
+    int rollbackCount;
+    int resimulatedTickCount;
+    int maxRollbackTicks;
+    double maxRollbackTime;   // in seconds
+    double totalRollbackTime; // in seconds
+    int stallCount;
+    int timeSyncSkipCount;
+    int verifiedChecksumCount;
+} RollbackSession;
+
+// the host (player 0) picks the seed, the client learns it when it connects
+void InitRollbackSession(RollbackSession *session, NetLink *link, int localPlayer, unsigned int seed);
+// call once per tick's worth of time, simulates at most one new tick (plus any re-simulation)
+void AdvanceRollbackSession(RollbackSession *session, PlayerInput localInput);
+
+#endif // PONG_ROLLBACK_H
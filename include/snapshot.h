@@ -0,0 +1,85 @@
+#ifndef PONG_SNAPSHOT_H
+#define PONG_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "arena.h"
+
+#define MAX_SNAPSHOT_REGIONS 48
+#define WORLD_SNAPSHOT_CAPACITY (1024 * 1024) // in bytes, holds a world with every bullet alive
+#define SNAPSHOT_MAGIC 0x56415350             // "PSAV"
+#define SNAPSHOT_VERSION 1                    // bump when saved state changes meaning without changing size
+#define SNAPSHOT_DELTA_BLOCK 32               // in bytes, deltas compare worlds a block at a time
+
+// fixed point values are the same size as floats, so the layout hash can't tell the two builds apart
+#ifdef PONG_FIXED_POINT
+#define SNAPSHOT_FLAVOR 0x80000000u
+#else
+#define SNAPSHOT_FLAVOR 0u
+#endif
+
+// every snapshot starts with this, followed by each region's bytes back to back
+typedef struct SnapshotHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int layoutHash; // which regions were registered, in what order, and how big they were
+    unsigned int size;       // in bytes, header included
+} SnapshotHeader;
+
+// where two snapshots first disagree
+typedef struct SnapshotDifference {
+    const char *regionName;
+    int element;   // for arrays + pools, -1 for plain regions or when the two arrays have different counts
+    size_t offset; // in bytes, into the element (or region)
+} SnapshotDifference;
+
+typedef struct SnapshotRegion {
+    const char *name;
+    unsigned char *data;
+    size_t size;        // whole region, or one element for arrays
+    int capacity;       // in elements, for arrays
+    int *count;         // NULL for plain regions
+    size_t elementSize; // arrays + pools, only used to say which element two snapshots disagree on
+} SnapshotRegion;
+
+// regions point into a world, so every world has its own registry
+typedef struct SnapshotRegistry {
+    SnapshotRegion regions[MAX_SNAPSHOT_REGIONS];
+    int regionCount;
+    unsigned int layoutHash; // changes whenever the set of registered regions does, so stale snapshots get rejected
+    unsigned int loadCount;
+} SnapshotRegistry;
+
+// every piece of simulation state registers itself here, so the whole world
+// can be copied out + back in (rollback, save states) without knowing its layout.
+// registering the same memory twice is a no-op, so it's safe to do from Init functions.
+void RegisterSnapshotRegion(const char *name, void *data, size_t size);
+// only the first *count elements are saved, and *count is restored on load
+void RegisterSnapshotArray(const char *name, void *data, size_t elementSize, int capacity, int *count);
+// a pool's elements plus its free list, but not its (process specific) pointers
+void RegisterSnapshotPool(Pool *pool);
+
+// returns the number of bytes written, or 0 if buffer is too small
+size_t SaveSnapshot(void *buffer, size_t capacity);
+// the world is left untouched if the snapshot is bad or from a different build
+bool LoadSnapshot(const void *buffer, size_t size);
+unsigned int HashSnapshot(const void *buffer, size_t size);
+// only the blocks of current that differ from previous, returns the delta's size or 0 if it doesn't fit
+size_t EncodeSnapshotDelta(void *buffer, size_t capacity, const void *previous, size_t previousSize,
+                           const void *current, size_t currentSize);
+// turns the snapshot the delta was made against into the one after it, in place.
+// returns the new snapshot's size, or 0 if the delta is malformed or wouldn't fit in capacity
+size_t ApplySnapshotDelta(void *snapshot, size_t capacity, const void *delta, size_t deltaSize);
+// both have to be snapshots of the current layout (i.e. saved from this world), returns false if they match
+bool FindSnapshotDifference(const void *first, const void *second, SnapshotDifference *difference);
+// goes up every time a load succeeds, so anything derived from the world can tell it was swapped out
+unsigned int GetSnapshotLoadCount();
+
+bool SaveSnapshotToFile(const char *path);
+bool LoadSnapshotFromFile(const char *path);
+
+#define REGISTER_SNAPSHOT_VARIABLE(VARIABLE) RegisterSnapshotRegion(#VARIABLE, &(VARIABLE), sizeof(VARIABLE))
+#define REGISTER_SNAPSHOT_ARRAY(ARRAY, COUNT) \
+    RegisterSnapshotArray(#ARRAY, (ARRAY), sizeof((ARRAY)[0]), (int) (sizeof(ARRAY) / sizeof((ARRAY)[0])), &(COUNT))
+
+#endif // PONG_SNAPSHOT_H
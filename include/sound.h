@@ -1,10 +1,26 @@
 #ifndef PONG_SOUND_H
 #define PONG_SOUND_H
 
-extern Sound gBallHitSound;
-extern Sound gRestartSound;
-extern Sound gObjectiveCollectSound;
+#include <stdbool.h>
 
+#define SOUND_QUEUE_TRIGGERS 64          // waiting for the audio thread, power of two
+#define SOUND_THREAD_SLEEP_TIME 0.001    // in seconds, how long the audio thread waits while the queue is empty
+
+typedef enum GameSound {
+    GAME_SOUND_BALL_HIT,
+    GAME_SOUND_RESTART,
+    GAME_SOUND_OBJECTIVE_COLLECT,
+    GAME_SOUND_COUNT,
+} GameSound;
+
+// loads every sound and starts the audio thread, which owns all playback from then on. needs the audio device
 void LoadSounds();
+// before CloseAudioDevice
+void UnloadSounds();
+// simulation code plays sounds through here so re-simulated ticks stay quiet.
+// only queues a trigger for the audio thread, so it never waits on the audio backend.
+// the queue has one producer, so only one thread at a time can have sounds unmuted
+void PlayGameSound(GameSound sound);
+void SetSoundsMuted(bool isMuted);
 
 #endif // PONG_SOUND_H
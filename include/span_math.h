@@ -0,0 +1,52 @@
+#ifndef PONG_SPAN_MATH_H
+#define PONG_SPAN_MATH_H
+
+#include <stdbool.h>
+#include "fixed_math.h"
+
+#define SPAN_MATH_CHECK_COUNT 4099 // not a multiple of any vector width, so the tails get checked too
+#define SPAN_MATH_CHECK_ROUNDS 200
+
+// slowest to fastest, a cpu that supports a level supports everything before it too
+typedef enum SpanMathLevel {
+    SPAN_MATH_SCALAR,
+    SPAN_MATH_SSE2,
+    SPAN_MATH_AVX2,
+    SPAN_MATH_AVX512,
+    SPAN_MATH_LEVEL_COUNT,
+} SpanMathLevel;
+
+typedef enum Easing {
+    EASING_SMOOTH_STOP2,
+    EASING_SMOOTH_STOP3,
+    EASING_SMOOTH_STOP4,
+    EASING_SMOOTH_START2,
+    EASING_SMOOTH_START3,
+    EASING_SMOOTH_START4,
+} Easing;
+
+// picks the fastest level this cpu (and os) supports, call once before any threads start.
+// until then everything runs the scalar path
+void InitSpanMath();
+SpanMathLevel GetSpanMathLevel();
+SpanMathLevel GetSupportedSpanMathLevel();
+// returns false if the cpu can't do it
+bool SetSpanMathLevel(SpanMathLevel level);
+const char *GetSpanMathLevelName(SpanMathLevel level);
+
+// the same operations as the scalar helpers + raymath, over arrays of floats (x + y in separate arrays for vectors).
+// every level does the exact same ieee operations in the same order, no fma or reciprocal estimates,
+// so results match the scalar path bit for bit and the simulation stays deterministic on any cpu.
+// spans can't overlap, except result with the array it's computed from
+void ScaleAddSpan(float *result, const float *values, float scale, int count); // result += values * scale
+void FixedScaleAddSpan(Fixed *result, const Fixed *values, Fixed scale, int count); // same, with FixedMultiply
+void LerpSpan(float *result, const float *from, const float *to, float amount, int count);
+void NormalizeSpan(float *x, float *y, int count); // zero length vectors stay zero, like Vector2Normalize
+void EaseSpan(float *values, Easing easing, int count);
+// same draws from the random generator, in the same order, as calling RandomPointOnUnitCircle count times
+void RandomPointOnUnitCircleSpan(float *x, float *y, int count);
+
+// runs every supported level against the scalar path, prints timings, returns 0 if they all matched
+int RunSpanMathCheck();
+
+#endif // PONG_SPAN_MATH_H
@@ -0,0 +1,49 @@
+#ifndef PONG_SPECTATOR_H
+#define PONG_SPECTATOR_H
+
+#include <stdbool.h>
+
+#define SPECTATOR_DEFAULT_PORT 7778
+#define MAX_SPECTATORS 256
+#define SPECTATOR_MAGIC 0x43455053                 // "SPEC"
+#define SPECTATOR_WORLD_CAPACITY (256 * 1024)      // in bytes, a busy match is ~20 KB, bigger worlds get skipped
+#define SPECTATOR_QUEUE_WORLDS 4                   // published but not picked up by the broadcast thread yet, power of two
+#define SPECTATOR_HISTORY_TICKS 32                 // worlds kept to make deltas against, anyone further behind gets a whole one
+#define SPECTATOR_MESSAGE_SLOTS 16                 // encoded messages, spectators that are on the same tick share one
+#define SPECTATOR_LOAD_TEST_VIEWERS 200
+#define SPECTATOR_LOAD_TEST_SECONDS 10
+#define SPECTATOR_LOAD_TEST_WORLD_CAPACITY (64 * 1024) // in bytes, per simulated viewer
+#define SPECTATOR_LOAD_TEST_POLL_TIMEOUT 100           // in milliseconds, how long it takes the simulated viewers to notice the test is over
+
+// every message starts with this, followed by payloadSize bytes of either a whole snapshot
+// or a snapshot delta against baseTick. a spectator answers every message with the tick
+// it now has (4 bytes), and isn't sent anything else until it does
+typedef struct SpectatorMessageHeader {
+    unsigned int magic;
+    int tick;
+    int baseTick;             // -1 for a whole world
+    unsigned int worldHash;   // HashSnapshot of the world the message leaves the spectator with
+    unsigned int payloadSize; // in bytes
+} SpectatorMessageHeader;
+
+// streams the world to anyone on the lan who connects. publishing only copies the world into a queue,
+// a broadcast thread does the delta encoding + sending with epoll, so the tick never waits on a spectator.
+// each spectator gets deltas against the last tick it acked, one message at a time, so slow ones
+// just see fewer ticks. linux only for now
+bool StartSpectatorServer(unsigned short port);
+void StopSpectatorServer();
+// call once per frame after simulating, does nothing unless the server is running or
+// if the world hasn't moved on since the last call
+void PublishSpectatorWorld();
+
+// watches someone else's match instead of simulating one, the world is swapped in every time a new one arrives
+bool StartSpectating(const char *host, unsigned short port);
+void StopSpectating();
+bool IsSpectating();
+void UpdateSpectating();
+
+// serves a headless bot match to a crowd of simulated viewers over loopback,
+// returns 0 if every viewer stayed connected and rebuilt every world it was sent
+int RunSpectatorLoadTest(int viewerCount, float seconds);
+
+#endif // PONG_SPECTATOR_H
@@ -0,0 +1,68 @@
+#ifndef PONG_TIMER_WHEEL_H
+#define PONG_TIMER_WHEEL_H
+
+#include "game.h"
+
+#define MAX_TIMERS 2048                                   // pending at once, every ball's spawn delay fits with room to spare
+#define TIMER_WHEEL_LEVELS 3
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)    // per level, level n slots are 64^n ticks wide
+#define TIMER_SLOT_COUNT (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+#define TIMER_NONE 0u
+
+#define SECONDS_TO_TICKS(SECONDS) ((int) ((SECONDS) * SIMULATION_TICK_RATE + 0.5f))
+
+// what happens when a timer fires. the world (timers included) gets snapshotted,
+// so timers carry one of these + a target instead of a function pointer
+typedef enum TimerEvent {
+    TIMER_EVENT_OBJECTIVES_READY,
+    TIMER_EVENT_BALL_SPAWNED,        // target is the ball
+    TIMER_EVENT_BOUNCE_EFFECT_DONE,  // target is the effect's pool index
+    TIMER_EVENT_PARTICLE_BURST_DONE, // target is the burst's pool index
+    TIMER_EVENT_COUNT,
+} TimerEvent;
+
+// index + generation, so cancelling a timer that already fired (and whose slot got reused) does nothing.
+// InitTimers starts the generations over, so ids from the last match have to be forgotten too
+typedef unsigned int TimerId;
+
+typedef void (*TimerHandler)(int target);
+
+typedef struct Timer {
+    int next;       // in the same slot, or the free list
+    int previous;
+    int slot;       // -1 when not pending
+    int expireTick;
+    int event;
+    int target;
+    unsigned int generation;
+} Timer;
+
+// one world's timers. they're handed out from the front, so only the ones used since the match started get snapshotted
+typedef struct TimerWorld {
+    Timer instances[MAX_TIMERS];
+    int usedTimerCount;
+    int pendingTimerCount;
+    int freeTimer;
+    int slotHeads[TIMER_SLOT_COUNT + 1]; // the extra one is for timers being fired
+    int currentTick;
+    TimerHandler handlers[TIMER_EVENT_COUNT];
+} TimerWorld;
+
+// hierarchical timer wheel counting simulation ticks. scheduling + cancelling are O(1), and a tick
+// only looks at the timers due in it, plus every 64 ticks one slot's worth moving down a level.
+// pending timers cost nothing until then, however many there are. part of the world
+void InitTimers();
+// handlers are code, not state, so every Init that schedules a kind of event sets its handler again
+void SetTimerHandler(TimerEvent event, TimerHandler handler);
+// fires event after this many ticks (at least 1). returns TIMER_NONE if MAX_TIMERS are already pending
+TimerId ScheduleTimer(TimerEvent event, int target, int delayTicks);
+void CancelTimer(TimerId timer);
+// moves on a tick and fires everything that's due, call at the start of every simulated tick
+void AdvanceTimers();
+// ticks simulated since the match started, for working out how far along something timed is
+int GetTimerTick();
+// 0 to 1, for something that started on startTick and lasts durationTicks
+float GetTimerProgress(int startTick, int durationTicks);
+
+#endif // PONG_TIMER_WHEEL_H
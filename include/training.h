@@ -0,0 +1,19 @@
+#ifndef PONG_TRAINING_H
+#define PONG_TRAINING_H
+
+#include "game.h"
+
+#define TRAINING_PHASE_TICKS (SIMULATION_TICK_RATE * 60)  // each of the three phases runs this long
+#define TRAINING_STORM_BALL_COUNT 16
+#define TRAINING_STORM_INTERVAL 6                         // in ticks, between forced particle bursts
+#define TRAINING_STORM_PARTICLES 40
+#define TRAINING_RESTART_BALL_COUNT 8
+#define TRAINING_RESTART_INTERVAL (SIMULATION_TICK_RATE * 2) // in ticks, between forced restarts
+
+// a headless bot session shaped like the games that actually get played, for profile guided
+// builds to train on + for timing one build against another: a full house of balls, a particle
+// storm, then a run of restarts. every tick gets recorded + submitted like a rendered frame.
+// the same seed always plays the same session, prints the average tick time at the end
+int RunTrainingWorkload(int phaseTicks, unsigned int seed);
+
+#endif // PONG_TRAINING_H
@@ -0,0 +1,54 @@
+#ifndef PONG_WORLD_H
+#define PONG_WORLD_H
+
+#include <stdbool.h>
+#include "platform.h"
+#include "arena.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "game.h"
+#include "field.h"
+#include "player.h"
+#include "ball.h"
+#include "bullet.h"
+#include "objective.h"
+#include "particles.h"
+#include "pattern.h"
+#include "timer_wheel.h"
+#include "bot.h"
+
+// everything one match is made of, plus the registries + scratch memory that go with it.
+// the windowed game and every headless mode play in the main world on the main thread,
+// batch workers each bring a world of their own. nothing else touches simulation state
+typedef struct World {
+    unsigned int randomState;
+    bool areSoundsMuted;
+    bool areMetricsMuted;
+
+    GameWorld game;
+    FieldWorld field;
+    PlayerWorld players;
+    BallWorld balls;
+    BulletWorld bullets;
+    ObjectiveWorld objectives;
+    ParticleWorld particles;
+    PatternWorld patterns;
+    TimerWorld timers;
+    BotWorld bot;
+
+    SnapshotRegistry snapshots;
+    StaticMemoryRegistry staticMemory;
+    AllocatorRegistry allocators;
+} World;
+
+// the world simulation calls on this thread act on. a pointer is all a thread carries,
+// and it's NULL on the ones that never simulate (audio, logging, networking...)
+extern THREAD_LOCAL World *gWorld;
+
+// back to how a world starts out, before anything has been initialized in it
+void InitWorld(World *world);
+// simulation calls from this thread act on world from now on
+void UseWorld(World *world);
+World *GetMainWorld();
+
+#endif // PONG_WORLD_H
@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <string.h>
+#include "arena.h"
+#include "log.h"
+#include "memory_usage.h"
+#include "world.h"
+
+#define DEBUG_POISON_BYTE 0xCD
+
+// returns false if we already knew about this arena
+static bool TrackArena(Arena *arena) {
+    AllocatorRegistry *allocators = &gWorld->allocators;
+    for (int i = 0; i < allocators->trackedArenaCount; ++i) {
+        if (allocators->trackedArenas[i] == arena) {
+            return false;
+        }
+    }
+    if (allocators->trackedArenaCount < MAX_TRACKED_ALLOCATORS) {
+        allocators->trackedArenas[allocators->trackedArenaCount++] = arena;
+    }
+    return true;
+}
+
+// returns false if we already knew about this pool
+static bool TrackPool(Pool *pool) {
+    AllocatorRegistry *allocators = &gWorld->allocators;
+    for (int i = 0; i < allocators->trackedPoolCount; ++i) {
+        if (allocators->trackedPools[i] == pool) {
+            return false;
+        }
+    }
+    if (allocators->trackedPoolCount < MAX_TRACKED_ALLOCATORS) {
+        allocators->trackedPools[allocators->trackedPoolCount++] = pool;
+    }
+    return true;
+}
+
+void InitArena(Arena *arena, const char *name, void *memory, size_t capacity) {
+    arena->name = name;
+    arena->memory = memory;
+    arena->capacity = capacity;
+    arena->used = 0;
+
+    // stats survive re-initialization (e.g. on restart) so the report covers the whole session
+    if (TrackArena(arena)) {
+        arena->highWaterMark = 0;
+        arena->failedAllocations = 0;
+    }
+}
+
+void *AllocateFromArena(Arena *arena, size_t size) {
+    // round up so every allocation starts aligned
+    size_t start = (arena->used + (ARENA_ALIGNMENT - 1)) & ~((size_t) ARENA_ALIGNMENT - 1);
+
+    if (start + size > arena->capacity) {
+        if (arena->failedAllocations == 0) {
+            LogMessage("ran out of arena memory in %s!", arena->name);
+        }
+        arena->failedAllocations++;
+        return NULL;
+    }
+
+    arena->used = start + size;
+    if (arena->used > arena->highWaterMark) {
+        arena->highWaterMark = arena->used;
+    }
+    return arena->memory + start;
+}
+
+void ResetArena(Arena *arena) {
+#ifdef PONG_DEBUG_MEMORY
+    // stomp on old data so anything holding onto it breaks loudly
+    memset(arena->memory, DEBUG_POISON_BYTE, arena->used);
+#endif
+    arena->used = 0;
+}
+
+size_t GetArenaMarker(const Arena *arena) {
+    return arena->used;
+}
+
+void RewindArenaTo(Arena *arena, size_t marker) {
+    if (marker < arena->used) {
+#ifdef PONG_DEBUG_MEMORY
+        memset(arena->memory + marker, DEBUG_POISON_BYTE, arena->used - marker);
+#endif
+        arena->used = marker;
+    }
+}
+
+void InitPool(Pool *pool, const char *name, void *memory, size_t elementSize, int capacity) {
+    pool->name = name;
+    pool->memory = memory;
+    pool->elementSize = elementSize;
+    pool->capacity = capacity;
+
+    // free list links live inside the unused elements themselves
+    if (elementSize < sizeof(int)) {
+        LogMessage("pool %s elements are too small!", name);
+        pool->capacity = 0;
+    }
+
+    ResetPool(pool);
+
+    // stats survive re-initialization (e.g. on restart) so the report covers the whole session
+    if (TrackPool(pool)) {
+        pool->highWaterMark = 0;
+        pool->failedAllocations = 0;
+    }
+}
+
+static int *GetFreeLink(const Pool *pool, int index) {
+    return (int *) (pool->memory + (size_t) index * pool->elementSize);
+}
+
+void *AllocateFromPool(Pool *pool) {
+    // callers report their own exhaustion, we only count it
+    if (pool->freeHead == -1) {
+        pool->failedAllocations++;
+        return NULL;
+    }
+
+    int index = pool->freeHead;
+    pool->freeHead = *GetFreeLink(pool, index);
+    pool->usedCount++;
+    if (pool->usedCount > pool->highWaterMark) {
+        pool->highWaterMark = pool->usedCount;
+    }
+    return GetPoolElement(pool, index);
+}
+
+void ReleaseToPool(Pool *pool, void *element) {
+    if (element == NULL) {
+        return;
+    }
+    int index = GetPoolIndex(pool, element);
+#ifdef PONG_DEBUG_MEMORY
+    memset(element, DEBUG_POISON_BYTE, pool->elementSize);
+#endif
+    *GetFreeLink(pool, index) = pool->freeHead;
+    pool->freeHead = index;
+    pool->usedCount--;
+}
+
+int GetPoolIndex(const Pool *pool, const void *element) {
+    return (int) (((const unsigned char *) element - pool->memory) / pool->elementSize);
+}
+
+void *GetPoolElement(const Pool *pool, int index) {
+    return pool->memory + (size_t) index * pool->elementSize;
+}
+
+void ResetPool(Pool *pool) {
+    pool->freeHead = -1;
+    pool->usedCount = 0;
+
+    // link back-to-front so allocation order starts at the first element
+    for (int i = pool->capacity - 1; i >= 0; --i) {
+        *GetFreeLink(pool, i) = pool->freeHead;
+        pool->freeHead = i;
+    }
+}
+
+void InitFrameArenas() {
+    AllocatorRegistry *allocators = &gWorld->allocators;
+    InitArena(&allocators->frameArena, "frame", allocators->frameArenaMemory, FRAME_ARENA_SIZE);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_SCRATCH, allocators->frameArenaMemory);
+}
+
+void ResetFrameArenas() {
+    ResetArena(&gWorld->allocators.frameArena);
+}
+
+void *FrameAllocate(size_t size) {
+    return AllocateFromArena(&gWorld->allocators.frameArena, size);
+}
+
+Arena *GetFrameArena() {
+    return &gWorld->allocators.frameArena;
+}
+
+int GetTrackedArenaCount() {
+    return gWorld->allocators.trackedArenaCount;
+}
+
+const Arena *GetTrackedArena(int index) {
+    return gWorld->allocators.trackedArenas[index];
+}
+
+int GetTrackedPoolCount() {
+    return gWorld->allocators.trackedPoolCount;
+}
+
+const Pool *GetTrackedPool(int index) {
+    return gWorld->allocators.trackedPools[index];
+}
+
+static void PrewarmMemory(unsigned char *memory, size_t size) {
+    // write back what's already there, pool free lists live inside their elements
+    volatile unsigned char *bytes = memory;
+    for (size_t i = 0; i < size; i += ALLOCATOR_PREWARM_STRIDE) {
+        bytes[i] = bytes[i];
+    }
+}
+
+void PrewarmTrackedAllocators() {
+    AllocatorRegistry *allocators = &gWorld->allocators;
+    for (int i = 0; i < allocators->trackedArenaCount; ++i) {
+        PrewarmMemory(allocators->trackedArenas[i]->memory, allocators->trackedArenas[i]->capacity);
+    }
+    for (int i = 0; i < allocators->trackedPoolCount; ++i) {
+        const Pool *pool = allocators->trackedPools[i];
+        PrewarmMemory(pool->memory, pool->elementSize * (size_t) pool->capacity);
+    }
+}
+
+void ReportMemoryHighWaterMarks() {
+    AllocatorRegistry *allocators = &gWorld->allocators;
+    printf("---- memory high-water marks ----\n");
+    for (int i = 0; i < allocators->trackedArenaCount; ++i) {
+        Arena *arena = allocators->trackedArenas[i];
+        printf("arena %-20s %8zu / %8zu bytes (%5.1f%%), %d failed\n",
+               arena->name, arena->highWaterMark, arena->capacity,
+               100.0 * (double) arena->highWaterMark / (double) arena->capacity,
+               arena->failedAllocations);
+    }
+    for (int i = 0; i < allocators->trackedPoolCount; ++i) {
+        Pool *pool = allocators->trackedPools[i];
+        printf("pool  %-20s %8d / %8d elements (%5.1f%%), %d failed\n",
+               pool->name, pool->highWaterMark, pool->capacity,
+               pool->capacity > 0 ? 100.0 * pool->highWaterMark / pool->capacity : 0.0,
+               pool->failedAllocations);
+    }
+}
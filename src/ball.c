@@ -1,200 +1,367 @@
 #include <raylib.h>
 #include <raymath.h>
-#include <stdio.h>
 #include "ball.h"
 #include "game.h"
 #include "sound.h"
 #include "player.h"
 #include "math_util.h"
 #include "particles.h"
-
-typedef struct BounceEffect {
-    float remainingTime;
-    Vector2 position;
-    Color color;
-} BounceEffect;
-
-typedef enum BallState {
-    BALL_STATE_SPAWNING,
-    BALL_STATE_ACTIVE,
-} BallState;
-
-typedef struct BallInstance {
-    union {
-        struct {
-            Vector2 velocity;
-            float timeSinceBounce;
-        } active;
-        struct {
-            float elapsedTime;
-        } spawning;
-    };
-    float size;
-    Vector2 position;
-    Color color;
-    BallState state;
-} BallInstance;
+#include "arena.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "metrics.h"
+#include "render_list.h"
+#include "fixed_math.h"
+#include "field.h"
+#include "timer_wheel.h"
+#include "world.h"
 
 static void HandleBounce(BallInstance *ball);
+static bool CheckCollisionTrailsPlayers();
 
-static BallInstance sSpawnedBalls[MAX_BALLS];
-static BounceEffect sBounceEffects[MAX_BOUNCE_EFFECTS];
-static int sSpawnedBallCount;
+static Metric sLiveBallsMetric;
+static Metric sBouncesMetric;
 
 void SpawnBall() {
+    BallWorld *balls = &gWorld->balls;
+    if (balls->spawnedBallCount == MAX_BALLS) {
+        return;
+    }
+
+    Vector2 fieldSize = GetFieldSize();
     BallInstance newBallInstance = {
         .spawning = {
-            .elapsedTime = 0,
+            .startTick = GetTimerTick(),
         },
         .position = {
-            .x = RandomFloat() * GAME_WIDTH,
-            .y = RandomFloat() * GAME_HEIGHT,
+            .x = SIM_FROM_FLOAT(RandomFloat() * fieldSize.x),
+            .y = SIM_FROM_FLOAT(RandomFloat() * fieldSize.y),
         },
         .size = 0,
         .color = RandomColor(),
         .state = BALL_STATE_SPAWNING,
+        .trailHead = 0,
+        .trailCount = 0,
+        .skippedTickCount = 0,
     };
-    sSpawnedBalls[sSpawnedBallCount] = newBallInstance;
-    sSpawnedBallCount++;
+    balls->spawnedBalls[balls->spawnedBallCount] = newBallInstance;
+    ScheduleTimer(TIMER_EVENT_BALL_SPAWNED, balls->spawnedBallCount, SECONDS_TO_TICKS(BALL_SPAWN_TIME));
+    balls->spawnedBallCount++;
+}
+
+static void HandleBallSpawned(int index) {
+    BallWorld *balls = &gWorld->balls;
+    BallInstance *ball = &balls->spawnedBalls[index];
+    ball->state = BALL_STATE_ACTIVE;
+    ball->size = SIM_FROM_FLOAT(BALL_SIZE);
+    ball->active.timeSinceBounce = 0;
+    ball->active.velocity = SimVector2Scale(SimVector2FromVector2(RandomPointOnUnitCircle()), SIM_FROM_FLOAT(BALL_SPEED));
+}
+
+static void HandleBounceEffectDone(int poolIndex) {
+    BallWorld *balls = &gWorld->balls;
+    for (int i = 0; i < balls->activeBounceEffectCount; ++i) {
+        if (balls->activeBounceEffects[i] == poolIndex) {
+            balls->activeBounceEffects[i] = balls->activeBounceEffects[--balls->activeBounceEffectCount];
+            break;
+        }
+    }
+    ReleaseToPool(&balls->bounceEffectPool, GetPoolElement(&balls->bounceEffectPool, poolIndex));
+}
+
+// i = 0 is the oldest sample still in the trail
+static Vector2 GetTrailPoint(const BallInstance *ball, int i) {
+    int oldest = ball->trailHead - ball->trailCount + BALL_TRAIL_LENGTH;
+    return SimVector2ToVector2(ball->trail[(oldest + i) % BALL_TRAIL_LENGTH]);
+}
+
+static void RecordTrail(BallInstance *ball, float deltaTime) {
+    ball->trailSampleTime += deltaTime;
+    if (ball->trailSampleTime < BALL_TRAIL_SAMPLE_TIME) {
+        return;
+    }
+    ball->trailSampleTime -= BALL_TRAIL_SAMPLE_TIME;
+
+    ball->trail[ball->trailHead] = ball->position;
+    ball->trailHead = (ball->trailHead + 1) % BALL_TRAIL_LENGTH;
+    if (ball->trailCount < BALL_TRAIL_LENGTH) {
+        ball->trailCount++;
+    }
+}
+
+static void RenderTrail(const BallInstance *ball) {
+    // the newest sample connects to wherever the ball is right now
+    for (int i = 0; i < ball->trailCount; ++i) {
+        Vector2 start = GetTrailPoint(ball, i);
+        Vector2 end = (i + 1 < ball->trailCount) ? GetTrailPoint(ball, i + 1) : SimVector2ToVector2(ball->position);
+        if (!IsRectangleInView(GetSegmentBounds(start, end, BALL_TRAIL_WIDTH * 0.5f))) {
+            continue;
+        }
+
+        // fade out towards the oldest end of the trail
+        float t = (float) (i + 1) / (float) ball->trailCount;
+        Color color = ball->color;
+        color.a = (unsigned char) Lerp(BALL_TRAIL_MIN_ALPHA, color.a, t);
+        RecordLine(RENDER_LAYER_BACKGROUND, start, end, BALL_TRAIL_WIDTH, color);
+    }
 }
 
 void RenderBalls() {
-    for (int i = 0; i < sSpawnedBallCount; ++i) {
-        BallInstance *ball = &sSpawnedBalls[i];
+    BallWorld *balls = &gWorld->balls;
+    for (int i = 0; i < balls->spawnedBallCount; ++i) {
+        RenderTrail(&balls->spawnedBalls[i]);
+    }
+
+    for (int i = 0; i < balls->spawnedBallCount; ++i) {
+        BallInstance *ball = &balls->spawnedBalls[i];
+        if (!IsCircleInView(SimVector2ToVector2(ball->position), SIM_TO_FLOAT(ball->size))) {
+            continue;
+        }
 
         switch (ball->state) {
             case BALL_STATE_SPAWNING: {
-                float spawnPercent = ball->spawning.elapsedTime / BALL_SPAWN_TIME;
-                DrawRing(ball->position, ball->size * SmoothStop3(1 - spawnPercent), ball->size, 0, 360, 30, ball->color);
+                float spawnPercent = GetTimerProgress(ball->spawning.startTick, SECONDS_TO_TICKS(BALL_SPAWN_TIME));
+                float size = SIM_TO_FLOAT(ball->size);
+                RecordRing(RENDER_LAYER_HAZARDS, SimVector2ToVector2(ball->position), size * SmoothStop3(1 - spawnPercent), size, ball->color);
                 break;
             }
             case BALL_STATE_ACTIVE: {
-                DrawCircleV(ball->position, ball->size, ball->color);
+                RecordCircle(RENDER_LAYER_HAZARDS, SimVector2ToVector2(ball->position), SIM_TO_FLOAT(ball->size), ball->color);
                 break;
             }
         }
     }
 
-    for (int i = 0; i < MAX_BOUNCE_EFFECTS; ++i) {
-        BounceEffect* bounceEffect = &sBounceEffects[i];
+    for (int i = 0; i < balls->activeBounceEffectCount; ++i) {
+        BounceEffect* bounceEffect = GetPoolElement(&balls->bounceEffectPool, balls->activeBounceEffects[i]);
 
-        // find the percent complete we are with the effect
-        float t = sBounceEffects[i].remainingTime / BOUNCE_EFFECT_DURATION;
+        // how much of the effect is left
+        float t = 1 - GetTimerProgress(bounceEffect->startTick, SECONDS_TO_TICKS(BOUNCE_EFFECT_DURATION));
 
         // the size multiplier should start at 1 and end at BOUNCE_EFFECT_MAX_SIZE
         float bounceSizeMultiplier = 1 + ((BOUNCE_EFFECT_MAX_SIZE - 1) * (1 - t));
 
         // the color should fade out as the effect completes
-        Color color = sBounceEffects[i].color;
+        Color color = bounceEffect->color;
         color.a = (unsigned char)((float) color.a * t);
 
         // render the bounce effect
         float outerRadius = BALL_SIZE * bounceSizeMultiplier;
         float innerRadius = fmaxf(outerRadius - BOUNCE_EFFECT_WIDTH, 0);
-        DrawRing(bounceEffect->position, innerRadius, outerRadius, 0, 360, 30, color);
+        if (!IsCircleInView(bounceEffect->position, outerRadius)) {
+            continue;
+        }
+        RecordRing(RENDER_LAYER_HAZARDS, bounceEffect->position, innerRadius, outerRadius, color);
     }
 }
 
 void InitBalls() {
-    sSpawnedBallCount = 0;
-
-    for (int i = 0; i < MAX_BOUNCE_EFFECTS; ++i) {
-        sBounceEffects[i].remainingTime = 0;
-    }
+    BallWorld *balls = &gWorld->balls;
+    balls->spawnedBallCount = 0;
+    balls->activeBounceEffectCount = 0;
+    INIT_STATIC_POOL(balls->bounceEffectPool);
+
+    REGISTER_SNAPSHOT_ARRAY(balls->spawnedBalls, balls->spawnedBallCount);
+    REGISTER_SNAPSHOT_ARRAY(balls->activeBounceEffects, balls->activeBounceEffectCount);
+    RegisterSnapshotPool(&balls->bounceEffectPool);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BALLS, balls->spawnedBalls, balls->spawnedBallCount);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BALLS, balls->activeBounceEffects, balls->activeBounceEffectCount);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_BALLS, balls->bounceEffectPoolStorage);
+    SetTimerHandler(TIMER_EVENT_BALL_SPAWNED, HandleBallSpawned);
+    SetTimerHandler(TIMER_EVENT_BOUNCE_EFFECT_DONE, HandleBounceEffectDone);
+
+    RegisterGauge(&sLiveBallsMetric, "pong_balls_live", "Balls currently spawned.");
+    RegisterCounter(&sBouncesMetric, "pong_ball_bounces_total", "Times a ball has bounced off the edge of the screen.");
 }
 
 void UpdateBalls(float deltaTime) {
-    for (int i = 0; i < MAX_BOUNCE_EFFECTS; ++i) {
-        // skip if not OBJECTIVE_STATE_ACTIVE
-        if (sBounceEffects[i].remainingTime <= 0) {
+    BallWorld *balls = &gWorld->balls;
+    Vector2 fieldSize = GetFieldSize();
+
+    for (int i = 0; i < balls->spawnedBallCount; ++i) {
+        BallInstance *ball = &balls->spawnedBalls[i];
+
+        // far away balls only move every few ticks (a bigger step to make up for it), or not at all
+        ChunkActivity activity = GetChunkActivity(SimVector2ToVector2(ball->position));
+        if (activity == CHUNK_ASLEEP) {
             continue;
         }
-        sBounceEffects[i].remainingTime -= deltaTime;
-    }
-
-    for (int i = 0; i < sSpawnedBallCount; ++i) {
-        BallInstance *ball = &sSpawnedBalls[i];
+        if (activity == CHUNK_REDUCED && ball->skippedTickCount + 1 < FIELD_REDUCED_TICK_INTERVAL) {
+            ball->skippedTickCount++;
+            continue;
+        }
+        float ballDeltaTime = deltaTime * (float) (ball->skippedTickCount + 1);
+        ball->skippedTickCount = 0;
 
         switch (ball->state) {
             case BALL_STATE_SPAWNING: {
-                float t = ball->spawning.elapsedTime / BALL_SPAWN_TIME;
-                ball->size = Lerp(0, BALL_SIZE, t);
-                ball->spawning.elapsedTime += GetFrameTime();
-
-                if (t >= 1) {
-                    ball->state = BALL_STATE_ACTIVE;
-                    ball->active.timeSinceBounce = 0;
-                    ball->active.velocity = Vector2Scale(RandomPointOnUnitCircle(), BALL_SPEED);
-                }
-
+                // grows until HandleBallSpawned sets it loose
+                float t = GetTimerProgress(ball->spawning.startTick, SECONDS_TO_TICKS(BALL_SPAWN_TIME));
+                ball->size = SimLerp(SIM_FROM_FLOAT(0), SIM_FROM_FLOAT(BALL_SIZE), SIM_FROM_FLOAT(t));
                 break;
             }
             case BALL_STATE_ACTIVE: {
                 // update ball
-                ball->active.timeSinceBounce += deltaTime;
+                ball->active.timeSinceBounce += ballDeltaTime;
 
                 // how close are we to going max-speed?
-                float velocityPercent = Clamp(ball->active.timeSinceBounce / BALL_ACCELERATION_TIME, 0, 1);
+                SimScalar velocityPercent = SIM_FROM_FLOAT(Clamp(ball->active.timeSinceBounce / BALL_ACCELERATION_TIME, 0, 1));
                 // update velocity based on acceleration rate
-                Vector2 initialVelocity = Vector2Scale(
-                    Vector2Normalize(ball->active.velocity), BALL_SPEED);
-                Vector2 targetVelocity = Vector2Scale(
-                    Vector2Normalize(ball->active.velocity), BALL_MAX_SPEED);
-                ball->active.velocity = Vector2Lerp(initialVelocity, targetVelocity, velocityPercent);
+                SimVector2 initialVelocity = SimVector2Scale(
+                    SimVector2Normalize(ball->active.velocity), SIM_FROM_FLOAT(BALL_SPEED));
+                SimVector2 targetVelocity = SimVector2Scale(
+                    SimVector2Normalize(ball->active.velocity), SIM_FROM_FLOAT(balls->maxSpeed));
+                ball->active.velocity = SimVector2Lerp(initialVelocity, targetVelocity, velocityPercent);
 
                 // update position based on velocity for this frame
-                ball->position = Vector2Add(
-                    Vector2Scale(ball->active.velocity, deltaTime), ball->position);
+                ball->position = SimVector2Add(
+                    SimVector2Scale(ball->active.velocity, SIM_FROM_FLOAT(ballDeltaTime)), ball->position);
 
-                ball->size = Lerp(BALL_SIZE, BALL_MIN_SIZE, velocityPercent);
+                ball->size = SimLerp(SIM_FROM_FLOAT(BALL_SIZE), SIM_FROM_FLOAT(BALL_MIN_SIZE), velocityPercent);
+                RecordTrail(ball, ballDeltaTime);
 
-                // bounce off-screen top/bottom
-                if (ball->position.x > GAME_WIDTH || ball->position.x < 0) {
+                // bounce off the field's left/right edges
+                if (ball->position.x > SIM_FROM_FLOAT(fieldSize.x) || ball->position.x < 0) {
                     ball->active.velocity.x = -ball->active.velocity.x;
-                    ball->position.x = Clamp(ball->position.x, 0, GAME_WIDTH);
+                    ball->position.x = SimClamp(ball->position.x, 0, SIM_FROM_FLOAT(fieldSize.x));
                     HandleBounce(ball);
                 }
 
-                // bounce off-screen left/right
-                if (ball->position.y > GAME_HEIGHT || ball->position.y < 0) {
+                // bounce off the field's top/bottom edges
+                if (ball->position.y > SIM_FROM_FLOAT(fieldSize.y) || ball->position.y < 0) {
                     ball->active.velocity.y = -ball->active.velocity.y;
-                    ball->position.y = Clamp(ball->position.y, 0, GAME_HEIGHT);
+                    ball->position.y = SimClamp(ball->position.y, 0, SIM_FROM_FLOAT(fieldSize.y));
                     HandleBounce(ball);
                 }
 
-                if (CheckCollisionCircleRec(ball->position, ball->size, GetPlayerRect())) {
+                if (FindPlayerTouchingCircle(SimVector2ToVector2(ball->position), SIM_TO_FLOAT(ball->size)) != -1) {
                     ChangeGameStateTo(GAME_STATE_OVER);
                 }
                 break;
             }
         }
     }
+
+    if (CheckCollisionTrailsPlayers()) {
+        ChangeGameStateTo(GAME_STATE_OVER);
+    }
+
+    SetGauge(&sLiveBallsMetric, balls->spawnedBallCount);
+}
+
+// every segment against every player, straight off the balls. it's what the reference plays
+// and what the bounds check below has to agree with
+static bool CheckCollisionTrailsPlayersBruteForce() {
+    BallWorld *balls = &gWorld->balls;
+    for (int i = 0; i < balls->spawnedBallCount; ++i) {
+        const BallInstance *ball = &balls->spawnedBalls[i];
+        if (GetChunkActivity(SimVector2ToVector2(ball->position)) != CHUNK_ACTIVE) {
+            continue;
+        }
+
+        for (int j = 0; j < ball->trailCount; ++j) {
+            Vector2 start = GetTrailPoint(ball, j);
+            Vector2 end = (j + 1 < ball->trailCount) ? GetTrailPoint(ball, j + 1) : SimVector2ToVector2(ball->position);
+            for (int k = 0; k < gWorld->players.count; ++k) {
+                if (CheckCollisionCapsuleRec(start, end, BALL_TRAIL_WIDTH * 0.5f, GetPlayerRect(k))) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
 }
 
-static void HandleBounce(BallInstance *ball) {
-    // find the first unused effect
-    BounceEffect *bounceEffect = NULL;
+// there's only ever one or two players to test against, so building an index over the trails
+// every tick costs more than it saves. a straight walk that rules segments out on their bounds
+// first leaves the capsule test for the few that are actually near a player
+static bool CheckCollisionTrailsPlayers() {
+    BallWorld *balls = &gWorld->balls;
+    PlayerWorld *players = &gWorld->players;
+    if (IsReferenceSimulation()) {
+        return CheckCollisionTrailsPlayersBruteForce();
+    }
 
-    for (int i = 0; i < MAX_BOUNCE_EFFECTS; ++i) {
-        bounceEffect = &sBounceEffects[i];
-        if (bounceEffect->remainingTime <= 0) {
-            break;
+    Rectangle playerRects[MAX_PLAYERS];
+    for (int k = 0; k < players->count; ++k) {
+        playerRects[k] = GetPlayerRect(k);
+    }
+
+    // balls outside the active chunks are at least a couple of chunks from every player, further than a trail reaches
+    for (int i = 0; i < balls->spawnedBallCount; ++i) {
+        const BallInstance *ball = &balls->spawnedBalls[i];
+        if (GetChunkActivity(SimVector2ToVector2(ball->position)) != CHUNK_ACTIVE) {
+            continue;
+        }
+
+        for (int j = 0; j < ball->trailCount; ++j) {
+            Vector2 start = GetTrailPoint(ball, j);
+            Vector2 end = (j + 1 < ball->trailCount) ? GetTrailPoint(ball, j + 1) : SimVector2ToVector2(ball->position);
+            Rectangle segmentBounds = GetSegmentBounds(start, end, BALL_TRAIL_WIDTH * 0.5f);
+            for (int k = 0; k < players->count; ++k) {
+                if (CheckCollisionRecs(segmentBounds, playerRects[k]) &&
+                    CheckCollisionCapsuleRec(start, end, BALL_TRAIL_WIDTH * 0.5f, playerRects[k])) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+int GatherBallHazards(Rectangle area, Hazard *hazards, int capacity) {
+    BallWorld *balls = &gWorld->balls;
+    int hazardCount = 0;
+
+    for (int i = 0; i < balls->spawnedBallCount && hazardCount < capacity; ++i) {
+        const BallInstance *ball = &balls->spawnedBalls[i];
+        Vector2 position = SimVector2ToVector2(ball->position);
+        Vector2 velocity = ball->state == BALL_STATE_ACTIVE ? SimVector2ToVector2(ball->active.velocity) : Vector2Zero();
+        float size = SIM_TO_FLOAT(ball->size);
+
+        if (CheckCollisionCircleRec(position, size, area)) {
+            hazards[hazardCount++] = (Hazard) {position, position, velocity, size};
+        }
+
+        for (int j = 0; j < ball->trailCount && hazardCount < capacity; ++j) {
+            Vector2 start = GetTrailPoint(ball, j);
+            Vector2 end = (j + 1 < ball->trailCount) ? GetTrailPoint(ball, j + 1) : position;
+
+            if (CheckCollisionRecs(GetSegmentBounds(start, end, BALL_TRAIL_WIDTH * 0.5f), area)) {
+                hazards[hazardCount++] = (Hazard) {start, end, Vector2Zero(), BALL_TRAIL_WIDTH * 0.5f};
+            }
         }
     }
 
+    return hazardCount;
+}
+
+static void HandleBounce(BallInstance *ball) {
+    BallWorld *balls = &gWorld->balls;
+    PlayGameSound(GAME_SOUND_BALL_HIT);
+    AddToCounter(&sBouncesMetric, 1);
+
+    // reset ball speed + acceleration
+    ball->active.timeSinceBounce = 0;
+    ball->active.velocity = SimVector2Scale(SimVector2Normalize(ball->active.velocity), SIM_FROM_FLOAT(BALL_SPEED));
+
+    // grab an unused effect
+    BounceEffect *bounceEffect = AllocateFromPool(&balls->bounceEffectPool);
+
+    // the pool counts the miss, it shows up as pong_pool_exhausted_total
     if (bounceEffect == NULL) {
-        printf("ran out of bounce effects!\n");
         return;
     }
 
-    PlaySound(gBallHitSound);
+    int poolIndex = GetPoolIndex(&balls->bounceEffectPool, bounceEffect);
+    if (ScheduleTimer(TIMER_EVENT_BOUNCE_EFFECT_DONE, poolIndex, SECONDS_TO_TICKS(BOUNCE_EFFECT_DURATION)) == TIMER_NONE) {
+        ReleaseToPool(&balls->bounceEffectPool, bounceEffect);
+        return;
+    }
 
     // initialize new bounce effect
-    bounceEffect->remainingTime = BOUNCE_EFFECT_DURATION;
-    bounceEffect->position = ball->position;
+    bounceEffect->startTick = GetTimerTick();
+    bounceEffect->position = SimVector2ToVector2(ball->position);
     bounceEffect->color = ball->color;
-
-    // reset ball speed + acceleration
-    ball->active.timeSinceBounce = 0;
-    ball->active.velocity = Vector2Scale(Vector2Normalize(ball->active.velocity), BALL_SPEED);
+    balls->activeBounceEffects[balls->activeBounceEffectCount++] = poolIndex;
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "batch.h"
+#include "game.h"
+#include "ball.h"
+#include "bot.h"
+#include "objective.h"
+#include "player.h"
+#include "sound.h"
+#include "arena.h"
+#include "math_util.h"
+#include "metrics.h"
+#include "platform.h"
+#include "world.h"
+
+#define MAX_BATCH_WORLDS (1024 * 1024)
+
+// every combination of these gets its own row in the report
+static const int sBallCounts[] = {1, 2, 4, 8, 16, 32, 64};
+static const float sBallMaxSpeeds[] = {150, 250, 400, 600};
+
+#define BALL_COUNT_SETTINGS ((int) (sizeof(sBallCounts) / sizeof(sBallCounts[0])))
+#define BALL_SPEED_SETTINGS ((int) (sizeof(sBallMaxSpeeds) / sizeof(sBallMaxSpeeds[0])))
+#define SETTING_COUNT (BALL_COUNT_SETTINGS * BALL_SPEED_SETTINGS)
+
+typedef struct MatchResult {
+    int tickCount;
+    int collectedObjectives;
+} MatchResult;
+
+typedef struct Batch {
+    int worldsPerSetting;
+    int worldCount;
+    atomic_int nextWorld;
+} Batch;
+
+typedef struct BatchWorker {
+    Batch *batch;
+    World world;
+} BatchWorker;
+
+static MatchResult sResults[MAX_BATCH_WORLDS];
+static int sSortedTickCounts[MAX_BATCH_WORLDS];
+static Thread sThreads[MAX_BATCH_THREADS];
+
+// each worker plays every match it takes in its own world, so a match runs start to
+// finish out of that thread's cache with no syncing between worlds
+static void RunMatch(int world, int ballCount, float ballMaxSpeed) {
+    // spread the world index out so neighbouring worlds don't get similar looking seeds
+    SeedRandom((unsigned int) (world + 1) * 2654435761u);
+    InitBot();
+    SetStartingBallCount(ballCount);
+    gWorld->balls.maxSpeed = ballMaxSpeed;
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    int tick = 0;
+    while (tick < BATCH_MAX_MATCH_TICKS && GetGameState() == GAME_STATE_PLAYING) {
+        ResetFrameArenas();
+        PlayerInput input = GetBotInput(0);
+        SimulateTick(&input);
+        tick++;
+    }
+
+    sResults[world].tickCount = tick;
+    sResults[world].collectedObjectives = gWorld->objectives.collectedCount;
+}
+
+static void RunBatchWorker(void *userData) {
+    BatchWorker *worker = userData;
+    Batch *batch = worker->batch;
+
+    InitWorld(&worker->world);
+    UseWorld(&worker->world);
+    InitFrameArenas();
+    SetSoundsMuted(true);
+    SetMetricsMuted(true);
+    SetPlayerCount(1);
+
+    // worlds are handed out one at a time, so a thread that gets short matches just takes more
+    while (true) {
+        int world = atomic_fetch_add(&batch->nextWorld, 1);
+        if (world >= batch->worldCount) {
+            break;
+        }
+
+        int setting = world / batch->worldsPerSetting;
+        RunMatch(world, sBallCounts[setting / BALL_SPEED_SETTINGS], sBallMaxSpeeds[setting % BALL_SPEED_SETTINGS]);
+    }
+}
+
+static int CompareInts(const void *a, const void *b) {
+    int left = *(const int *) a;
+    int right = *(const int *) b;
+    return (left > right) - (left < right);
+}
+
+static void ReportSetting(const Batch *batch, int setting) {
+    const MatchResult *results = &sResults[setting * batch->worldsPerSetting];
+    int count = batch->worldsPerSetting;
+    long long totalTicks = 0;
+    long long totalObjectives = 0;
+    int survivedCount = 0;
+
+    for (int i = 0; i < count; ++i) {
+        sSortedTickCounts[i] = results[i].tickCount;
+        totalTicks += results[i].tickCount;
+        totalObjectives += results[i].collectedObjectives;
+        if (results[i].tickCount == BATCH_MAX_MATCH_TICKS) {
+            survivedCount++;
+        }
+    }
+    qsort(sSortedTickCounts, count, sizeof(sSortedTickCounts[0]), CompareInts);
+
+    float tickTime = SIMULATION_TICK_TIME;
+    printf("%5d %7.0f %8.1f %7.1f %7.1f %7.1f %8.1f%% %10.1f\n",
+           sBallCounts[setting / BALL_SPEED_SETTINGS], sBallMaxSpeeds[setting % BALL_SPEED_SETTINGS],
+           (double) totalTicks / count * tickTime,
+           sSortedTickCounts[count / 10] * tickTime,
+           sSortedTickCounts[count / 2] * tickTime,
+           sSortedTickCounts[count * 9 / 10] * tickTime,
+           100.0 * survivedCount / count,
+           (double) totalObjectives / count);
+}
+
+int RunBatch(int worldsPerSetting, int threadCount) {
+    static Batch batch;
+
+    if (worldsPerSetting < 1 || worldsPerSetting * SETTING_COUNT > MAX_BATCH_WORLDS) {
+        printf("batch needs between 1 and %d worlds per setting!\n", MAX_BATCH_WORLDS / SETTING_COUNT);
+        return 1;
+    }
+    if (threadCount <= 0) {
+        threadCount = GetProcessorCount();
+    }
+    if (threadCount > MAX_BATCH_THREADS) {
+        threadCount = MAX_BATCH_THREADS;
+    }
+
+    batch.worldsPerSetting = worldsPerSetting;
+    batch.worldCount = worldsPerSetting * SETTING_COUNT;
+    atomic_init(&batch.nextWorld, 0);
+
+    printf("batch: %d worlds (%d per setting) on %d threads, matches end after %d s\n",
+           batch.worldCount, worldsPerSetting, threadCount, BATCH_MAX_MATCH_TICKS / SIMULATION_TICK_RATE);
+
+    // a world per worker is ~1.7 MB, so only as many as we'll actually run get allocated
+    BatchWorker *workers = calloc((size_t) threadCount, sizeof(BatchWorker));
+    if (workers == NULL) {
+        printf("couldn't allocate %d batch worlds!\n", threadCount);
+        return 1;
+    }
+
+    // metrics get registered the first time a world starts, which has to happen before any worker does
+    InitBot();
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    double startTime = GetMonotonicTime();
+    int startedCount = 0;
+
+    for (int i = 0; i < threadCount; ++i) {
+        workers[startedCount].batch = &batch;
+        if (StartThread(&sThreads[startedCount], RunBatchWorker, &workers[startedCount])) {
+            startedCount++;
+        }
+    }
+
+    // couldn't get any threads, do it ourselves in a worker's world and come back to ours after
+    if (startedCount == 0) {
+        workers[0].batch = &batch;
+        RunBatchWorker(&workers[0]);
+        UseWorld(GetMainWorld());
+    }
+
+    for (int i = 0; i < startedCount; ++i) {
+        JoinThread(&sThreads[i]);
+    }
+    free(workers);
+
+    double elapsedTime = GetMonotonicTime() - startTime;
+    long long totalTicks = 0;
+    for (int i = 0; i < batch.worldCount; ++i) {
+        totalTicks += sResults[i].tickCount;
+    }
+
+    printf("%lld ticks in %.2f s (%.0f ticks per second, %.0f matches per second)\n",
+           totalTicks, elapsedTime, totalTicks / elapsedTime, batch.worldCount / elapsedTime);
+    printf("balls   speed   mean s   p10 s   p50 s   p90 s  survived objectives\n");
+
+    for (int setting = 0; setting < SETTING_COUNT; ++setting) {
+        ReportSetting(&batch, setting);
+    }
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include <raylib.h>
+#include <raymath.h>
+#include <stdio.h>
+#include "bot.h"
+#include "ball.h"
+#include "bullet.h"
+#include "objective.h"
+#include "player.h"
+#include "game.h"
+#include "sound.h"
+#include "arena.h"
+#include "math_util.h"
+#include "metrics.h"
+#include "platform.h"
+#include "field.h"
+#include "world.h"
+
+// the first entry is standing still, the rest are the eight directions you can hold
+static const PlayerInput sBotMoves[] = {
+    0,
+    INPUT_UP,
+    INPUT_DOWN,
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_UP | INPUT_LEFT,
+    INPUT_UP | INPUT_RIGHT,
+    INPUT_DOWN | INPUT_LEFT,
+    INPUT_DOWN | INPUT_RIGHT,
+};
+
+static Metric sDecisionTimeMetric;
+
+static float GetHazardDanger(const Hazard *hazards, int hazardCount, Vector2 position, float time) {
+    const float playerRadius = PLAYER_HEIGHT * 0.5f;
+    float danger = 0;
+
+    for (int i = 0; i < hazardCount; ++i) {
+        const Hazard *hazard = &hazards[i];
+        Vector2 offset = Vector2Scale(hazard->velocity, time);
+        Vector2 start = Vector2Add(hazard->start, offset);
+        Vector2 end = Vector2Add(hazard->end, offset);
+
+        float clearance = sqrtf(DistanceSqrPointToSegment(position, start, end)) - hazard->radius - playerRadius;
+        if (clearance < BOT_SAFE_DISTANCE) {
+            float closeness = BOT_SAFE_DISTANCE - clearance;
+            // actually touching is worth a lot more than just being close
+            danger += closeness * closeness * (clearance < 0 ? 10 : 1);
+        }
+    }
+
+    return danger;
+}
+
+static float GetWallDanger(Vector2 position) {
+    Vector2 fieldSize = GetFieldSize();
+    float edgeDistances[4] = {position.x, fieldSize.x - position.x, position.y, fieldSize.y - position.y};
+    float danger = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        if (edgeDistances[i] < BOT_WALL_DISTANCE) {
+            float closeness = BOT_WALL_DISTANCE - edgeDistances[i];
+            danger += closeness * closeness;
+        }
+    }
+    return danger;
+}
+
+static PlayerInput ChooseBotMove(int player) {
+    BotWorld *bot = &gWorld->bot;
+    Vector2 position = GetPlayerPosition(player);
+
+    // only things that could reach us before the lookahead runs out matter
+    float lookaheadTime = BOT_LOOKAHEAD_STEPS * BOT_LOOKAHEAD_STEP_TIME;
+    float reach = lookaheadTime * (PLAYER_SPEED + gWorld->balls.maxSpeed) + BOT_SAFE_DISTANCE + BALL_SIZE;
+    Rectangle area = {position.x - reach, position.y - reach, reach * 2, reach * 2};
+
+    Arena *frameArena = GetFrameArena();
+    size_t frameArenaMarker = GetArenaMarker(frameArena);
+    Hazard *hazards = FRAME_ALLOCATE_ARRAY(Hazard, BOT_MAX_HAZARDS);
+    int hazardCount = 0;
+
+    if (hazards != NULL) {
+        hazardCount = GatherBallHazards(area, hazards, BOT_MAX_HAZARDS);
+        hazardCount += GatherBulletHazards(area, hazards + hazardCount, BOT_MAX_HAZARDS - hazardCount);
+    }
+
+    Vector2 objective;
+    bool hasObjective = GetNearestObjective(position, &objective);
+
+    PlayerInput bestMove = 0;
+    float bestCost = 0;
+    Vector2 fieldSize = GetFieldSize();
+
+    for (int i = 0; i < (int) (sizeof(sBotMoves) / sizeof(sBotMoves[0])); ++i) {
+        PlayerInput move = sBotMoves[i];
+        Vector2 velocity = Vector2Scale(GetInputDirection(move), PLAYER_SPEED);
+        Vector2 futurePosition = position;
+        float cost = 0;
+
+        for (int step = 1; step <= BOT_LOOKAHEAD_STEPS; ++step) {
+            float time = step * BOT_LOOKAHEAD_STEP_TIME;
+            futurePosition = Vector2Add(position, Vector2Scale(velocity, time));
+            futurePosition.x = Clamp(futurePosition.x, PLAYER_WIDTH * 0.5f, fieldSize.x - PLAYER_WIDTH * 0.5f);
+            futurePosition.y = Clamp(futurePosition.y, PLAYER_HEIGHT * 0.5f, fieldSize.y - PLAYER_HEIGHT * 0.5f);
+
+            // sooner trouble is more certain trouble
+            float danger = GetHazardDanger(hazards, hazardCount, futurePosition, time) + GetWallDanger(futurePosition);
+            cost += danger / (float) step;
+        }
+
+        if (hasObjective) {
+            cost += Vector2Distance(futurePosition, objective) * BOT_OBJECTIVE_WEIGHT;
+        }
+        if (move == bot->previousMoves[player]) {
+            cost -= BOT_PERSISTENCE_BONUS;
+        }
+
+        if (i == 0 || cost < bestCost) {
+            bestMove = move;
+            bestCost = cost;
+        }
+    }
+
+    RewindArenaTo(frameArena, frameArenaMarker);
+    bot->previousMoves[player] = bestMove;
+    return bestMove;
+}
+
+void InitBot() {
+    BotWorld *bot = &gWorld->bot;
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        bot->previousMoves[i] = 0;
+    }
+    bot->decisionCount = 0;
+    bot->totalDecisionTime = 0;
+    bot->maxDecisionTime = 0;
+
+    RegisterHistogram(&sDecisionTimeMetric, "pong_bot_decision_seconds", NULL, "Time the bot spends picking each tick's input.");
+}
+
+PlayerInput GetBotInput(int player) {
+    BotWorld *bot = &gWorld->bot;
+    if (GetGameState() == GAME_STATE_OVER) {
+        return INPUT_CONFIRM;
+    }
+
+    double startTime = GetMonotonicTime();
+    PlayerInput input = ChooseBotMove(player);
+    double elapsedTime = GetMonotonicTime() - startTime;
+
+    ObserveHistogram(&sDecisionTimeMetric, elapsedTime);
+    bot->decisionCount++;
+    bot->totalDecisionTime += elapsedTime;
+    if (elapsedTime > bot->maxDecisionTime) {
+        bot->maxDecisionTime = elapsedTime;
+    }
+
+    return input;
+}
+
+int RunSoakTest(int tickCount, int ballCount) {
+    BotWorld *bot = &gWorld->bot;
+    printf("soak test: %d ticks with %d balls\n", tickCount, ballCount);
+    SetSoundsMuted(true);
+    InitBot();
+    SetLocalInputSource(INPUT_SOURCE_BOT);
+    SetStartingBallCount(ballCount);
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    int gameCount = 0;
+    int leakedTickCount = 0;
+    int maxTickIndex = 0;
+    double maxTickTime = 0;
+    double startTime = GetMonotonicTime();
+
+    for (int tick = 0; tick < tickCount; ++tick) {
+        ResetFrameArenas();
+        GameState previousState = GetGameState();
+
+        PlayerInput input = TakeLocalInput(0, GetMonotonicTime());
+        double tickStartTime = GetMonotonicTime();
+        SimulateTick(&input);
+        double tickTime = GetMonotonicTime() - tickStartTime;
+
+        if (tickTime > maxTickTime) {
+            maxTickTime = tickTime;
+            maxTickIndex = tick;
+        }
+        if (previousState == GAME_STATE_PLAYING && GetGameState() == GAME_STATE_OVER) {
+            gameCount++;
+        }
+
+        // every tick is supposed to hand back all of its scratch memory
+        if (GetArenaMarker(GetFrameArena()) != 0) {
+            leakedTickCount++;
+        }
+    }
+
+    double elapsedTime = GetMonotonicTime() - startTime;
+    double averageDecisionTime = bot->decisionCount > 0 ? bot->totalDecisionTime / bot->decisionCount : 0;
+
+    printf("%d ticks in %.2f s (%.0f ticks per second)\n", tickCount, elapsedTime, tickCount / elapsedTime);
+    printf("%d games, %.1f s survived on average\n", gameCount, (double) tickCount / (gameCount + 1) / SIMULATION_TICK_RATE);
+    printf("worst tick %.3f ms (tick %d), %.4f ms per tick on average with the bot included\n", maxTickTime * 1000, maxTickIndex, elapsedTime / tickCount * 1000);
+    printf("bot decision %.2f us average, %.2f us worst\n", averageDecisionTime * 1000000, bot->maxDecisionTime * 1000000);
+    printf("%d ticks leaked frame arena memory\n", leakedTickCount);
+    ReportMemoryHighWaterMarks();
+
+    return leakedTickCount == 0 ? 0 : 1;
+}
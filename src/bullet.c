@@ -0,0 +1,153 @@
+#include <raylib.h>
+#include <raymath.h>
+#include "bullet.h"
+#include "game.h"
+#include "player.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "metrics.h"
+#include "render_list.h"
+#include "span_math.h"
+#include "fixed_math.h"
+#include "field.h"
+#include "world.h"
+
+static Metric sLiveBulletsMetric;
+
+static void RemoveBullet(int index) {
+    BulletWorld *bullets = &gWorld->bullets;
+    int last = --bullets->count;
+    bullets->positionX[index] = bullets->positionX[last];
+    bullets->positionY[index] = bullets->positionY[last];
+    bullets->velocityX[index] = bullets->velocityX[last];
+    bullets->velocityY[index] = bullets->velocityY[last];
+    bullets->size[index] = bullets->size[last];
+    bullets->color[index] = bullets->color[last];
+}
+
+void InitBullets() {
+    BulletWorld *bullets = &gWorld->bullets;
+    bullets->count = 0;
+
+    REGISTER_SNAPSHOT_ARRAY(bullets->positionX, bullets->count);
+    REGISTER_SNAPSHOT_ARRAY(bullets->positionY, bullets->count);
+    REGISTER_SNAPSHOT_ARRAY(bullets->velocityX, bullets->count);
+    REGISTER_SNAPSHOT_ARRAY(bullets->velocityY, bullets->count);
+    REGISTER_SNAPSHOT_ARRAY(bullets->size, bullets->count);
+    REGISTER_SNAPSHOT_ARRAY(bullets->color, bullets->count);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BULLETS, bullets->positionX, bullets->count);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BULLETS, bullets->positionY, bullets->count);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BULLETS, bullets->velocityX, bullets->count);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BULLETS, bullets->velocityY, bullets->count);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BULLETS, bullets->size, bullets->count);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_BULLETS, bullets->color, bullets->count);
+
+    RegisterGauge(&sLiveBulletsMetric, "pong_bullets_live", "Boss bullets currently in flight.");
+}
+
+int ReserveBullets(int count, int *firstIndex) {
+    BulletWorld *bullets = &gWorld->bullets;
+    int available = MAX_BULLETS - bullets->count;
+    if (count > available) {
+        count = available;
+    }
+    *firstIndex = bullets->count;
+    bullets->count += count;
+    return count;
+}
+
+void SetBullet(int index, Vector2 position, Vector2 velocity, float size, Color color) {
+    gWorld->bullets.positionX[index] = SIM_FROM_FLOAT(position.x);
+    gWorld->bullets.positionY[index] = SIM_FROM_FLOAT(position.y);
+    gWorld->bullets.velocityX[index] = SIM_FROM_FLOAT(velocity.x);
+    gWorld->bullets.velocityY[index] = SIM_FROM_FLOAT(velocity.y);
+    gWorld->bullets.size[index] = SIM_FROM_FLOAT(size);
+    gWorld->bullets.color[index] = color;
+}
+
+int GetBulletCount() {
+    BulletWorld *bullets = &gWorld->bullets;
+    return bullets->count;
+}
+
+void UpdateBullets(float deltaTime) {
+    BulletWorld *bullets = &gWorld->bullets;
+    int count = bullets->count;
+
+    // integrate, the arrays are already laid out for going wide
+    SimScaleAddSpan(bullets->positionX, bullets->velocityX, SIM_FROM_FLOAT(deltaTime), count);
+    SimScaleAddSpan(bullets->positionY, bullets->velocityY, SIM_FROM_FLOAT(deltaTime), count);
+
+    // cull anything that flew off the field
+    const SimScalar minX = SIM_FROM_FLOAT(-BULLET_CULL_MARGIN);
+    const SimScalar minY = SIM_FROM_FLOAT(-BULLET_CULL_MARGIN);
+    Vector2 fieldSize = GetFieldSize();
+    const SimScalar maxX = SIM_FROM_FLOAT(fieldSize.x + BULLET_CULL_MARGIN);
+    const SimScalar maxY = SIM_FROM_FLOAT(fieldSize.y + BULLET_CULL_MARGIN);
+
+    for (int i = 0; i < bullets->count; ++i) {
+        SimScalar x = bullets->positionX[i];
+        SimScalar y = bullets->positionY[i];
+        if (x < minX || x > maxX || y < minY || y > maxY) {
+            // swap-remove, then revisit this slot since it now holds a different bullet
+            RemoveBullet(i);
+            --i;
+        }
+    }
+
+    SetGauge(&sLiveBulletsMetric, bullets->count);
+
+    // cheap box reject before the exact circle test
+    for (int player = 0; player < gWorld->players.count; ++player) {
+        Rectangle playerRect = GetPlayerRect(player);
+
+        for (int i = 0; i < bullets->count; ++i) {
+            float x = SIM_TO_FLOAT(bullets->positionX[i]);
+            float y = SIM_TO_FLOAT(bullets->positionY[i]);
+            float size = SIM_TO_FLOAT(bullets->size[i]);
+            if (x + size < playerRect.x || x - size > playerRect.x + playerRect.width ||
+                y + size < playerRect.y || y - size > playerRect.y + playerRect.height) {
+                continue;
+            }
+
+            Vector2 position = {x, y};
+            if (CheckCollisionCircleRec(position, size, playerRect)) {
+                ChangeGameStateTo(GAME_STATE_OVER);
+                return;
+            }
+        }
+    }
+}
+
+int GatherBulletHazards(Rectangle area, Hazard *hazards, int capacity) {
+    BulletWorld *bullets = &gWorld->bullets;
+    int hazardCount = 0;
+    float maxX = area.x + area.width;
+    float maxY = area.y + area.height;
+
+    for (int i = 0; i < bullets->count && hazardCount < capacity; ++i) {
+        float x = SIM_TO_FLOAT(bullets->positionX[i]);
+        float y = SIM_TO_FLOAT(bullets->positionY[i]);
+        float size = SIM_TO_FLOAT(bullets->size[i]);
+        if (x + size < area.x || x - size > maxX || y + size < area.y || y - size > maxY) {
+            continue;
+        }
+
+        Vector2 position = {x, y};
+        Vector2 velocity = {SIM_TO_FLOAT(bullets->velocityX[i]), SIM_TO_FLOAT(bullets->velocityY[i])};
+        hazards[hazardCount++] = (Hazard) {position, position, velocity, size};
+    }
+
+    return hazardCount;
+}
+
+void RenderBullets() {
+    BulletWorld *bullets = &gWorld->bullets;
+    for (int i = 0; i < bullets->count; ++i) {
+        Vector2 position = {SIM_TO_FLOAT(bullets->positionX[i]), SIM_TO_FLOAT(bullets->positionY[i])};
+        if (!IsCircleInView(position, SIM_TO_FLOAT(bullets->size[i]))) {
+            continue;
+        }
+        RecordPoly(RENDER_LAYER_HAZARDS, position, BULLET_RENDER_SIDES, SIM_TO_FLOAT(bullets->size[i]), bullets->color[i]);
+    }
+}
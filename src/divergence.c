@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include "divergence.h"
+#include "game.h"
+#include "bot.h"
+#include "arena.h"
+#include "sound.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "span_math.h"
+#include "math_util.h"
+#include "platform.h"
+
+static unsigned char sReferenceWorld[WORLD_SNAPSHOT_CAPACITY];
+static unsigned char sOptimizedWorld[WORLD_SNAPSHOT_CAPACITY];
+
+// loads the world, runs one tick of it the chosen way and saves it back, returns how long the tick took
+static double AdvanceWorld(unsigned char *world, size_t *size, bool isReference, const PlayerInput *input) {
+    ResetFrameArenas();
+    LoadSnapshot(world, *size);
+    SetReferenceSimulation(isReference);
+
+    double startTime = GetMonotonicTime();
+    SimulateTick(input);
+    // both worlds have to restart the same way, or the rest of the run only checks one of them
+    if (GetGameState() == GAME_STATE_OVER) {
+        ChangeGameStateTo(GAME_STATE_PLAYING);
+    }
+    double elapsedTime = GetMonotonicTime() - startTime;
+
+    *size = SaveSnapshot(world, WORLD_SNAPSHOT_CAPACITY);
+    return elapsedTime;
+}
+
+int RunDivergenceCheck(int tickCount, int ballCount) {
+    printf("divergence check: %d ticks with %d balls, reference vs %s span math + bounds-checked trail collision\n",
+           tickCount, ballCount, GetSpanMathLevelName(GetSupportedSpanMathLevel()));
+    SetSoundsMuted(true);
+    SetMetricsMuted(true);
+    SeedRandom(1);
+    InitBot();
+    SetStartingBallCount(ballCount);
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    size_t referenceSize = SaveSnapshot(sReferenceWorld, sizeof(sReferenceWorld));
+    size_t optimizedSize = SaveSnapshot(sOptimizedWorld, sizeof(sOptimizedWorld));
+    if (referenceSize == 0 || optimizedSize == 0) {
+        printf("the starting world doesn't fit in a snapshot!\n");
+        return 1;
+    }
+
+    double referenceTime = 0;
+    double optimizedTime = 0;
+    unsigned int hash = HashSnapshot(sReferenceWorld, referenceSize);
+
+    for (int tick = 0; tick < tickCount; ++tick) {
+        // the bot only ever looks at the reference world, the optimized one gets the exact same input
+        LoadSnapshot(sReferenceWorld, referenceSize);
+        PlayerInput input = GetBotInput(0);
+
+        referenceTime += AdvanceWorld(sReferenceWorld, &referenceSize, true, &input);
+        optimizedTime += AdvanceWorld(sOptimizedWorld, &optimizedSize, false, &input);
+
+        if (referenceSize == 0 || optimizedSize == 0) {
+            printf("the world outgrew a snapshot at tick %d!\n", tick);
+            return 1;
+        }
+
+        hash = HashSnapshot(sReferenceWorld, referenceSize);
+        if (referenceSize == optimizedSize && hash == HashSnapshot(sOptimizedWorld, optimizedSize)) {
+            continue;
+        }
+
+        SnapshotDifference difference;
+        if (!FindSnapshotDifference(sReferenceWorld, sOptimizedWorld, &difference)) {
+            // only the header differed, which can't happen to two saves of the same layout
+            printf("worlds hash differently at tick %d but have the same state!\n", tick);
+        }
+        else if (difference.element >= 0) {
+            printf("worlds diverged at tick %d: %s[%d], byte %zu\n", tick, difference.regionName, difference.element, difference.offset);
+        }
+        else {
+            printf("worlds diverged at tick %d: %s, byte %zu\n", tick, difference.regionName, difference.offset);
+        }
+        SetReferenceSimulation(false);
+        return 1;
+    }
+
+    SetReferenceSimulation(false);
+    printf("%d ticks matched, final world hash %08x\n", tickCount, hash);
+    printf("reference %.1f us per tick, optimized %.1f us per tick (%.2fx)\n",
+           referenceTime / tickCount * 1000000, optimizedTime / tickCount * 1000000, referenceTime / optimizedTime);
+
+    // matching is only half of it, an optimization that loses to the reference isn't one
+    if (optimizedTime > referenceTime * (1 + DIVERGENCE_SLOWDOWN_TOLERANCE)) {
+        printf("the optimized world is slower than the reference one!\n");
+        return 1;
+    }
+    return 0;
+}
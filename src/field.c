@@ -0,0 +1,123 @@
+#include <raylib.h>
+#include <raymath.h>
+#include "field.h"
+#include "player.h"
+#include "world.h"
+
+// only the main thread renders, so the view isn't part of the world
+static Rectangle sView;
+static bool sHasView;
+
+static int ClampInt(int value, int min, int max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+void SetFieldSize(int width, int height) {
+    FieldWorld *field = &gWorld->field;
+    field->width = ClampInt(width, GAME_WIDTH, MAX_FIELD_WIDTH);
+    field->height = ClampInt(height, GAME_HEIGHT, MAX_FIELD_HEIGHT);
+}
+
+Vector2 GetFieldSize() {
+    FieldWorld *field = &gWorld->field;
+    return (Vector2) {(float) field->width, (float) field->height};
+}
+
+Vector2 GetFieldCenter() {
+    FieldWorld *field = &gWorld->field;
+    return (Vector2) {field->width / 2.0f, field->height / 2.0f};
+}
+
+Rectangle GetViewAround(Vector2 focus) {
+    FieldWorld *field = &gWorld->field;
+    Rectangle view = {
+        .x = Clamp(focus.x - GAME_WIDTH / 2.0f, 0, (float) (field->width - GAME_WIDTH)),
+        .y = Clamp(focus.y - GAME_HEIGHT / 2.0f, 0, (float) (field->height - GAME_HEIGHT)),
+        .width = GAME_WIDTH,
+        .height = GAME_HEIGHT,
+    };
+    return view;
+}
+
+static int ToChunk(float coordinate, int chunkCount) {
+    return ClampInt((int) (coordinate / FIELD_CHUNK_SIZE), 0, chunkCount - 1);
+}
+
+// marks every chunk within radius of the center chunk, keeping whichever activity is busier
+static void MarkChunks(int centerColumn, int centerRow, int radius, ChunkActivity activity) {
+    FieldWorld *field = &gWorld->field;
+    int minRow = ClampInt(centerRow - radius, 0, field->chunkRows - 1);
+    int maxRow = ClampInt(centerRow + radius, 0, field->chunkRows - 1);
+    int minColumn = ClampInt(centerColumn - radius, 0, field->chunkColumns - 1);
+    int maxColumn = ClampInt(centerColumn + radius, 0, field->chunkColumns - 1);
+
+    for (int row = minRow; row <= maxRow; ++row) {
+        for (int column = minColumn; column <= maxColumn; ++column) {
+            if (activity < field->chunkActivities[row][column]) {
+                field->chunkActivities[row][column] = (unsigned char) activity;
+            }
+        }
+    }
+}
+
+void UpdateChunkActivity() {
+    FieldWorld *field = &gWorld->field;
+    field->chunkColumns = (field->width + FIELD_CHUNK_SIZE - 1) / FIELD_CHUNK_SIZE;
+    field->chunkRows = (field->height + FIELD_CHUNK_SIZE - 1) / FIELD_CHUNK_SIZE;
+
+    for (int row = 0; row < field->chunkRows; ++row) {
+        for (int column = 0; column < field->chunkColumns; ++column) {
+            field->chunkActivities[row][column] = CHUNK_ASLEEP;
+        }
+    }
+
+    for (int i = 0; i < gWorld->players.count; ++i) {
+        Vector2 position = GetPlayerPosition(i);
+        int column = ToChunk(position.x, field->chunkColumns);
+        int row = ToChunk(position.y, field->chunkRows);
+        MarkChunks(column, row, FIELD_REDUCED_CHUNK_RADIUS, CHUNK_REDUCED);
+        MarkChunks(column, row, FIELD_ACTIVE_CHUNK_RADIUS, CHUNK_ACTIVE);
+    }
+}
+
+ChunkActivity GetChunkActivity(Vector2 position) {
+    FieldWorld *field = &gWorld->field;
+    // nothing's been worked out yet, so nothing gets left behind
+    if (field->chunkColumns == 0) {
+        return CHUNK_ACTIVE;
+    }
+    return (ChunkActivity) field->chunkActivities[ToChunk(position.y, field->chunkRows)][ToChunk(position.x, field->chunkColumns)];
+}
+
+void SetFieldView(Rectangle view) {
+    sView = view;
+    sHasView = true;
+}
+
+bool IsCircleInView(Vector2 center, float radius) {
+    if (!sHasView) {
+        return true;
+    }
+    float reach = radius + FIELD_CULL_MARGIN;
+    return center.x + reach >= sView.x && center.x - reach <= sView.x + sView.width &&
+           center.y + reach >= sView.y && center.y - reach <= sView.y + sView.height;
+}
+
+bool IsRectangleInView(Rectangle rect) {
+    if (!sHasView) {
+        return true;
+    }
+    return rect.x + rect.width + FIELD_CULL_MARGIN >= sView.x && rect.x - FIELD_CULL_MARGIN <= sView.x + sView.width &&
+           rect.y + rect.height + FIELD_CULL_MARGIN >= sView.y && rect.y - FIELD_CULL_MARGIN <= sView.y + sView.height;
+}
+
+Camera2D GetFieldCamera() {
+    // target is the view's top left, so with no offset the view lands on the whole screen
+    Camera2D camera = {
+        .offset = {0, 0},
+        .target = {sHasView ? sView.x : 0, sHasView ? sView.y : 0},
+        .rotation = 0,
+        .zoom = 1,
+    };
+    return camera;
+}
@@ -0,0 +1,245 @@
+#include <math.h>
+#include <stdbool.h>
+#include "fixed_math.h"
+
+Fixed FixedFromFloat(float value) {
+    // scaling by a power of two is exact, so the only rounding is the one we ask for
+    return (Fixed) floorf(value * FIXED_ONE + 0.5f);
+}
+
+float FixedToFloat(Fixed value) {
+    return (float) value / FIXED_ONE;
+}
+
+FixedVector2 FixedVector2FromVector2(Vector2 vector) {
+    return (FixedVector2) {FixedFromFloat(vector.x), FixedFromFloat(vector.y)};
+}
+
+Vector2 FixedVector2ToVector2(FixedVector2 vector) {
+    return (Vector2) {FixedToFloat(vector.x), FixedToFloat(vector.y)};
+}
+
+Fixed FixedMultiply(Fixed a, Fixed b) {
+    return (Fixed) (((long long) a * b) >> FIXED_FRACTION_BITS);
+}
+
+Fixed FixedDivide(Fixed a, Fixed b) {
+    if (b == 0) {
+        return 0;
+    }
+
+    // integer division truncates towards zero, step down for negative quotients that didn't divide evenly
+    long long numerator = (long long) a * FIXED_ONE;
+    long long quotient = numerator / b;
+    if ((numerator % b != 0) && ((numerator < 0) != (b < 0))) {
+        quotient--;
+    }
+    return (Fixed) quotient;
+}
+
+Fixed FixedAbs(Fixed value) {
+    return value < 0 ? -value : value;
+}
+
+Fixed FixedClamp(Fixed value, Fixed min, Fixed max) {
+    Fixed result = value < min ? min : value;
+    return result > max ? max : result;
+}
+
+Fixed FixedLerp(Fixed start, Fixed end, Fixed amount) {
+    return start + FixedMultiply(end - start, amount);
+}
+
+FixedVector2 FixedVector2Zero() {
+    return (FixedVector2) {0, 0};
+}
+
+FixedVector2 FixedVector2Add(FixedVector2 a, FixedVector2 b) {
+    return (FixedVector2) {a.x + b.x, a.y + b.y};
+}
+
+FixedVector2 FixedVector2Scale(FixedVector2 vector, Fixed scale) {
+    return (FixedVector2) {FixedMultiply(vector.x, scale), FixedMultiply(vector.y, scale)};
+}
+
+// floor(sqrt(value)), a bit at a time so there's no float anywhere near it
+static unsigned long long SquareRoot(unsigned long long value) {
+    unsigned long long result = 0;
+    unsigned long long bit = 1ull << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+Fixed FixedVector2Length(FixedVector2 vector) {
+    // the squares are 32.32, and the square root of a 32.32 number is already 16.16
+    unsigned long long lengthSqr = (unsigned long long) ((long long) vector.x * vector.x) +
+                                   (unsigned long long) ((long long) vector.y * vector.y);
+    return (Fixed) SquareRoot(lengthSqr);
+}
+
+FixedVector2 FixedVector2Normalize(FixedVector2 vector) {
+    Fixed length = FixedVector2Length(vector);
+    if (length == 0) {
+        return vector;
+    }
+    return (FixedVector2) {FixedDivide(vector.x, length), FixedDivide(vector.y, length)};
+}
+
+FixedVector2 FixedVector2Lerp(FixedVector2 start, FixedVector2 end, Fixed amount) {
+    return (FixedVector2) {FixedLerp(start.x, end.x, amount), FixedLerp(start.y, end.y, amount)};
+}
+
+FixedVector2 FixedVector2MoveTowards(FixedVector2 vector, FixedVector2 target, Fixed maxDistance) {
+    FixedVector2 offset = {target.x - vector.x, target.y - vector.y};
+    Fixed distance = FixedVector2Length(offset);
+
+    if (distance == 0 || (maxDistance >= 0 && distance <= maxDistance)) {
+        return target;
+    }
+
+    // scale by maxDistance / distance in one go, so the ratio doesn't get rounded on its own
+    return (FixedVector2) {
+        vector.x + (Fixed) ((long long) offset.x * maxDistance / distance),
+        vector.y + (Fixed) ((long long) offset.y * maxDistance / distance),
+    };
+}
+
+// sin over a quarter turn + atan over [0, 1], FIXED_TRIG_TABLE_STEPS steps each, in 16.16.
+// baked in rather than filled in with sinf + atan2f at startup, whose last bits depend on the libm
+static const Fixed sQuarterSines[FIXED_TRIG_TABLE_STEPS + 1] = {
+    0, 402, 804, 1206, 1608, 2010, 2412, 2814,
+    3216, 3617, 4019, 4420, 4821, 5222, 5623, 6023,
+    6424, 6824, 7224, 7623, 8022, 8421, 8820, 9218,
+    9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391,
+    12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534,
+    15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+    19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699,
+    22078, 22457, 22834, 23210, 23586, 23961, 24335, 24708,
+    25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+    28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+    30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347,
+    33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+    36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716,
+    39040, 39362, 39683, 40002, 40320, 40636, 40951, 41264,
+    41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+    44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056,
+    46341, 46624, 46906, 47186, 47464, 47741, 48015, 48288,
+    48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+    50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398,
+    52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+    54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+    56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607,
+    57798, 57986, 58172, 58356, 58538, 58718, 58896, 59071,
+    59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+    60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568,
+    61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596,
+    62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+    63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197,
+    64277, 64354, 64429, 64501, 64571, 64639, 64704, 64766,
+    64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+    65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436,
+    65457, 65476, 65492, 65505, 65516, 65525, 65531, 65535,
+    65536,
+};
+
+// in degrees
+static const Fixed sArcTangents[FIXED_TRIG_TABLE_STEPS + 1] = {
+    0, 14668, 29335, 44001, 58666, 73329, 87990, 102648,
+    117304, 131955, 146603, 161246, 175884, 190517, 205144, 219765,
+    234379, 248986, 263585, 278177, 292760, 307334, 321899, 336454,
+    350999, 365534, 380058, 394570, 409070, 423558, 438034, 452496,
+    466945, 481380, 495801, 510207, 524598, 538973, 553333, 567676,
+    582003, 596312, 610605, 624879, 639135, 653372, 667591, 681790,
+    695970, 710129, 724268, 738387, 752484, 766560, 780613, 794645,
+    808654, 822641, 836604, 850544, 864460, 878352, 892219, 906062,
+    919879, 933671, 947438, 961178, 974893, 988580, 1002241, 1015875,
+    1029481, 1043060, 1056611, 1070133, 1083627, 1097092, 1110529, 1123936,
+    1137313, 1150661, 1163979, 1177267, 1190524, 1203751, 1216947, 1230111,
+    1243245, 1256347, 1269417, 1282455, 1295461, 1308435, 1321376, 1334285,
+    1347161, 1360004, 1372813, 1385590, 1398332, 1411041, 1423717, 1436358,
+    1448965, 1461538, 1474076, 1486580, 1499049, 1511483, 1523882, 1536246,
+    1548575, 1560868, 1573127, 1585349, 1597536, 1609687, 1621803, 1633882,
+    1645926, 1657933, 1669904, 1681839, 1693738, 1705600, 1717426, 1729215,
+    1740967, 1752683, 1764362, 1776004, 1787610, 1799179, 1810710, 1822205,
+    1833663, 1845084, 1856467, 1867814, 1879123, 1890396, 1901631, 1912829,
+    1923990, 1935113, 1946200, 1957249, 1968261, 1979236, 1990173, 2001074,
+    2011937, 2022763, 2033552, 2044303, 2055018, 2065695, 2076336, 2086939,
+    2097505, 2108034, 2118526, 2128981, 2139399, 2149780, 2160125, 2170432,
+    2180703, 2190937, 2201134, 2211295, 2221419, 2231507, 2241558, 2251572,
+    2261551, 2271492, 2281398, 2291267, 2301101, 2310898, 2320659, 2330384,
+    2340074, 2349727, 2359345, 2368927, 2378474, 2387985, 2397460, 2406901,
+    2416306, 2425675, 2435010, 2444310, 2453574, 2462804, 2471999, 2481159,
+    2490285, 2499376, 2508433, 2517455, 2526443, 2535397, 2544317, 2553203,
+    2562055, 2570873, 2579658, 2588409, 2597126, 2605811, 2614461, 2623079,
+    2631664, 2640215, 2648734, 2657220, 2665673, 2674093, 2682482, 2690837,
+    2699161, 2707452, 2715711, 2723939, 2732134, 2740298, 2748430, 2756531,
+    2764600, 2772638, 2780644, 2788620, 2796564, 2804478, 2812361, 2820213,
+    2828035, 2835826, 2843587, 2851318, 2859019, 2866690, 2874330, 2881941,
+    2889523, 2897075, 2904597, 2912090, 2919554, 2926989, 2934395, 2941772,
+    2949120,
+};
+
+// linear between the two table entries around position, which is in 1/256ths of a step
+static Fixed LookUpTable(const Fixed *table, long long position) {
+    int index = (int) (position >> 8);
+    int fraction = (int) (position & 0xFF);
+    if (index >= FIXED_TRIG_TABLE_STEPS) {
+        return table[FIXED_TRIG_TABLE_STEPS];
+    }
+    return table[index] + (Fixed) (((long long) (table[index + 1] - table[index]) * fraction) >> 8);
+}
+
+Fixed FixedSinDegrees(Fixed degrees) {
+    const long long quarterTurn = 90ll * FIXED_ONE;
+    long long angle = degrees % (4 * quarterTurn);
+    if (angle < 0) {
+        angle += 4 * quarterTurn;
+    }
+
+    // the table covers the first quarter, the others are mirrors of it
+    int quarter = (int) (angle / quarterTurn);
+    long long offset = angle % quarterTurn;
+    if (quarter == 1 || quarter == 3) {
+        offset = quarterTurn - offset;
+    }
+    Fixed sine = LookUpTable(sQuarterSines, offset * FIXED_TRIG_TABLE_STEPS * 256 / quarterTurn);
+    return quarter >= 2 ? -sine : sine;
+}
+
+Fixed FixedCosDegrees(Fixed degrees) {
+    return FixedSinDegrees(degrees + 90 * FIXED_ONE);
+}
+
+Fixed FixedAtan2Degrees(Fixed y, Fixed x) {
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+
+    // atan of the smaller side over the bigger one is always in [0, 45], the octant does the rest
+    long long absX = x < 0 ? -(long long) x : x;
+    long long absY = y < 0 ? -(long long) y : y;
+    bool isSteep = absY > absX;
+    long long ratio = isSteep ? (absX << 16) / absY : (absY << 16) / absX;
+    Fixed angle = LookUpTable(sArcTangents, ratio * FIXED_TRIG_TABLE_STEPS / 256);
+
+    if (isSteep) {
+        angle = 90 * FIXED_ONE - angle;
+    }
+    if (x < 0) {
+        angle = 180 * FIXED_ONE - angle;
+    }
+    return y < 0 ? -angle : angle;
+}
@@ -0,0 +1,159 @@
+#include <raylib.h>
+#include <stdio.h>
+#include "frame_pacer.h"
+#include "input.h"
+#include "metrics.h"
+#include "platform.h"
+
+static double sFrameTime; // in seconds, 0 when we don't wait at all
+static bool sIsIdle;
+static double sLastDeadline;
+static FramePacerStats sStats;
+
+// the worst overshoot out of the last few sleeps is how early we stop sleeping + start spinning
+static double sOvershootSamples[SLEEP_OVERSHOOT_SAMPLES];
+static int sOvershootSampleIndex;
+
+static Metric sMissedDeadlinesMetric;
+static Metric sLatenessMetric;
+
+void InitFramePacer(int targetFps) {
+    // headless modes have no window, so no monitor to ask
+    if (targetFps == 0) {
+        int refreshRate = IsWindowReady() ? GetMonitorRefreshRate(GetCurrentMonitor()) : 0;
+        targetFps = refreshRate > 0 ? refreshRate : FALLBACK_TARGET_FPS;
+    }
+
+    sFrameTime = targetFps > 0 ? 1.0 / targetFps : 0;
+    sLastDeadline = GetMonotonicTime();
+
+    // start pessimistic, a typical desktop scheduler tick
+    for (int i = 0; i < SLEEP_OVERSHOOT_SAMPLES; ++i) {
+        sOvershootSamples[i] = 0.001;
+    }
+    sStats.sleepOvershoot = 0.001;
+
+    RegisterCounter(&sMissedDeadlinesMetric, "pong_frame_deadlines_missed_total", "Frames that took longer than the target frame time.");
+    RegisterHistogram(&sLatenessMetric, "pong_frame_wake_lateness_seconds", NULL, "How far past each frame deadline the pacer woke up.");
+}
+
+void SetFramePacerIdle(bool isIdle) {
+    sIsIdle = isIdle;
+}
+
+static void RecordSleepOvershoot(double overshoot) {
+    sOvershootSamples[sOvershootSampleIndex] = overshoot;
+    sOvershootSampleIndex = (sOvershootSampleIndex + 1) % SLEEP_OVERSHOOT_SAMPLES;
+
+    double worstOvershoot = 0;
+    for (int i = 0; i < SLEEP_OVERSHOOT_SAMPLES; ++i) {
+        if (sOvershootSamples[i] > worstOvershoot) {
+            worstOvershoot = sOvershootSamples[i];
+        }
+    }
+    sStats.sleepOvershoot = worstOvershoot;
+}
+
+// headless runs pace frames too, but there's no window to ask
+static void PollWindowInput() {
+    if (IsWindowReady()) {
+        PollInputEvents();
+    }
+}
+
+static void SleepUntil(double deadline) {
+    double sleepTime = deadline - GetMonotonicTime() - sStats.sleepOvershoot - MIN_SPIN_TIME;
+    if (sleepTime <= 0) {
+        return;
+    }
+
+    double startTime = GetMonotonicTime();
+    SleepSeconds(sleepTime);
+    double sleptTime = GetMonotonicTime() - startTime;
+    RecordSleepOvershoot(sleptTime - sleepTime);
+    sStats.totalSleepTime += sleptTime;
+}
+
+// only the keyboard shows up as window events, bots + synthetic input need frames to keep coming
+static bool CanWaitForWindowEvents() {
+    return IsWindowReady() && GetLocalInputSource() == INPUT_SOURCE_KEYBOARD;
+}
+
+// idle screens only change when a key does, so sleep until the window has something for us
+static void WaitForWindowEvent() {
+    if (!HasLatchedKeyPress() && !HasPressedLocalInput()) {
+        double startTime = GetMonotonicTime();
+        EnableEventWaiting();
+        PollInputEvents();
+        DisableEventWaiting();
+        sStats.totalSleepTime += GetMonotonicTime() - startTime;
+    }
+    PollLocalInput();
+}
+
+static void SpinUntil(double deadline) {
+    double startTime = GetMonotonicTime();
+    double now = startTime;
+
+    while (now < deadline) {
+        now = GetMonotonicTime();
+    }
+    sStats.totalSpinTime += now - startTime;
+}
+
+void WaitForNextFrame() {
+    // raylib polled input at the end of EndDrawing, grab any presses before we poll over the top of them below
+    PollLocalInput();
+
+    if (sFrameTime == 0) {
+        return;
+    }
+
+    if (sIsIdle && CanWaitForWindowEvents()) {
+        WaitForWindowEvent();
+        // the next frame's deadline counts from whatever woke us up
+        sLastDeadline = GetMonotonicTime();
+        return;
+    }
+
+    double frameTime = sIsIdle ? 1.0 / IDLE_TARGET_FPS : sFrameTime;
+    double deadline = sLastDeadline + frameTime;
+    double now = GetMonotonicTime();
+    sStats.frameCount++;
+
+    if (now > deadline) {
+        // too late to make this one, start the next frame right away rather than rushing to catch up
+        sStats.missedDeadlineCount++;
+        AddToCounter(&sMissedDeadlinesMetric, 1);
+        sLastDeadline = now;
+    }
+    else {
+        SleepUntil(deadline);
+        SpinUntil(deadline);
+        double lateness = GetMonotonicTime() - deadline;
+        ObserveHistogram(&sLatenessMetric, lateness);
+        if (lateness > sStats.worstLateness) {
+            sStats.worstLateness = lateness;
+        }
+        sLastDeadline = deadline;
+    }
+
+    // sample input as late as possible so waiting doesn't add to input latency
+    PollWindowInput();
+    PollLocalInput();
+}
+
+FramePacerStats GetFramePacerStats() {
+    return sStats;
+}
+
+void ReportFramePacerStats() {
+    if (sStats.frameCount == 0) {
+        return;
+    }
+
+    double totalWaitTime = sStats.totalSleepTime + sStats.totalSpinTime;
+    printf("frame pacer: %d frames, %d missed (%.1f%%), woke up at worst %.3f ms late, %.0f%% of waiting spent asleep\n",
+           sStats.frameCount, sStats.missedDeadlineCount, 100.0 * sStats.missedDeadlineCount / sStats.frameCount,
+           sStats.worstLateness * 1000, totalWaitTime > 0 ? 100.0 * sStats.totalSleepTime / totalWaitTime : 0.0);
+}
@@ -1,73 +1,400 @@
 #include <raylib.h>
+#include <stdio.h>
 #include "sound.h"
 #include "game.h"
 #include "ball.h"
 #include "objective.h"
 #include "player.h"
 #include "particles.h"
+#include "arena.h"
+#include "bullet.h"
+#include "pattern.h"
+#include "snapshot.h"
+#include "netplay.h"
+#include "platform.h"
+#include "metrics.h"
+#include "frame_pacer.h"
+#include "input_latency.h"
+#include "render_list.h"
+#include "span_math.h"
+#include "rewind.h"
+#include "field.h"
+#include "spectator.h"
+#include "memory_usage.h"
+#include "timer_wheel.h"
+#include "world.h"
 
-static GameState sCurrentGameState;
+#define QUICK_SAVE_PATH "quicksave.bin"
+
+typedef enum Subsystem {
+    SUBSYSTEM_PLAYERS,
+    SUBSYSTEM_BALLS,
+    SUBSYSTEM_OBJECTIVES,
+    SUBSYSTEM_PARTICLES,
+    SUBSYSTEM_BULLETS,
+    SUBSYSTEM_PATTERNS,
+    SUBSYSTEM_RENDER,
+    SUBSYSTEM_COUNT,
+} Subsystem;
+
+static float sTickAccumulator;
+static int sInspectedRewindTick = -1; // the rewind tick being looked at, -1 while the game runs normally
+
+// the world a restart builds, made ahead of time while the game over screen is up.
+// only the main world ever has one prepared (workers never see isRestartPrepared set), and
+// the key in GameWorld makes sure nothing has swapped the world out or changed the settings since
+static unsigned char sRestartWorld[WORLD_SNAPSHOT_CAPACITY];
+static unsigned char sGameOverWorld[WORLD_SNAPSHOT_CAPACITY];
+static size_t sRestartWorldSize;
+
+static Metric sFrameTimeMetric;
+static Metric sPreparedRestartTimeMetric;
+static Metric sBuiltRestartTimeMetric;
+static Metric sSubsystemTimeMetrics[SUBSYSTEM_COUNT];
+
+static void InitGameMetrics() {
+    RegisterHistogram(&sFrameTimeMetric, "pong_frame_seconds", NULL, "Time between frames.");
+    RegisterHistogram(&sPreparedRestartTimeMetric, "pong_restart_seconds", "world=\"prepared\"", "Time spent starting a match.");
+    RegisterHistogram(&sBuiltRestartTimeMetric, "pong_restart_seconds", "world=\"built\"", "Time spent starting a match.");
+
+    const char *help = "Time spent in each subsystem per tick (or per frame for rendering).";
+    RegisterHistogram(&sSubsystemTimeMetrics[SUBSYSTEM_PLAYERS], "pong_subsystem_seconds", "subsystem=\"players\"", help);
+    RegisterHistogram(&sSubsystemTimeMetrics[SUBSYSTEM_BALLS], "pong_subsystem_seconds", "subsystem=\"balls\"", help);
+    RegisterHistogram(&sSubsystemTimeMetrics[SUBSYSTEM_OBJECTIVES], "pong_subsystem_seconds", "subsystem=\"objectives\"", help);
+    RegisterHistogram(&sSubsystemTimeMetrics[SUBSYSTEM_PARTICLES], "pong_subsystem_seconds", "subsystem=\"particles\"", help);
+    RegisterHistogram(&sSubsystemTimeMetrics[SUBSYSTEM_BULLETS], "pong_subsystem_seconds", "subsystem=\"bullets\"", help);
+    RegisterHistogram(&sSubsystemTimeMetrics[SUBSYSTEM_PATTERNS], "pong_subsystem_seconds", "subsystem=\"patterns\"", help);
+    RegisterHistogram(&sSubsystemTimeMetrics[SUBSYSTEM_RENDER], "pong_subsystem_seconds", "subsystem=\"render\"", help);
+}
+
+// subsystems run back to back, so one clock read both ends the last one and starts the next
+static void StartSubsystemTimer() {
+    GameWorld *game = &gWorld->game;
+    game->subsystemStartTime = GetMonotonicTime();
+}
+
+static void EndSubsystemTimer(Subsystem subsystem) {
+    GameWorld *game = &gWorld->game;
+    double now = GetMonotonicTime();
+    ObserveHistogram(&sSubsystemTimeMetrics[subsystem], now - game->subsystemStartTime);
+    game->subsystemStartTime = now;
+}
+
+static void HandleQuickSaveKeys() {
+    // the other player wouldn't load it too, so this is single player only
+    if (IsNetplayActive()) {
+        return;
+    }
+
+    if (TakeKeyPress(KEY_F5)) {
+        double startTime = GetMonotonicTime();
+        bool isSaved = SaveSnapshotToFile(QUICK_SAVE_PATH);
+        printf(isSaved ? "quick saved in %.3f ms\n" : "quick save failed!\n", (GetMonotonicTime() - startTime) * 1000);
+    }
+
+    if (TakeKeyPress(KEY_F9)) {
+        double startTime = GetMonotonicTime();
+        bool isLoaded = LoadSnapshotFromFile(QUICK_SAVE_PATH);
+        printf(isLoaded ? "quick loaded in %.3f ms\n" : "quick load failed!\n", (GetMonotonicTime() - startTime) * 1000);
+        if (isLoaded) {
+            ResetRewind();
+            sInspectedRewindTick = -1;
+        }
+    }
+}
+
+// once the game's over, left + right step back through the last few seconds a tick at a time.
+// backspace plays on from the tick being looked at, or from REWIND_INSTANT_SECONDS ago mid match
+static void HandleRewindKeys() {
+    // same as quick loads, the other player's world wouldn't go back with ours
+    if (IsNetplayActive() || GetNewestRewindTick() < 0) {
+        return;
+    }
+
+    bool isInspecting = sInspectedRewindTick != -1;
+    int oldestTick = GetOldestRewindTick();
+    int newestTick = GetNewestRewindTick();
+
+    if ((isInspecting || gWorld->game.currentState == GAME_STATE_OVER) && TakeKeyPress(KEY_LEFT)) {
+        int tick = (isInspecting ? sInspectedRewindTick : newestTick) - 1;
+        if (tick >= oldestTick && SeekRewind(tick)) {
+            sInspectedRewindTick = tick;
+        }
+    }
+
+    if (isInspecting && TakeKeyPress(KEY_RIGHT)) {
+        int tick = sInspectedRewindTick + 1;
+        if (SeekRewind(tick)) {
+            // the newest tick is the world we started looking back from, so that's the end of it
+            sInspectedRewindTick = tick == newestTick ? -1 : tick;
+        }
+    }
+
+    if (TakeKeyPress(KEY_BACKSPACE)) {
+        int tick = isInspecting ? sInspectedRewindTick : newestTick - REWIND_INSTANT_SECONDS * SIMULATION_TICK_RATE;
+        tick = tick < oldestTick ? oldestTick : tick;
+        if (SeekRewind(tick)) {
+            TruncateRewind(tick);
+            sInspectedRewindTick = -1;
+            sTickAccumulator = 0;
+        }
+    }
+}
+
+static void BuildStartingWorld() {
+    GameWorld *game = &gWorld->game;
+    InitGameMetrics();
+    // everything below schedules its first timers straight away
+    InitTimers();
+    InitPlayers();
+    InitObjectives();
+    InitBalls();
+    InitParticles();
+    InitBullets();
+    InitPatterns();
+    for (int i = 0; i < game->startingBallCount; ++i) {
+        SpawnBall();
+    }
+}
+
+static bool IsRestartPrepared() {
+    GameWorld *game = &gWorld->game;
+    return game->isRestartPrepared && game->restartSnapshotLoadCount == GetSnapshotLoadCount() &&
+           game->restartBallCount == game->startingBallCount && game->restartPlayerCount == gWorld->players.count;
+}
+
+// nothing moves during game over, so the world a restart will build is already known.
+// build it now, keep a copy, then put the game over world back like nothing happened
+static void PrepareRestart() {
+    GameWorld *game = &gWorld->game;
+    if (IsRestartPrepared()) {
+        return;
+    }
+
+    size_t gameOverWorldSize = SaveSnapshot(sGameOverWorld, sizeof(sGameOverWorld));
+    if (gameOverWorldSize == 0) {
+        return;
+    }
+
+    SetMetricsMuted(true);
+    game->currentState = GAME_STATE_PLAYING;
+    BuildStartingWorld();
+    sRestartWorldSize = SaveSnapshot(sRestartWorld, sizeof(sRestartWorld));
+    bool isRestored = LoadSnapshot(sGameOverWorld, gameOverWorldSize);
+    SetMetricsMuted(false);
+
+    // everything registers itself the first time a match starts, so the layout can't have changed since
+    if (!isRestored) {
+        printf("couldn't put the game over world back after preparing a restart!\n");
+    }
+
+    game->isRestartPrepared = isRestored && sRestartWorldSize != 0;
+    game->restartSnapshotLoadCount = GetSnapshotLoadCount();
+    game->restartBallCount = game->startingBallCount;
+    game->restartPlayerCount = gWorld->players.count;
+    PrewarmTrackedAllocators();
+}
 
 void RunGame() {
-    switch (sCurrentGameState) {
+    GameWorld *game = &gWorld->game;
+    // everything transient from last frame is thrown away in one go
+    ResetFrameArenas();
+    PollLocalInput();
+    HandleQuickSaveKeys();
+    HandleRewindKeys();
+    HandleInputLatencyKeys();
+    ClearKeyPresses();
+    PollMetricsServer();
+    ObserveHistogram(&sFrameTimeMetric, GetFrameTime());
+
+    if (IsSpectating()) {
+        UpdateSpectating();
+    }
+    else if (IsNetplayActive()) {
+        UpdateNetplay(GetFrameTime());
+    }
+    else if (sInspectedRewindTick == -1) {
+        // fixed ticks keep the simulation identical no matter the frame rate
+        sTickAccumulator += GetFrameTime();
+        int tickCount = 0;
+        double now = GetMonotonicTime();
+
+        while (sTickAccumulator >= SIMULATION_TICK_TIME && tickCount < MAX_TICKS_PER_FRAME) {
+            // each tick stands for its own slice of the time that's built up, and only takes the input from it
+            PlayerInput input = TakeLocalInput(0, GetTickEndTime(now, sTickAccumulator));
+            GameState previousState = game->currentState;
+            SimulateTick(&input);
+            sTickAccumulator -= SIMULATION_TICK_TIME;
+
+            if (previousState == GAME_STATE_PLAYING) {
+                RecordRewindTick();
+            }
+            else if (game->currentState == GAME_STATE_PLAYING) {
+                // a new match, nothing before it is worth going back to
+                ResetRewind();
+            }
+            tickCount++;
+        }
+
+        // too far behind to catch up, drop the debt rather than spiral
+        if (tickCount == MAX_TICKS_PER_FRAME) {
+            sTickAccumulator = 0;
+        }
+    }
+
+    PublishSpectatorWorld();
+
+    StartSubsystemTimer();
+    RenderGame();
+    RecordFramePresented();
+    EndSubsystemTimer(SUBSYSTEM_RENDER);
+
+    // nothing moves on the game over screen, but the other player still needs our inputs during netplay
+    SetFramePacerIdle(game->currentState == GAME_STATE_OVER && !IsNetplayActive());
+
+    if (game->currentState == GAME_STATE_OVER) {
+        PrepareRestart();
+    }
+}
+
+void SimulateTick(const PlayerInput *inputs) {
+    GameWorld *game = &gWorld->game;
+    // rollback can run a bunch of ticks in one frame, so scratch memory is per tick
+    Arena *frameArena = GetFrameArena();
+    size_t frameArenaMarker = GetArenaMarker(frameArena);
+
+    switch (game->currentState) {
         case GAME_STATE_PLAYING: {
-            // update
-            float deltaTime = GetFrameTime();
-            UpdatePlayer(deltaTime);
+            float deltaTime = SIMULATION_TICK_TIME;
+            UpdateChunkActivity();
+            AdvanceTimers();
+            StartSubsystemTimer();
+            for (int i = 0; i < gWorld->players.count; ++i) {
+                UpdatePlayer(i, inputs[i], deltaTime);
+            }
+            EndSubsystemTimer(SUBSYSTEM_PLAYERS);
             UpdateBalls(deltaTime);
+            EndSubsystemTimer(SUBSYSTEM_BALLS);
             UpdateObjectives(deltaTime);
+            EndSubsystemTimer(SUBSYSTEM_OBJECTIVES);
             UpdateParticles(deltaTime);
+            EndSubsystemTimer(SUBSYSTEM_PARTICLES);
+            UpdateBullets(deltaTime);
+            EndSubsystemTimer(SUBSYSTEM_BULLETS);
+            UpdatePatterns(deltaTime);
+            EndSubsystemTimer(SUBSYSTEM_PATTERNS);
+            SampleStaticArrayOccupancy();
+            break;
+        }
 
-            // render
+        case GAME_STATE_OVER:
+            // anyone can restart
+            for (int i = 0; i < gWorld->players.count; ++i) {
+                if (inputs[i] & INPUT_CONFIRM) {
+                    PlayGameSound(GAME_SOUND_RESTART);
+                    ChangeGameStateTo(GAME_STATE_PLAYING);
+                    break;
+                }
+            }
+            break;
+    }
+
+    RewindArenaTo(frameArena, frameArenaMarker);
+}
+
+void RecordGameWorld() {
+    RenderObjectives();
+    RenderParticles();
+    RenderBalls();
+    RenderBullets();
+    RenderPlayers();
+}
+
+void RenderGame() {
+    GameWorld *game = &gWorld->game;
+    switch (game->currentState) {
+        case GAME_STATE_PLAYING: {
             BeginDrawing();
             ClearBackground(BLACK);
-            RenderObjectives();
-            RenderParticles();
-            RenderBalls();
-            RenderPlayer();
+            RenderScore();
+
+            // the world scrolls along with our player, everything else stays put on screen
+            SetFieldView(GetViewAround(GetPlayerPosition(GetLocalPlayer())));
+            RecordGameWorld();
+            BeginMode2D(GetFieldCamera());
+            SubmitRenderList(&gRaylibRenderBackend);
+            EndMode2D();
+            if (sInspectedRewindTick != -1) {
+                float secondsBack = (float) (GetNewestRewindTick() - sInspectedRewindTick) / SIMULATION_TICK_RATE;
+                DrawText(TextFormat("%.2f s back, backspace to play on from here", secondsBack), 10, GAME_HEIGHT - 30, 20, GRAY);
+            }
+            RenderNetplayStatus();
+            RenderInputLatencyOverlay();
             EndDrawing();
             break;
         }
 
         case GAME_STATE_OVER:
-            // update
-            if (IsKeyPressed(KEY_ENTER)) {
-                PlaySound(gRestartSound);
-                ChangeGameStateTo(GAME_STATE_PLAYING);
-            }
-
-            // render
             BeginDrawing();
             ClearBackground(BLACK);
             DrawText("GAME OVER", GAME_WIDTH / 2, GAME_HEIGHT / 2, 40, WHITE);
             DrawText("press enter to restart", GAME_WIDTH / 2, (GAME_HEIGHT / 2) + 40, 20, WHITE);
+            if (!IsNetplayActive() && GetNewestRewindTick() >= 0) {
+                DrawText("left arrow to look back", GAME_WIDTH / 2, (GAME_HEIGHT / 2) + 60, 20, GRAY);
+            }
+            RenderNetplayStatus();
+            RenderInputLatencyOverlay();
             EndDrawing();
             break;
     }
 }
 
+GameState GetGameState() {
+    GameWorld *game = &gWorld->game;
+    return game->currentState;
+}
+
+void SetStartingBallCount(int count) {
+    GameWorld *game = &gWorld->game;
+    game->startingBallCount = count;
+}
+
+void SetReferenceSimulation(bool isReference) {
+    gWorld->game.isReferenceSimulation = isReference;
+    SetSpanMathLevel(isReference ? SPAN_MATH_SCALAR : GetSupportedSpanMathLevel());
+}
+
+bool IsReferenceSimulation() {
+    return gWorld->game.isReferenceSimulation;
+}
+
 void ChangeGameStateTo(GameState newState) {
-    sCurrentGameState = newState;
+    GameWorld *game = &gWorld->game;
+    double startTime = GetMonotonicTime();
+
+    // same world either way, the prepared one is just a copy instead of a rebuild
+    if (newState == GAME_STATE_PLAYING && IsRestartPrepared() && LoadSnapshot(sRestartWorld, sRestartWorldSize)) {
+        game->isRestartPrepared = false;
+        ObserveHistogram(&sPreparedRestartTimeMetric, GetMonotonicTime() - startTime);
+        return;
+    }
+
+    game->isRestartPrepared = false;
+    game->currentState = newState;
+    REGISTER_SNAPSHOT_VARIABLE(game->currentState);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_SNAPSHOTS, sRestartWorld);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_SNAPSHOTS, sGameOverWorld);
 
-    switch (sCurrentGameState) {
+    switch (game->currentState) {
         case GAME_STATE_PLAYING:
-            InitPlayer();
-            InitObjectives();
-            InitBalls();
-            SpawnBall();
-            SpawnBall();
-            SpawnBall();
-            SpawnBall();
-            SpawnBall();
-            SpawnBall();
-            SpawnBall();
-            SpawnBall();
+            BuildStartingWorld();
+            ObserveHistogram(&sBuiltRestartTimeMetric, GetMonotonicTime() - startTime);
             break;
         case GAME_STATE_OVER:
-            if (gCollectedObjectives > gHighScoreObjectives) {
-                gHighScoreObjectives = gCollectedObjectives;
+            if (gWorld->objectives.collectedCount > gWorld->objectives.highScore) {
+                gWorld->objectives.highScore = gWorld->objectives.collectedCount;
             }
-            PlaySound(gRestartSound);
+            PlayGameSound(GAME_SOUND_RESTART);
             break;
     }
 }
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdatomic.h>
+#include <raylib.h>
+#include <raymath.h>
+#include "input.h"
+#include "bot.h"
+#include "input_latency.h"
+#include "platform.h"
+#include "game.h"
+
+typedef struct KeyBinding {
+    int key;
+    PlayerInputButton button;
+} KeyBinding;
+
+static const KeyBinding sKeyBindings[] = {
+    {KEY_W, INPUT_UP},
+    {KEY_UP, INPUT_UP},
+    {KEY_S, INPUT_DOWN},
+    {KEY_DOWN, INPUT_DOWN},
+    {KEY_A, INPUT_LEFT},
+    {KEY_LEFT, INPUT_LEFT},
+    {KEY_D, INPUT_RIGHT},
+    {KEY_RIGHT, INPUT_RIGHT},
+};
+
+static InputSource sLocalInputSource;
+
+// single producer (the main thread for the keyboard, the sampling thread for synthetic input)
+// single consumer (whoever runs ticks)
+static InputEvent sEventQueue[INPUT_EVENT_QUEUE_CAPACITY];
+static atomic_uint sEventWriteIndex;
+static atomic_uint sEventReadIndex;
+static atomic_int sDroppedEventCount;
+
+// what the producer last managed to queue, a change that didn't fit gets tried again next sample
+static PlayerInput sQueuedInput;
+// what the consumer has seen so far
+static PlayerInput sHeldInput;
+static double sLastEventTime;
+
+// keys that went down since game code last looked, whatever the input source. the frame pacer
+// polls raylib again after EndDrawing has, which starts IsKeyPressed over, so edges get kept here instead
+static int sLatchedKeys[MAX_LATCHED_KEYS];
+static int sLatchedKeyCount;
+
+static Thread sSamplingThread;
+static atomic_bool sIsSampling;
+static double sSyntheticStartTime;
+
+static bool PushInputEvent(double time, PlayerInputButton button, bool isDown) {
+    unsigned int writeIndex = atomic_load_explicit(&sEventWriteIndex, memory_order_relaxed);
+    unsigned int readIndex = atomic_load_explicit(&sEventReadIndex, memory_order_acquire);
+    if (writeIndex - readIndex == INPUT_EVENT_QUEUE_CAPACITY) {
+        atomic_fetch_add_explicit(&sDroppedEventCount, 1, memory_order_relaxed);
+        return false;
+    }
+
+    sEventQueue[writeIndex & (INPUT_EVENT_QUEUE_CAPACITY - 1)] = (InputEvent) {.time = time, .button = button, .isDown = isDown};
+    // publishes the event written above
+    atomic_store_explicit(&sEventWriteIndex, writeIndex + 1, memory_order_release);
+    return true;
+}
+
+// queues a down or up for every button that differs from what was queued last
+static void QueueInputChanges(double time, PlayerInput heldInput) {
+    for (PlayerInput button = INPUT_UP; button <= INPUT_RIGHT; button <<= 1) {
+        bool isDown = (heldInput & button) != 0;
+        if (isDown != ((sQueuedInput & button) != 0) && PushInputEvent(time, button, isDown)) {
+            sQueuedInput ^= button;
+        }
+    }
+}
+
+static void RunSyntheticSampling(void *userData) {
+    (void) userData;
+    int flipCount = -1;
+
+    while (atomic_load(&sIsSampling)) {
+        int dueFlipCount = (int) ((GetMonotonicTime() - sSyntheticStartTime) / SYNTHETIC_INPUT_PERIOD);
+
+        // we know exactly when the flip was due, which is the part of the latency a poll can't see
+        if (dueFlipCount != flipCount) {
+            flipCount = dueFlipCount;
+            QueueInputChanges(sSyntheticStartTime + flipCount * SYNTHETIC_INPUT_PERIOD, (flipCount % 2 == 0) ? INPUT_UP : INPUT_DOWN);
+        }
+        SleepSeconds(1.0 / INPUT_SAMPLE_RATE);
+    }
+}
+
+void StopInputSampling() {
+    if (atomic_load(&sIsSampling)) {
+        atomic_store(&sIsSampling, false);
+        JoinThread(&sSamplingThread);
+    }
+
+    int droppedEventCount = atomic_exchange(&sDroppedEventCount, 0);
+    if (droppedEventCount > 0) {
+        printf("%d input events didn't fit in the queue!\n", droppedEventCount);
+    }
+}
+
+void SetLocalInputSource(InputSource source) {
+    // the queue only has room for one producer, so the old one has to stop before anything's reset
+    StopInputSampling();
+    sLocalInputSource = source;
+    atomic_store(&sEventWriteIndex, 0);
+    atomic_store(&sEventReadIndex, 0);
+    sQueuedInput = 0;
+    sHeldInput = 0;
+
+    if (source == INPUT_SOURCE_SYNTHETIC) {
+        sSyntheticStartTime = GetMonotonicTime();
+        atomic_store(&sIsSampling, true);
+        if (!StartThread(&sSamplingThread, RunSyntheticSampling, NULL)) {
+            atomic_store(&sIsSampling, false);
+            printf("couldn't start the input sampling thread, synthetic input won't change!\n");
+        }
+    }
+}
+
+InputSource GetLocalInputSource() {
+    return sLocalInputSource;
+}
+
+static void LatchKeyPress(int key) {
+    for (int i = 0; i < sLatchedKeyCount; ++i) {
+        if (sLatchedKeys[i] == key) {
+            return;
+        }
+    }
+    if (sLatchedKeyCount < MAX_LATCHED_KEYS) {
+        sLatchedKeys[sLatchedKeyCount++] = key;
+    }
+}
+
+void PollLocalInput() {
+    // headless runs have no window to have pressed keys in
+    if (!IsWindowReady()) {
+        return;
+    }
+
+    bool isKeyboard = sLocalInputSource == INPUT_SOURCE_KEYBOARD;
+
+    // raylib doesn't timestamp key events, so the poll that sees a change is as early as we can know about it
+    double time = GetMonotonicTime();
+    PlayerInput heldInput = 0;
+    int bindingCount = isKeyboard ? sizeof(sKeyBindings) / sizeof(sKeyBindings[0]) : 0;
+
+    for (int i = 0; i < bindingCount; ++i) {
+        if (IsKeyDown(sKeyBindings[i].key)) {
+            heldInput |= sKeyBindings[i].button;
+        }
+    }
+
+    // raylib queues every key that went down since the last poll, even ones that are already back up
+    int key;
+    while ((key = GetKeyPressed()) != 0) {
+        LatchKeyPress(key);
+
+        if (isKeyboard && key == KEY_ENTER) {
+            // confirm only ever gets pressed, never held
+            if (PushInputEvent(time, INPUT_CONFIRM, true)) {
+                PushInputEvent(time, INPUT_CONFIRM, false);
+            }
+            continue;
+        }
+
+        for (int i = 0; i < bindingCount; ++i) {
+            PlayerInputButton button = sKeyBindings[i].button;
+            if (sKeyBindings[i].key == key && !(heldInput & button) && !(sQueuedInput & button)) {
+                if (PushInputEvent(time, button, true)) {
+                    PushInputEvent(time, button, false);
+                }
+            }
+        }
+    }
+
+    if (isKeyboard) {
+        QueueInputChanges(time, heldInput);
+    }
+}
+
+bool TakeKeyPress(int key) {
+    for (int i = 0; i < sLatchedKeyCount; ++i) {
+        if (sLatchedKeys[i] == key) {
+            sLatchedKeys[i] = sLatchedKeys[--sLatchedKeyCount];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HasLatchedKeyPress() {
+    return sLatchedKeyCount > 0;
+}
+
+void ClearKeyPresses() {
+    sLatchedKeyCount = 0;
+}
+
+bool HasPressedLocalInput() {
+    unsigned int readIndex = atomic_load_explicit(&sEventReadIndex, memory_order_relaxed);
+    unsigned int writeIndex = atomic_load_explicit(&sEventWriteIndex, memory_order_acquire);
+
+    for (; readIndex != writeIndex; ++readIndex) {
+        const InputEvent *event = &sEventQueue[readIndex & (INPUT_EVENT_QUEUE_CAPACITY - 1)];
+        if (event->button == INPUT_CONFIRM && event->isDown) {
+            return true;
+        }
+    }
+    return false;
+}
+
+PlayerInput TakeLocalInput(int player, double tickEndTime) {
+    if (sLocalInputSource == INPUT_SOURCE_BOT) {
+        return GetBotInput(player);
+    }
+
+    unsigned int readIndex = atomic_load_explicit(&sEventReadIndex, memory_order_relaxed);
+    unsigned int writeIndex = atomic_load_explicit(&sEventWriteIndex, memory_order_acquire);
+    PlayerInput pressedInput = 0;
+
+    for (; readIndex != writeIndex; ++readIndex) {
+        const InputEvent *event = &sEventQueue[readIndex & (INPUT_EVENT_QUEUE_CAPACITY - 1)];
+        if (event->time > tickEndTime) {
+            break;
+        }
+
+        if (event->isDown) {
+            sHeldInput |= event->button;
+            pressedInput |= event->button;
+        }
+        else {
+            sHeldInput &= ~event->button;
+        }
+        // a flip from one button to another is two events, but only one change
+        if (event->time != sLastEventTime) {
+            sLastEventTime = event->time;
+            RecordInputSampled(event->time);
+        }
+    }
+    // hands the slots back to the producer
+    atomic_store_explicit(&sEventReadIndex, readIndex, memory_order_release);
+
+    RecordInputConsumed();
+    return (sHeldInput & ~INPUT_CONFIRM) | pressedInput;
+}
+
+double GetTickEndTime(double now, double tickAccumulator) {
+    double remainingTime = tickAccumulator - SIMULATION_TICK_TIME;
+    return remainingTime < SIMULATION_TICK_TIME ? now : now - remainingTime;
+}
+
+Vector2 GetInputDirection(PlayerInput input) {
+    Vector2 direction = Vector2Zero();
+
+    if (input & INPUT_UP) {
+        direction.y -= 1;
+    }
+    if (input & INPUT_DOWN) {
+        direction.y += 1;
+    }
+    if (input & INPUT_LEFT) {
+        direction.x -= 1;
+    }
+    if (input & INPUT_RIGHT) {
+        direction.x += 1;
+    }
+
+    return Vector2Normalize(direction);
+}
@@ -0,0 +1,248 @@
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "input_latency.h"
+#include "input.h"
+#include "game.h"
+#include "arena.h"
+#include "sound.h"
+#include "metrics.h"
+#include "platform.h"
+#include "frame_pacer.h"
+
+#define OVERLAY_BAR_WIDTH 6    // in pixels
+#define OVERLAY_BAR_HEIGHT 60  // in pixels, for the fullest bucket
+
+// changes that are on their way to the screen, oldest first.
+// the first sConsumedCount of them have been taken by a tick and are waiting to be drawn
+typedef struct InFlightInput {
+    double sampledTime;
+    double consumedTime;
+} InFlightInput;
+
+static InFlightInput sInFlight[INPUT_LATENCY_MAX_IN_FLIGHT];
+static int sInFlightHead;
+static int sInFlightCount;
+static int sConsumedCount;
+
+static InputLatencySample sSamples[INPUT_LATENCY_MAX_SAMPLES];
+static int sSampleCount; // total ever recorded, the ring only holds the last INPUT_LATENCY_MAX_SAMPLES
+static int sBucketCounts[INPUT_LATENCY_BUCKET_COUNT];
+static bool sIsOverlayVisible;
+
+static Metric sSampledToConsumedMetric;
+static Metric sConsumedToPresentedMetric;
+static Metric sTotalLatencyMetric;
+
+void InitInputLatency() {
+    const char *help = "Time from a local input changing to the end of the frame that shows it, by stage.";
+    RegisterHistogram(&sSampledToConsumedMetric, "pong_input_latency_seconds", "stage=\"sampled_to_consumed\"", help);
+    RegisterHistogram(&sConsumedToPresentedMetric, "pong_input_latency_seconds", "stage=\"consumed_to_presented\"", help);
+    RegisterHistogram(&sTotalLatencyMetric, "pong_input_latency_seconds", "stage=\"total\"", help);
+}
+
+void RecordInputSampled(double sampledTime) {
+    // nothing is drawing frames, drop the oldest rather than the newest
+    if (sInFlightCount == INPUT_LATENCY_MAX_IN_FLIGHT) {
+        sInFlightHead = (sInFlightHead + 1) % INPUT_LATENCY_MAX_IN_FLIGHT;
+        sInFlightCount--;
+        if (sConsumedCount > 0) {
+            sConsumedCount--;
+        }
+    }
+
+    int index = (sInFlightHead + sInFlightCount) % INPUT_LATENCY_MAX_IN_FLIGHT;
+    sInFlight[index].sampledTime = sampledTime;
+    sInFlightCount++;
+}
+
+void RecordInputConsumed() {
+    if (sConsumedCount == sInFlightCount) {
+        return;
+    }
+
+    double now = GetMonotonicTime();
+    for (int i = sConsumedCount; i < sInFlightCount; ++i) {
+        sInFlight[(sInFlightHead + i) % INPUT_LATENCY_MAX_IN_FLIGHT].consumedTime = now;
+    }
+    sConsumedCount = sInFlightCount;
+}
+
+static double GetTotalLatency(const InputLatencySample *sample) {
+    return sample->sampledToConsumed + sample->consumedToPresented;
+}
+
+void RecordFramePresented() {
+    if (sConsumedCount == 0) {
+        return;
+    }
+
+    double now = GetMonotonicTime();
+    for (int i = 0; i < sConsumedCount; ++i) {
+        const InFlightInput *input = &sInFlight[(sInFlightHead + i) % INPUT_LATENCY_MAX_IN_FLIGHT];
+        InputLatencySample *sample = &sSamples[sSampleCount % INPUT_LATENCY_MAX_SAMPLES];
+        sample->sampledToConsumed = input->consumedTime - input->sampledTime;
+        sample->consumedToPresented = now - input->consumedTime;
+        sSampleCount++;
+
+        double totalLatency = GetTotalLatency(sample);
+        int bucket = (int) (totalLatency / INPUT_LATENCY_BUCKET_TIME);
+        sBucketCounts[bucket < INPUT_LATENCY_BUCKET_COUNT ? bucket : INPUT_LATENCY_BUCKET_COUNT - 1]++;
+
+        ObserveHistogram(&sSampledToConsumedMetric, sample->sampledToConsumed);
+        ObserveHistogram(&sConsumedToPresentedMetric, sample->consumedToPresented);
+        ObserveHistogram(&sTotalLatencyMetric, totalLatency);
+    }
+
+    sInFlightHead = (sInFlightHead + sConsumedCount) % INPUT_LATENCY_MAX_IN_FLIGHT;
+    sInFlightCount -= sConsumedCount;
+    sConsumedCount = 0;
+}
+
+static int GetStoredSampleCount() {
+    return sSampleCount < INPUT_LATENCY_MAX_SAMPLES ? sSampleCount : INPUT_LATENCY_MAX_SAMPLES;
+}
+
+static int CompareDoubles(const void *a, const void *b) {
+    double left = *(const double *) a;
+    double right = *(const double *) b;
+    return (left > right) - (left < right);
+}
+
+// over the recent samples, sorts a copy in the frame arena
+static void GetLatencyPercentiles(double *p50, double *p99, double *worst) {
+    *p50 = *p99 = *worst = 0;
+
+    int count = GetStoredSampleCount();
+    if (count == 0) {
+        return;
+    }
+
+    double *totals = FRAME_ALLOCATE_ARRAY(double, count);
+    if (totals == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        totals[i] = GetTotalLatency(&sSamples[i]);
+    }
+    qsort(totals, count, sizeof(totals[0]), CompareDoubles);
+
+    *p50 = totals[count / 2];
+    *p99 = totals[count * 99 / 100];
+    *worst = totals[count - 1];
+}
+
+void HandleInputLatencyKeys() {
+    if (TakeKeyPress(KEY_F3)) {
+        sIsOverlayVisible = !sIsOverlayVisible;
+    }
+
+    if (TakeKeyPress(KEY_F4)) {
+        bool isDumped = DumpInputLatency(INPUT_LATENCY_DUMP_PATH);
+        printf(isDumped ? "dumped input latency to %s\n" : "failed to dump input latency to %s!\n", INPUT_LATENCY_DUMP_PATH);
+    }
+}
+
+void RenderInputLatencyOverlay() {
+    if (!sIsOverlayVisible) {
+        return;
+    }
+
+    int maxBucketCount = 1;
+    for (int i = 0; i < INPUT_LATENCY_BUCKET_COUNT; ++i) {
+        if (sBucketCounts[i] > maxBucketCount) {
+            maxBucketCount = sBucketCounts[i];
+        }
+    }
+
+    int bottom = GAME_HEIGHT - 10;
+    for (int i = 0; i < INPUT_LATENCY_BUCKET_COUNT; ++i) {
+        int height = sBucketCounts[i] * OVERLAY_BAR_HEIGHT / maxBucketCount;
+        DrawRectangle(10 + i * OVERLAY_BAR_WIDTH, bottom - height, OVERLAY_BAR_WIDTH - 1, height, GRAY);
+    }
+
+    double p50, p99, worst;
+    GetLatencyPercentiles(&p50, &p99, &worst);
+    DrawText(TextFormat("input latency  p50 %.1f ms  p99 %.1f ms  max %.1f ms  (%d samples, bars are %.0f ms)",
+                        p50 * 1000, p99 * 1000, worst * 1000, sSampleCount, INPUT_LATENCY_BUCKET_TIME * 1000),
+             10, bottom - OVERLAY_BAR_HEIGHT - 14, 10, GRAY);
+}
+
+bool DumpInputLatency(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    // oldest first
+    int count = GetStoredSampleCount();
+    int first = sSampleCount - count;
+
+    fprintf(file, "sampled_to_consumed_ms,consumed_to_presented_ms,total_ms\n");
+    for (int i = first; i < sSampleCount; ++i) {
+        const InputLatencySample *sample = &sSamples[i % INPUT_LATENCY_MAX_SAMPLES];
+        fprintf(file, "%.3f,%.3f,%.3f\n", sample->sampledToConsumed * 1000, sample->consumedToPresented * 1000,
+                GetTotalLatency(sample) * 1000);
+    }
+
+    return fclose(file) == 0;
+}
+
+int RunInputLatencyTest(int seconds, int targetFps) {
+    printf("input latency test: %d s of synthetic input\n", seconds);
+    SetSoundsMuted(true);
+    InitInputLatency();
+    InitFramePacer(targetFps);
+    SetLocalInputSource(INPUT_SOURCE_SYNTHETIC);
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    // same shape as RunGame, minus the drawing
+    double startTime = GetMonotonicTime();
+    double lastFrameTime = startTime;
+    double tickAccumulator = 0;
+
+    while (lastFrameTime - startTime < seconds) {
+        ResetFrameArenas();
+        PollLocalInput();
+
+        double now = GetMonotonicTime();
+        tickAccumulator += now - lastFrameTime;
+        lastFrameTime = now;
+        int tickCount = 0;
+
+        while (tickAccumulator >= SIMULATION_TICK_TIME && tickCount < MAX_TICKS_PER_FRAME) {
+            PlayerInput input = TakeLocalInput(0, GetTickEndTime(now, tickAccumulator));
+            SimulateTick(&input);
+            tickAccumulator -= SIMULATION_TICK_TIME;
+            tickCount++;
+        }
+
+        if (tickCount == MAX_TICKS_PER_FRAME) {
+            tickAccumulator = 0;
+        }
+
+        // nobody is dodging, restart straight away so input keeps reaching the player
+        if (GetGameState() == GAME_STATE_OVER) {
+            ChangeGameStateTo(GAME_STATE_PLAYING);
+        }
+
+        RecordFramePresented();
+        WaitForNextFrame();
+    }
+
+    SetLocalInputSource(INPUT_SOURCE_KEYBOARD);
+    ResetFrameArenas();
+    double p50, p99, worst;
+    GetLatencyPercentiles(&p50, &p99, &worst);
+
+    printf("%d input changes, latency p50 %.2f ms, p99 %.2f ms, worst %.2f ms\n", sSampleCount, p50 * 1000, p99 * 1000, worst * 1000);
+    ReportFramePacerStats();
+
+    if (!DumpInputLatency(INPUT_LATENCY_DUMP_PATH)) {
+        printf("failed to dump input latency to %s!\n", INPUT_LATENCY_DUMP_PATH);
+        return 1;
+    }
+    printf("samples dumped to %s\n", INPUT_LATENCY_DUMP_PATH);
+    return 0;
+}
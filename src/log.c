@@ -0,0 +1,331 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "log.h"
+#include "platform.h"
+
+// every argument fits in 8 bytes, so a record is the same size no matter the message
+typedef union LogArgument {
+    long long integer;
+    double real;
+    const void *pointer;
+} LogArgument;
+
+typedef struct LogRecord {
+    const char *format;
+    int skippedCount;
+    LogArgument arguments[LOG_MAX_ARGUMENTS];
+} LogRecord;
+
+typedef struct LogRateLimit {
+    const char *format;
+    double lastTime;
+    int skippedCount;
+} LogRateLimit;
+
+// single producer (the thread that owns it) single consumer (the writer)
+typedef struct LogRing {
+    LogRecord records[LOG_RING_RECORDS];
+    atomic_uint writeIndex;
+    atomic_uint readIndex;
+    atomic_int droppedCount;
+    // only ever touched by the owning thread
+    LogRateLimit rateLimits[LOG_RATE_LIMIT_SLOTS];
+} LogRing;
+
+// one printf conversion, e.g. %-8.3f or %zu
+typedef struct LogConversion {
+    const char *start;
+    const char *flagsEnd; // flags, width + precision end here, the length modifier starts
+    const char *end;
+    int longCount;
+    bool isSize;
+    char type;
+} LogConversion;
+
+static LogRing sRings[MAX_LOG_THREADS];
+static atomic_int sClaimedRingCount;
+static atomic_int sRinglessDroppedCount;
+static THREAD_LOCAL LogRing *sThreadRing;
+static THREAD_LOCAL bool sHasClaimedRing;
+
+static Thread sWriter;
+static atomic_bool sIsLoggerRunning;
+
+static LogRing *GetThreadRing() {
+    if (!sHasClaimedRing) {
+        sHasClaimedRing = true;
+        int index = atomic_fetch_add(&sClaimedRingCount, 1);
+        sThreadRing = index < MAX_LOG_THREADS ? &sRings[index] : NULL;
+    }
+    return sThreadRing;
+}
+
+// skips %% since it doesn't take an argument
+static bool FindConversion(const char *cursor, LogConversion *conversion) {
+    while ((cursor = strchr(cursor, '%')) != NULL) {
+        if (cursor[1] == '%') {
+            cursor += 2;
+            continue;
+        }
+
+        conversion->start = cursor++;
+        while (*cursor != '\0' && strchr("-+ #0123456789.", *cursor) != NULL) {
+            cursor++;
+        }
+        conversion->flagsEnd = cursor;
+
+        conversion->longCount = 0;
+        conversion->isSize = false;
+        while (*cursor == 'h' || *cursor == 'l' || *cursor == 'z') {
+            conversion->longCount += *cursor == 'l';
+            conversion->isSize |= *cursor == 'z';
+            cursor++;
+        }
+
+        if (*cursor == '\0') {
+            return false;
+        }
+        conversion->type = *cursor;
+        conversion->end = cursor + 1;
+        return true;
+    }
+    return false;
+}
+
+static bool IsIntegerConversion(char type) {
+    return type != '\0' && strchr("diuxXo", type) != NULL;
+}
+
+static bool IsRealConversion(char type) {
+    return type != '\0' && strchr("fFeEgGaA", type) != NULL;
+}
+
+static LogArgument CaptureArgument(const LogConversion *conversion, va_list *arguments) {
+    LogArgument argument = {0};
+    bool isSigned = conversion->type == 'd' || conversion->type == 'i';
+
+    if (IsIntegerConversion(conversion->type)) {
+        if (conversion->isSize) {
+            argument.integer = (long long) va_arg(*arguments, size_t);
+        }
+        else if (conversion->longCount >= 2) {
+            argument.integer = va_arg(*arguments, long long);
+        }
+        else if (conversion->longCount == 1) {
+            argument.integer = isSigned ? (long long) va_arg(*arguments, long) : (long long) va_arg(*arguments, unsigned long);
+        }
+        else {
+            argument.integer = isSigned ? (long long) va_arg(*arguments, int) : (long long) va_arg(*arguments, unsigned int);
+        }
+    }
+    else if (IsRealConversion(conversion->type)) {
+        argument.real = va_arg(*arguments, double);
+    }
+    else if (conversion->type == 'c') {
+        argument.integer = va_arg(*arguments, int);
+    }
+    else {
+        argument.pointer = va_arg(*arguments, const void *);
+    }
+    return argument;
+}
+
+// appends text (a printf format) plus one conversion's worth of formatted argument
+static int AppendConversion(char *line, int size, const char *text, int textLength, const LogConversion *conversion, LogArgument argument) {
+    char format[LOG_LINE_CAPACITY];
+    int flagsLength = (int) (conversion->flagsEnd - conversion->start);
+    if (textLength + flagsLength + 4 > (int) sizeof(format)) {
+        return size;
+    }
+
+    // integers all got widened to long long, so they get printed as one
+    memcpy(format, text, textLength);
+    memcpy(format + textLength, conversion->start, flagsLength);
+    int formatLength = textLength + flagsLength;
+    if (IsIntegerConversion(conversion->type)) {
+        format[formatLength++] = 'l';
+        format[formatLength++] = 'l';
+    }
+    format[formatLength++] = conversion->type;
+    format[formatLength] = '\0';
+
+    int remaining = LOG_LINE_CAPACITY - size;
+    int written;
+    if (IsIntegerConversion(conversion->type)) {
+        written = snprintf(line + size, remaining, format, argument.integer);
+    }
+    else if (IsRealConversion(conversion->type)) {
+        written = snprintf(line + size, remaining, format, argument.real);
+    }
+    else if (conversion->type == 'c') {
+        written = snprintf(line + size, remaining, format, (int) argument.integer);
+    }
+    else if (conversion->type == 's') {
+        written = snprintf(line + size, remaining, format, (const char *) argument.pointer);
+    }
+    else {
+        written = snprintf(line + size, remaining, format, argument.pointer);
+    }
+
+    if (written < 0) {
+        return size;
+    }
+    return size + written < LOG_LINE_CAPACITY ? size + written : LOG_LINE_CAPACITY - 1;
+}
+
+static void WriteRecord(const LogRecord *record) {
+    char line[LOG_LINE_CAPACITY];
+    int size = 0;
+    const char *cursor = record->format;
+    LogConversion conversion;
+
+    line[0] = '\0';
+    for (int i = 0; i < LOG_MAX_ARGUMENTS && FindConversion(cursor, &conversion); ++i) {
+        size = AppendConversion(line, size, cursor, (int) (conversion.start - cursor), &conversion, record->arguments[i]);
+        cursor = conversion.end;
+    }
+
+    // anything past LOG_MAX_ARGUMENTS didn't get captured, so it gets written as is
+    if (FindConversion(cursor, &conversion)) {
+        fputs(line, stdout);
+        fputs(cursor, stdout);
+    }
+    else {
+        // the rest can only have %% left in it
+        for (; *cursor != '\0' && size < LOG_LINE_CAPACITY - 1; ++cursor, ++size) {
+            line[size] = *cursor;
+            cursor += cursor[0] == '%' && cursor[1] == '%';
+        }
+        line[size] = '\0';
+        fputs(line, stdout);
+    }
+
+    if (record->skippedCount > 0) {
+        printf(" (%d more like this skipped)", record->skippedCount);
+    }
+    fputc('\n', stdout);
+}
+
+static void DrainRings() {
+    int ringCount = atomic_load(&sClaimedRingCount);
+    if (ringCount > MAX_LOG_THREADS) {
+        ringCount = MAX_LOG_THREADS;
+    }
+
+    bool hasWritten = false;
+    for (int i = 0; i < ringCount; ++i) {
+        LogRing *ring = &sRings[i];
+        unsigned int readIndex = atomic_load_explicit(&ring->readIndex, memory_order_relaxed);
+        unsigned int writeIndex = atomic_load_explicit(&ring->writeIndex, memory_order_acquire);
+
+        for (; readIndex != writeIndex; ++readIndex) {
+            WriteRecord(&ring->records[readIndex & (LOG_RING_RECORDS - 1)]);
+            hasWritten = true;
+        }
+        // hands the slots back to the thread that owns the ring
+        atomic_store_explicit(&ring->readIndex, readIndex, memory_order_release);
+
+        int droppedCount = atomic_exchange(&ring->droppedCount, 0);
+        if (droppedCount > 0) {
+            printf("%d log messages didn't fit in the ring!\n", droppedCount);
+            hasWritten = true;
+        }
+    }
+
+    int ringlessDroppedCount = atomic_exchange(&sRinglessDroppedCount, 0);
+    if (ringlessDroppedCount > 0) {
+        printf("%d log messages came from threads without a ring!\n", ringlessDroppedCount);
+        hasWritten = true;
+    }
+
+    if (hasWritten) {
+        fflush(stdout);
+    }
+}
+
+static void RunLogWriter(void *userData) {
+    (void) userData;
+    while (atomic_load(&sIsLoggerRunning)) {
+        DrainRings();
+        SleepSeconds(LOG_WRITER_SLEEP_TIME);
+    }
+}
+
+void LogMessage(const char *format, ...) {
+    LogRing *ring = GetThreadRing();
+    int skippedCount = 0;
+
+    if (ring != NULL) {
+        // a repeat doesn't get past here, so under pressure it costs a clock read and a compare.
+        // two messages that share a slot just take turns, and lose each other's skipped counts
+        LogRateLimit *rateLimit = &ring->rateLimits[((uintptr_t) format >> 3) % LOG_RATE_LIMIT_SLOTS];
+        double time = GetMonotonicTime();
+        if (rateLimit->format == format) {
+            if (time - rateLimit->lastTime < LOG_RATE_LIMIT_TIME) {
+                rateLimit->skippedCount++;
+                return;
+            }
+            skippedCount = rateLimit->skippedCount;
+        }
+        rateLimit->format = format;
+        rateLimit->lastTime = time;
+        rateLimit->skippedCount = 0;
+    }
+
+    LogRecord record = {.format = format, .skippedCount = skippedCount};
+    const char *cursor = format;
+    LogConversion conversion;
+    va_list arguments;
+    va_start(arguments, format);
+    for (int i = 0; i < LOG_MAX_ARGUMENTS && FindConversion(cursor, &conversion); ++i) {
+        record.arguments[i] = CaptureArgument(&conversion, &arguments);
+        cursor = conversion.end;
+    }
+    va_end(arguments);
+
+    if (!atomic_load(&sIsLoggerRunning)) {
+        WriteRecord(&record);
+        return;
+    }
+
+    if (ring == NULL) {
+        atomic_fetch_add(&sRinglessDroppedCount, 1);
+        return;
+    }
+
+    unsigned int writeIndex = atomic_load_explicit(&ring->writeIndex, memory_order_relaxed);
+    unsigned int readIndex = atomic_load_explicit(&ring->readIndex, memory_order_acquire);
+    if (writeIndex - readIndex == LOG_RING_RECORDS) {
+        atomic_fetch_add(&ring->droppedCount, 1);
+        return;
+    }
+
+    ring->records[writeIndex & (LOG_RING_RECORDS - 1)] = record;
+    // publishes the record written above
+    atomic_store_explicit(&ring->writeIndex, writeIndex + 1, memory_order_release);
+}
+
+void StartLogger() {
+    if (atomic_load(&sIsLoggerRunning)) {
+        return;
+    }
+
+    atomic_store(&sIsLoggerRunning, true);
+    if (!StartThread(&sWriter, RunLogWriter, NULL)) {
+        atomic_store(&sIsLoggerRunning, false);
+        printf("couldn't start the log thread, logging straight to stdout!\n");
+    }
+}
+
+void StopLogger() {
+    if (!atomic_load(&sIsLoggerRunning)) {
+        return;
+    }
+
+    atomic_store(&sIsLoggerRunning, false);
+    JoinThread(&sWriter);
+    DrainRings();
+}
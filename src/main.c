@@ -16,20 +16,196 @@
 //  - stages + attack patterns
 
 #include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "game.h"
 #include "sound.h"
+#include "arena.h"
+#include "pattern.h"
+#include "math_util.h"
+#include "netplay.h"
+#include "metrics.h"
+#include "bot.h"
+#include "ball.h"
+#include "batch.h"
+#include "frame_pacer.h"
+#include "input_latency.h"
+#include "render_list.h"
+#include "span_math.h"
+#include "music.h"
+#include "log.h"
+#include "divergence.h"
+#include "training.h"
+#include "rewind.h"
+#include "field.h"
+#include "spectator.h"
+#include "memory_usage.h"
+#include "world.h"
+
+// the port after a flag, if there is one
+static unsigned short GetPortArgument(int argc, char **argv, int index, unsigned short defaultPort) {
+    if (index < argc && strncmp(argv[index], "--", 2) != 0) {
+        return (unsigned short) atoi(argv[index]);
+    }
+    return defaultPort;
+}
+
+// usage: pong [--host [port] | --join <host> [port]] [--metrics [port]] [--bot | --synthetic-input]
+//             [--fps <rate, 0 for monitor, -1 uncapped>] [--music <track.ogg|track.qoa>...]
+//             [--field <width> <height>, before --host/--join, same on both ends]
+//             [--broadcast [port]] [--spectate <host> [port]]
+//        pong --loopback-test [latency ms] [loss %]
+//        pong --soak [minutes] [ball count]
+//        pong --batch [worlds per setting] [threads]
+//        pong --latency-test [seconds] [fps]
+//        pong --render-bench [frames]
+//        pong --span-math-check
+//        pong --divergence-check [ticks] [ball count]
+//        pong --training [ticks per phase] [seed]
+//        pong --spectator-load-test [viewers] [seconds]
+//        pong --memory-check [budget file] [ticks per phase] [music tracks...]
+int main(int argc, char **argv) {
+    // every mode but --batch plays in the main world, on this thread
+    InitWorld(GetMainWorld());
+    UseWorld(GetMainWorld());
+    InitSpanMath();
+    // every mode returns straight out of main, so the last messages get written on the way out
+    StartLogger();
+    atexit(StopLogger);
+    LoadPatterns();
+    InitFrameArenas();
+    SeedRandom((unsigned int) time(NULL));
+
+    if (argc > 1 && strcmp(argv[1], "--loopback-test") == 0) {
+        float latency = argc > 2 ? (float) atof(argv[2]) / 1000 : LOOPBACK_TEST_LATENCY;
+        float lossPercent = argc > 3 ? (float) atof(argv[3]) : LOOPBACK_TEST_LOSS;
+        return RunLoopbackTest(LOOPBACK_TEST_TICKS, latency, lossPercent);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--soak") == 0) {
+        int minutes = argc > 2 ? atoi(argv[2]) : SOAK_TEST_MINUTES;
+        int ballCount = argc > 3 ? atoi(argv[3]) : SOAK_TEST_BALL_COUNT;
+        return RunSoakTest(minutes * 60 * SIMULATION_TICK_RATE, ballCount);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        int worldsPerSetting = argc > 2 ? atoi(argv[2]) : BATCH_DEFAULT_WORLDS_PER_SETTING;
+        int threadCount = argc > 3 ? atoi(argv[3]) : 0;
+        return RunBatch(worldsPerSetting, threadCount);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--latency-test") == 0) {
+        int seconds = argc > 2 ? atoi(argv[2]) : INPUT_LATENCY_TEST_SECONDS;
+        int targetFps = argc > 3 ? atoi(argv[3]) : FALLBACK_TARGET_FPS;
+        return RunInputLatencyTest(seconds, targetFps);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--span-math-check") == 0) {
+        return RunSpanMathCheck();
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--divergence-check") == 0) {
+        int tickCount = argc > 2 ? atoi(argv[2]) : DIVERGENCE_CHECK_TICKS;
+        int ballCount = argc > 3 ? atoi(argv[3]) : DIVERGENCE_CHECK_BALL_COUNT;
+        return RunDivergenceCheck(tickCount, ballCount);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--render-bench") == 0) {
+        int frameCount = argc > 2 ? atoi(argv[2]) : RENDER_BENCHMARK_FRAMES;
+        return RunRenderBenchmark(frameCount);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--training") == 0) {
+        int phaseTicks = argc > 2 ? atoi(argv[2]) : TRAINING_PHASE_TICKS;
+        unsigned int seed = argc > 3 ? (unsigned int) atoi(argv[3]) : 1;
+        return RunTrainingWorkload(phaseTicks, seed);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--spectator-load-test") == 0) {
+        int viewerCount = argc > 2 ? atoi(argv[2]) : SPECTATOR_LOAD_TEST_VIEWERS;
+        float seconds = argc > 3 ? (float) atof(argv[3]) : SPECTATOR_LOAD_TEST_SECONDS;
+        return RunSpectatorLoadTest(viewerCount, seconds);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--memory-check") == 0) {
+        const char *budgetPath = argc > 2 ? argv[2] : MEMORY_BUDGET_PATH;
+        int phaseTicks = argc > 3 ? atoi(argv[3]) : TRAINING_PHASE_TICKS;
+        return RunMemoryCheck(budgetPath, phaseTicks, (const char **) &argv[4 < argc ? 4 : argc], argc > 4 ? argc - 4 : 0);
+    }
 
-int main(void) {
     InitWindow(GAME_WIDTH, GAME_HEIGHT, "PONG");
     InitAudioDevice();
     LoadSounds();
+    InitRewind();
 
     ChangeGameStateTo(GAME_STATE_PLAYING);
 
+    int targetFps = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--host") == 0) {
+            StartNetplayHost(GetPortArgument(argc, argv, i + 1, NETPLAY_DEFAULT_PORT));
+        }
+        else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+            StartNetplayJoin(argv[i + 1], GetPortArgument(argc, argv, i + 2, NETPLAY_DEFAULT_PORT));
+        }
+        else if (strcmp(argv[i], "--broadcast") == 0) {
+            StartSpectatorServer(GetPortArgument(argc, argv, i + 1, SPECTATOR_DEFAULT_PORT));
+        }
+        else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            StartSpectating(argv[i + 1], GetPortArgument(argc, argv, i + 2, SPECTATOR_DEFAULT_PORT));
+        }
+        else if (strcmp(argv[i], "--metrics") == 0) {
+            StartMetricsServer(GetPortArgument(argc, argv, i + 1, METRICS_DEFAULT_PORT));
+        }
+        else if (strcmp(argv[i], "--bot") == 0) {
+            InitBot();
+            SetLocalInputSource(INPUT_SOURCE_BOT);
+        }
+        else if (strcmp(argv[i], "--synthetic-input") == 0) {
+            SetLocalInputSource(INPUT_SOURCE_SYNTHETIC);
+        }
+        else if (strcmp(argv[i], "--field") == 0 && i + 2 < argc) {
+            // the first match was already built on a screen sized field, start over on the new one
+            SetFieldSize(atoi(argv[i + 1]), atoi(argv[i + 2]));
+            ChangeGameStateTo(GAME_STATE_PLAYING);
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            targetFps = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--music") == 0) {
+            // every argument up to the next flag is a track
+            int trackCount = 0;
+            while (i + 1 + trackCount < argc && strncmp(argv[i + 1 + trackCount], "--", 2) != 0) {
+                trackCount++;
+            }
+            StartMusic((const char **) &argv[i + 1], trackCount);
+            i += trackCount;
+        }
+    }
+
+    InitFramePacer(targetFps);
+    InitInputLatency();
+
     while (!WindowShouldClose()) {
         RunGame();
+        WaitForNextFrame();
     }
 
+    ReportFramePacerStats();
+
+#ifdef PONG_DEBUG_MEMORY
+    ReportMemoryUsage();
+#endif
+
+    StopMetricsServer();
+    StopNetplay();
+    StopSpectatorServer();
+    StopSpectating();
+    StopInputSampling();
+    StopMusic();
+    UnloadSounds();
     CloseAudioDevice();
     CloseWindow();
     return 0;
@@ -1,9 +1,34 @@
-#include <stdlib.h>
 #include <raylib.h>
 #include "math_util.h"
+#include "snapshot.h"
+#include "world.h"
+
+// our own generator instead of rand(), its state lives in the world so it
+// gets saved + restored with the rest of it and plays out the same on every machine
+
+void SeedRandom(unsigned int seed) {
+    // xorshift gets stuck on zero
+    gWorld->randomState = seed != 0 ? seed : 1;
+    REGISTER_SNAPSHOT_VARIABLE(gWorld->randomState);
+}
+
+unsigned int RandomUInt() {
+    // xorshift32
+    unsigned int x = gWorld->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gWorld->randomState = x;
+    return x;
+}
+
+int RandomInt(int min, int max) {
+    return min + (int) (RandomUInt() % (unsigned int) (max - min + 1));
+}
 
 float RandomFloat() {
-    return (float) rand() / (float) RAND_MAX;
+    // top 24 bits, exactly representable in a float
+    return (float) (RandomUInt() >> 8) / (float) (1 << 24);
 }
 
 Vector2 RandomPointOnUnitCircle() {
@@ -33,6 +58,84 @@ Vector2 GetRectPosition(Rectangle rect) {
     return result;
 }
 
+Rectangle GetSegmentBounds(Vector2 start, Vector2 end, float radius) {
+    Rectangle result = {
+        .x = fminf(start.x, end.x) - radius,
+        .y = fminf(start.y, end.y) - radius,
+        .width = fabsf(end.x - start.x) + 2 * radius,
+        .height = fabsf(end.y - start.y) + 2 * radius,
+    };
+    return result;
+}
+
+static float DistanceSqrPointToRect(Vector2 point, Rectangle rect) {
+    Vector2 closest = {
+        .x = Clamp(point.x, rect.x, rect.x + rect.width),
+        .y = Clamp(point.y, rect.y, rect.y + rect.height),
+    };
+    return Vector2DistanceSqr(point, closest);
+}
+
+float DistanceSqrPointToSegment(Vector2 point, Vector2 start, Vector2 end) {
+    Vector2 segment = Vector2Subtract(end, start);
+    float lengthSqr = Vector2LengthSqr(segment);
+    float t = lengthSqr > 0 ? Clamp(Vector2DotProduct(Vector2Subtract(point, start), segment) / lengthSqr, 0, 1) : 0;
+    return Vector2DistanceSqr(point, Vector2Add(start, Vector2Scale(segment, t)));
+}
+
+static bool CheckCollisionSegmentRec(Vector2 start, Vector2 end, Rectangle rect) {
+    // slab test, clip the segment's [0, 1] range against both axes
+    float tMin = 0;
+    float tMax = 1;
+    float origin[2] = {start.x, start.y};
+    float direction[2] = {end.x - start.x, end.y - start.y};
+    float slabMin[2] = {rect.x, rect.y};
+    float slabMax[2] = {rect.x + rect.width, rect.y + rect.height};
+
+    for (int axis = 0; axis < 2; ++axis) {
+        if (direction[axis] == 0) {
+            if (origin[axis] < slabMin[axis] || origin[axis] > slabMax[axis]) {
+                return false;
+            }
+            continue;
+        }
+        float t0 = (slabMin[axis] - origin[axis]) / direction[axis];
+        float t1 = (slabMax[axis] - origin[axis]) / direction[axis];
+        tMin = fmaxf(tMin, fminf(t0, t1));
+        tMax = fminf(tMax, fmaxf(t0, t1));
+        if (tMin > tMax) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CheckCollisionCapsuleRec(Vector2 start, Vector2 end, float radius, Rectangle rect) {
+    if (CheckCollisionSegmentRec(start, end, rect)) {
+        return true;
+    }
+
+    // no overlap, so the closest pair is an endpoint vs the rect or a corner vs the segment
+    float radiusSqr = radius * radius;
+
+    if (DistanceSqrPointToRect(start, rect) <= radiusSqr || DistanceSqrPointToRect(end, rect) <= radiusSqr) {
+        return true;
+    }
+
+    Vector2 corners[4] = {
+        {rect.x, rect.y},
+        {rect.x + rect.width, rect.y},
+        {rect.x, rect.y + rect.height},
+        {rect.x + rect.width, rect.y + rect.height},
+    };
+    for (int i = 0; i < 4; ++i) {
+        if (DistanceSqrPointToSegment(corners[i], start, end) <= radiusSqr) {
+            return true;
+        }
+    }
+    return false;
+}
+
 float SmoothStop2(float t) { return 1 - (1 - t) * (1 - t);}
 float SmoothStop3(float t) { return 1 - (1 - t) * (1 - t) * (1 - t);}
 float SmoothStop4(float t) { return 1 - (1 - t) * (1 - t) * (1 - t) * (1 - t);}
@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <raylib.h>
+#include "memory_usage.h"
+#include "arena.h"
+#include "platform.h"
+#include "rewind.h"
+#include "training.h"
+#include "netplay.h"
+#include "spectator.h"
+#include "sound.h"
+#include "music.h"
+#include "game.h"
+#include "world.h"
+
+#define MAX_BUDGET_LINE 256
+
+typedef struct HeapUsage {
+    atomic_llong bytes;
+    atomic_llong peakBytes;
+    atomic_llong allocationCount;
+} HeapUsage;
+
+static const char *sTagNames[MEMORY_TAG_COUNT] = {
+    [MEMORY_TAG_BALLS] = "balls",
+    [MEMORY_TAG_PLAYERS] = "players",
+    [MEMORY_TAG_OBJECTIVES] = "objectives",
+    [MEMORY_TAG_PARTICLES] = "particles",
+    [MEMORY_TAG_BULLETS] = "bullets",
+    [MEMORY_TAG_PATTERNS] = "patterns",
+    [MEMORY_TAG_TIMERS] = "timers",
+    [MEMORY_TAG_SCRATCH] = "scratch",
+    [MEMORY_TAG_SNAPSHOTS] = "snapshots",
+    [MEMORY_TAG_REWIND] = "rewind",
+    [MEMORY_TAG_NETWORK] = "network",
+    [MEMORY_TAG_SOUNDS] = "sounds",
+    [MEMORY_TAG_MUSIC] = "music",
+    [MEMORY_TAG_RAYLIB] = "raylib",
+};
+
+// the heap is shared, so is what we know about it
+static HeapUsage sHeapUsages[MEMORY_TAG_COUNT];
+
+static StaticMemoryRegion *AddRegion(MemoryTag tag, const char *name, size_t size) {
+    StaticMemoryRegistry *staticMemory = &gWorld->staticMemory;
+    for (int i = 0; i < staticMemory->regionCount; ++i) {
+        if (staticMemory->regions[i].tag == tag && strcmp(staticMemory->regions[i].name, name) == 0) {
+            return NULL;
+        }
+    }
+    if (staticMemory->regionCount >= MAX_STATIC_MEMORY_REGIONS) {
+        printf("too many static memory regions, %s isn't counted!\n", name);
+        return NULL;
+    }
+
+    StaticMemoryRegion *region = &staticMemory->regions[staticMemory->regionCount++];
+    *region = (StaticMemoryRegion) {.tag = tag, .name = name, .size = size};
+    return region;
+}
+
+void RegisterStaticMemory(MemoryTag tag, const char *name, size_t size) {
+    AddRegion(tag, name, size);
+}
+
+void RegisterStaticArrayMemory(MemoryTag tag, const char *name, size_t elementSize, int capacity, const int *count) {
+    StaticMemoryRegion *region = AddRegion(tag, name, elementSize * (size_t) capacity);
+    if (region != NULL) {
+        region->elementSize = elementSize;
+        region->capacity = capacity;
+        region->count = count;
+        region->peakCount = *count;
+    }
+}
+
+void SampleStaticArrayOccupancy() {
+    StaticMemoryRegistry *staticMemory = &gWorld->staticMemory;
+    for (int i = 0; i < staticMemory->regionCount; ++i) {
+        StaticMemoryRegion *region = &staticMemory->regions[i];
+        if (region->count != NULL && *region->count > region->peakCount) {
+            region->peakCount = *region->count;
+        }
+    }
+}
+
+void TrackHeapAllocation(MemoryTag tag, size_t size) {
+    HeapUsage *usage = &sHeapUsages[tag];
+    long long bytes = atomic_fetch_add_explicit(&usage->bytes, (long long) size, memory_order_relaxed) + (long long) size;
+    atomic_fetch_add_explicit(&usage->allocationCount, 1, memory_order_relaxed);
+
+    long long peakBytes = atomic_load_explicit(&usage->peakBytes, memory_order_relaxed);
+    while (bytes > peakBytes
+           && !atomic_compare_exchange_weak_explicit(&usage->peakBytes, &peakBytes, bytes, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void TrackHeapRelease(MemoryTag tag, size_t size) {
+    atomic_fetch_sub_explicit(&sHeapUsages[tag].bytes, (long long) size, memory_order_relaxed);
+}
+
+MemoryUsage GetMemoryUsage(MemoryTag tag) {
+    StaticMemoryRegistry *staticMemory = &gWorld->staticMemory;
+    MemoryUsage usage = {0};
+    for (int i = 0; i < staticMemory->regionCount; ++i) {
+        if (staticMemory->regions[i].tag == tag) {
+            usage.staticBytes += staticMemory->regions[i].size;
+        }
+    }
+    usage.heapBytes = (size_t) atomic_load_explicit(&sHeapUsages[tag].bytes, memory_order_relaxed);
+    usage.peakHeapBytes = (size_t) atomic_load_explicit(&sHeapUsages[tag].peakBytes, memory_order_relaxed);
+    usage.allocationCount = atomic_load_explicit(&sHeapUsages[tag].allocationCount, memory_order_relaxed);
+    return usage;
+}
+
+const char *GetMemoryTagName(MemoryTag tag) {
+    return sTagNames[tag];
+}
+
+void ReportMemoryUsage() {
+    StaticMemoryRegistry *staticMemory = &gWorld->staticMemory;
+    printf("---- memory usage ----\n");
+    printf("%-12s %12s %12s %12s %12s\n", "subsystem", "static", "heap", "peak heap", "allocations");
+    size_t totalBytes = 0;
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; ++tag) {
+        MemoryUsage usage = GetMemoryUsage(tag);
+        printf("%-12s %12zu %12zu %12zu %12lld\n", sTagNames[tag],
+               usage.staticBytes, usage.heapBytes, usage.peakHeapBytes, usage.allocationCount);
+        totalBytes += usage.staticBytes + usage.peakHeapBytes;
+    }
+    printf("%-12s %12zu bytes at most\n", "total", totalBytes);
+
+    for (int i = 0; i < staticMemory->regionCount; ++i) {
+        const StaticMemoryRegion *region = &staticMemory->regions[i];
+        if (region->count != NULL) {
+            printf("array %-20s %8d / %8d elements (%5.1f%%), %s\n",
+                   region->name, region->peakCount, region->capacity,
+                   region->capacity > 0 ? 100.0 * region->peakCount / region->capacity : 0.0,
+                   sTagNames[region->tag]);
+        }
+    }
+    // arenas + pools keep their own high-water marks
+    ReportMemoryHighWaterMarks();
+}
+
+static int FindMemoryTag(const char *name) {
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; ++tag) {
+        if (strcmp(sTagNames[tag], name) == 0) {
+            return tag;
+        }
+    }
+    return -1;
+}
+
+bool CheckMemoryBudgets(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        printf("couldn't open the memory budgets in %s!\n", path);
+        return false;
+    }
+
+    bool isWithinBudgets = true;
+    char line[MAX_BUDGET_LINE];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        // sizes can end in K or M, e.g. "balls 128K"
+        char name[64];
+        double budget;
+        char unit = '\0';
+        int fieldCount = sscanf(line, "%63s %lf%c", name, &budget, &unit);
+        if (fieldCount <= 0) {
+            continue;
+        }
+        int tag = fieldCount >= 2 ? FindMemoryTag(name) : -1;
+        if (tag < 0) {
+            printf("%s:%d isn't a known subsystem + a size!\n", path, lineNumber);
+            isWithinBudgets = false;
+            continue;
+        }
+        if (unit == 'K' || unit == 'k') {
+            budget *= 1024;
+        }
+        else if (unit == 'M' || unit == 'm') {
+            budget *= 1024 * 1024;
+        }
+
+#ifndef PONG_DEBUG_MEMORY
+        if (tag == MEMORY_TAG_RAYLIB) {
+            printf("raylib is only tracked in PONG_DEBUG_MEMORY builds, its budget isn't checked\n");
+            continue;
+        }
+#endif
+
+        // a budget that nothing counted against would pass no matter what the subsystem does
+        MemoryUsage usage = GetMemoryUsage(tag);
+        double peakBytes = (double) (usage.staticBytes + usage.peakHeapBytes);
+        if (peakBytes == 0 && usage.allocationCount == 0) {
+            printf("%s has a budget but nothing measured it!\n", name);
+            isWithinBudgets = false;
+        }
+        else if (peakBytes > budget) {
+            printf("%s is over its memory budget, %.1f KB against %.1f KB!\n", name, peakBytes / 1024, budget / 1024);
+            isWithinBudgets = false;
+        }
+    }
+
+    fclose(file);
+    return isWithinBudgets;
+}
+
+int RunMemoryCheck(const char *budgetPath, int phaseTicks, const char **musicPaths, int musicCount) {
+    // the windowed game always has the rewind buffers, so the check should too
+    InitRewind();
+    RunTrainingWorkload(phaseTicks, 1);
+
+    // then a short go of everything else the windowed game can have running,
+    // so their budgets get checked against real numbers too
+    RunLoopbackTest(MEMORY_CHECK_NETWORK_SECONDS * SIMULATION_TICK_RATE, LOOPBACK_TEST_LATENCY, LOOPBACK_TEST_LOSS);
+    RunSpectatorLoadTest(MEMORY_CHECK_SPECTATORS, MEMORY_CHECK_NETWORK_SECONDS);
+    InitAudioDevice();
+    if (IsAudioDeviceReady()) {
+        LoadSounds();
+        StartMusic(musicPaths, musicCount);
+        StopMusic();
+        UnloadSounds();
+        CloseAudioDevice();
+    }
+    ReportMemoryUsage();
+
+    bool isWithinBudgets = CheckMemoryBudgets(budgetPath);
+    printf("memory check %s\n", isWithinBudgets ? "PASSED" : "FAILED");
+    return isWithinBudgets ? 0 : 1;
+}
+
+#ifdef PONG_DEBUG_MEMORY
+// every block raylib gets carries its size in front of it, so frees know how much to take off
+typedef union RaylibBlockHeader {
+    size_t size;
+    max_align_t alignment;
+} RaylibBlockHeader;
+
+void *TrackedRaylibMalloc(size_t size) {
+    RaylibBlockHeader *header = malloc(sizeof(RaylibBlockHeader) + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->size = size;
+    TrackHeapAllocation(MEMORY_TAG_RAYLIB, size);
+    return header + 1;
+}
+
+void *TrackedRaylibCalloc(size_t count, size_t size) {
+    if (size != 0 && count > ((size_t) -1 - sizeof(RaylibBlockHeader)) / size) {
+        return NULL;
+    }
+    void *memory = TrackedRaylibMalloc(count * size);
+    if (memory != NULL) {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+void *TrackedRaylibRealloc(void *memory, size_t size) {
+    if (memory == NULL) {
+        return TrackedRaylibMalloc(size);
+    }
+
+    RaylibBlockHeader *header = (RaylibBlockHeader *) memory - 1;
+    size_t previousSize = header->size;
+    header = realloc(header, sizeof(RaylibBlockHeader) + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->size = size;
+    TrackHeapRelease(MEMORY_TAG_RAYLIB, previousSize);
+    TrackHeapAllocation(MEMORY_TAG_RAYLIB, size);
+    return header + 1;
+}
+
+void TrackedRaylibFree(void *memory) {
+    if (memory == NULL) {
+        return;
+    }
+    RaylibBlockHeader *header = (RaylibBlockHeader *) memory - 1;
+    TrackHeapRelease(MEMORY_TAG_RAYLIB, header->size);
+    free(header);
+}
+#endif
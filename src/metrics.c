@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "metrics.h"
+#include "arena.h"
+#include "memory_usage.h"
+#include "net.h"
+#include "world.h"
+
+#define MAX_REQUEST_SIZE 1024 // in bytes, anything past this is ignored
+#define MAX_CLIENT_WAIT_POLLS 120 // in calls to PollMetricsServer, before giving up on a silent client
+
+// upper bounds in seconds, shared by every histogram
+static const double sHistogramBuckets[METRICS_HISTOGRAM_BUCKET_COUNT] = {
+    0.00001, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.002, 0.004, 0.008, 0.016, 0.033, 0.066,
+};
+
+static Metric *sMetrics[MAX_METRICS];
+static int sMetricCount;
+
+static bool sIsServerRunning;
+static intptr_t sListener;
+static bool sHasClient;
+static intptr_t sClient;
+static char sRequest[MAX_REQUEST_SIZE];
+static int sRequestSize;
+static int sClientWaitPolls;
+static char sResponse[METRICS_RESPONSE_CAPACITY];
+
+static void RegisterMetric(Metric *metric, MetricType type, const char *name, const char *labels, const char *help) {
+    for (int i = 0; i < sMetricCount; ++i) {
+        if (sMetrics[i] == metric) {
+            return;
+        }
+    }
+
+    if (sMetricCount == MAX_METRICS) {
+        printf("ran out of metrics for %s!\n", name);
+        return;
+    }
+
+    memset(metric, 0, sizeof(*metric));
+    metric->name = name;
+    metric->help = help;
+    metric->labels = labels;
+    metric->type = type;
+    sMetrics[sMetricCount++] = metric;
+}
+
+void RegisterCounter(Metric *metric, const char *name, const char *help) {
+    RegisterMetric(metric, METRIC_TYPE_COUNTER, name, NULL, help);
+}
+
+void RegisterGauge(Metric *metric, const char *name, const char *help) {
+    RegisterMetric(metric, METRIC_TYPE_GAUGE, name, NULL, help);
+}
+
+void RegisterHistogram(Metric *metric, const char *name, const char *labels, const char *help) {
+    RegisterMetric(metric, METRIC_TYPE_HISTOGRAM, name, labels, help);
+}
+
+void AddToCounter(Metric *metric, double amount) {
+    if (!gWorld->areMetricsMuted) {
+        metric->value += amount;
+    }
+}
+
+void SetGauge(Metric *metric, double value) {
+    if (!gWorld->areMetricsMuted) {
+        metric->value = value;
+    }
+}
+
+void ObserveHistogram(Metric *metric, double seconds) {
+    if (gWorld->areMetricsMuted) {
+        return;
+    }
+
+    metric->value += seconds;
+    metric->observationCount++;
+
+    // buckets are stored non-cumulative, FormatMetrics adds them up
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKET_COUNT; ++i) {
+        if (seconds <= sHistogramBuckets[i]) {
+            metric->bucketCounts[i]++;
+            break;
+        }
+    }
+}
+
+void SetMetricsMuted(bool isMuted) {
+    gWorld->areMetricsMuted = isMuted;
+}
+
+// snprintf that keeps track of where it's up to, and stops quietly when full
+typedef struct TextWriter {
+    char *buffer;
+    int capacity;
+    int size;
+} TextWriter;
+
+static void WriteText(TextWriter *writer, const char *format, ...) {
+    int remaining = writer->capacity - writer->size;
+    if (remaining <= 0) {
+        return;
+    }
+
+    va_list arguments;
+    va_start(arguments, format);
+    int size = vsnprintf(writer->buffer + writer->size, remaining, format, arguments);
+    va_end(arguments);
+
+    writer->size += size < remaining ? size : remaining - 1;
+}
+
+static void WriteHeader(TextWriter *writer, const char *name, const char *type, const char *help) {
+    WriteText(writer, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void WriteMetric(TextWriter *writer, int index) {
+    const Metric *metric = sMetrics[index];
+
+    // labelled metrics share a name, prometheus only wants the header once
+    bool isFirstWithName = true;
+    for (int i = 0; i < index; ++i) {
+        if (strcmp(sMetrics[i]->name, metric->name) == 0) {
+            isFirstWithName = false;
+            break;
+        }
+    }
+
+    switch (metric->type) {
+        case METRIC_TYPE_COUNTER:
+        case METRIC_TYPE_GAUGE:
+            if (isFirstWithName) {
+                WriteHeader(writer, metric->name, metric->type == METRIC_TYPE_COUNTER ? "counter" : "gauge", metric->help);
+            }
+            WriteText(writer, "%s %.17g\n", metric->name, metric->value);
+            break;
+
+        case METRIC_TYPE_HISTOGRAM: {
+            if (isFirstWithName) {
+                WriteHeader(writer, metric->name, "histogram", metric->help);
+            }
+            const char *labels = metric->labels != NULL ? metric->labels : "";
+            const char *separator = metric->labels != NULL ? "," : "";
+            unsigned long long cumulativeCount = 0;
+
+            for (int i = 0; i < METRICS_HISTOGRAM_BUCKET_COUNT; ++i) {
+                cumulativeCount += metric->bucketCounts[i];
+                WriteText(writer, "%s_bucket{%s%sle=\"%g\"} %llu\n", metric->name, labels, separator, sHistogramBuckets[i], cumulativeCount);
+            }
+            WriteText(writer, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", metric->name, labels, separator, metric->observationCount);
+            if (metric->labels != NULL) {
+                WriteText(writer, "%s_sum{%s} %.17g\n", metric->name, labels, metric->value);
+                WriteText(writer, "%s_count{%s} %llu\n", metric->name, labels, metric->observationCount);
+            }
+            else {
+                WriteText(writer, "%s_sum %.17g\n", metric->name, metric->value);
+                WriteText(writer, "%s_count %llu\n", metric->name, metric->observationCount);
+            }
+            break;
+        }
+    }
+}
+
+int FormatMetrics(char *buffer, int capacity) {
+    TextWriter writer = {buffer, capacity, 0};
+
+    for (int i = 0; i < sMetricCount; ++i) {
+        WriteMetric(&writer, i);
+    }
+
+    // allocators already keep their own stats, no need to double book them
+    WriteHeader(&writer, "pong_arena_used_bytes", "gauge", "Bytes currently allocated from each arena.");
+    for (int i = 0; i < GetTrackedArenaCount(); ++i) {
+        const Arena *arena = GetTrackedArena(i);
+        WriteText(&writer, "pong_arena_used_bytes{arena=\"%s\"} %zu\n", arena->name, arena->used);
+    }
+    WriteHeader(&writer, "pong_arena_capacity_bytes", "gauge", "Size of each arena.");
+    for (int i = 0; i < GetTrackedArenaCount(); ++i) {
+        const Arena *arena = GetTrackedArena(i);
+        WriteText(&writer, "pong_arena_capacity_bytes{arena=\"%s\"} %zu\n", arena->name, arena->capacity);
+    }
+    WriteHeader(&writer, "pong_arena_exhausted_total", "counter", "Allocations that didn't fit in each arena.");
+    for (int i = 0; i < GetTrackedArenaCount(); ++i) {
+        const Arena *arena = GetTrackedArena(i);
+        WriteText(&writer, "pong_arena_exhausted_total{arena=\"%s\"} %d\n", arena->name, arena->failedAllocations);
+    }
+
+    WriteHeader(&writer, "pong_pool_used", "gauge", "Elements currently in use in each pool.");
+    for (int i = 0; i < GetTrackedPoolCount(); ++i) {
+        const Pool *pool = GetTrackedPool(i);
+        WriteText(&writer, "pong_pool_used{pool=\"%s\"} %d\n", pool->name, pool->usedCount);
+    }
+    WriteHeader(&writer, "pong_pool_capacity", "gauge", "Number of elements in each pool.");
+    for (int i = 0; i < GetTrackedPoolCount(); ++i) {
+        const Pool *pool = GetTrackedPool(i);
+        WriteText(&writer, "pong_pool_capacity{pool=\"%s\"} %d\n", pool->name, pool->capacity);
+    }
+    WriteHeader(&writer, "pong_pool_exhausted_total", "counter", "Allocations that found each pool empty.");
+    for (int i = 0; i < GetTrackedPoolCount(); ++i) {
+        const Pool *pool = GetTrackedPool(i);
+        WriteText(&writer, "pong_pool_exhausted_total{pool=\"%s\"} %d\n", pool->name, pool->failedAllocations);
+    }
+
+    WriteHeader(&writer, "pong_memory_static_bytes", "gauge", "Static arrays + buffers each subsystem has registered.");
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; ++tag) {
+        WriteText(&writer, "pong_memory_static_bytes{subsystem=\"%s\"} %zu\n", GetMemoryTagName(tag), GetMemoryUsage(tag).staticBytes);
+    }
+    WriteHeader(&writer, "pong_memory_heap_bytes", "gauge", "Heap memory each subsystem currently holds.");
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; ++tag) {
+        WriteText(&writer, "pong_memory_heap_bytes{subsystem=\"%s\"} %zu\n", GetMemoryTagName(tag), GetMemoryUsage(tag).heapBytes);
+    }
+    WriteHeader(&writer, "pong_memory_heap_allocations_total", "counter", "Heap allocations each subsystem has made.");
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; ++tag) {
+        WriteText(&writer, "pong_memory_heap_allocations_total{subsystem=\"%s\"} %lld\n", GetMemoryTagName(tag), GetMemoryUsage(tag).allocationCount);
+    }
+
+    return writer.size;
+}
+
+bool StartMetricsServer(unsigned short port) {
+    if (!InitNet()) {
+        return false;
+    }
+
+    if (!OpenTcpListener(port, false, &sListener)) {
+        CloseNet();
+        return false;
+    }
+
+    printf("serving metrics on http://127.0.0.1:%u/metrics\n", port);
+    sIsServerRunning = true;
+    return true;
+}
+
+static void CloseClient() {
+    CloseTcpSocket(sClient);
+    sHasClient = false;
+}
+
+void StopMetricsServer() {
+    if (!sIsServerRunning) {
+        return;
+    }
+
+    if (sHasClient) {
+        CloseClient();
+    }
+    CloseTcpSocket(sListener);
+    CloseNet();
+    sIsServerRunning = false;
+}
+
+static void RespondToClient() {
+    bool isMetricsRequest = strncmp(sRequest, "GET /metrics", 12) == 0 || strncmp(sRequest, "GET / ", 6) == 0;
+    char header[128];
+
+    if (!isMetricsRequest) {
+        int headerSize = snprintf(header, sizeof(header), "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        SendTcp(sClient, header, headerSize);
+        return;
+    }
+
+    int bodySize = FormatMetrics(sResponse, sizeof(sResponse));
+    int headerSize = snprintf(header, sizeof(header),
+                              "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\n\r\n", bodySize);
+
+    if (SendTcp(sClient, header, headerSize)) {
+        SendTcp(sClient, sResponse, bodySize);
+    }
+}
+
+void PollMetricsServer() {
+    if (!sIsServerRunning) {
+        return;
+    }
+
+    // one scrape at a time is plenty for a local scraper
+    if (!sHasClient) {
+        if (!AcceptTcpConnection(sListener, &sClient)) {
+            return;
+        }
+        sHasClient = true;
+        sRequestSize = 0;
+        sRequest[0] = '\0';
+        sClientWaitPolls = 0;
+    }
+
+    // the request might trickle in over a few frames
+    int capacity = MAX_REQUEST_SIZE - 1 - sRequestSize;
+    int size = capacity > 0 ? ReceiveTcp(sClient, sRequest + sRequestSize, capacity) : -1;
+
+    if (size == 0 || ++sClientWaitPolls > MAX_CLIENT_WAIT_POLLS) {
+        CloseClient();
+        return;
+    }
+
+    if (size > 0) {
+        sRequestSize += size;
+        sRequest[sRequestSize] = '\0';
+    }
+
+    if (strstr(sRequest, "\r\n\r\n") != NULL || sRequestSize == MAX_REQUEST_SIZE - 1) {
+        RespondToClient();
+        CloseClient();
+    }
+}
@@ -0,0 +1,396 @@
+#include <raylib.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "music.h"
+#include "platform.h"
+#include "log.h"
+#include "memory_usage.h"
+
+// raylib already builds both decoders in, we just need their declarations
+#define STB_VORBIS_HEADER_ONLY
+#include "external/stb_vorbis.c"
+#include "external/qoa.h"
+
+#define QOA_FILE_HEADER_SIZE 8
+#define QOA_FRAME_HEADER_SIZE 8
+#define MAX_QOA_FRAME_SIZE (QOA_FRAME_HEADER_SIZE + QOA_LMS_LEN * 4 * MUSIC_CHANNELS + 8 * QOA_SLICES_PER_FRAME * MUSIC_CHANNELS)
+#define MUSIC_CROSSFADE_FRAMES ((int) (MUSIC_CROSSFADE_TIME * MUSIC_SAMPLE_RATE))
+
+typedef enum MusicFormat {
+    MUSIC_FORMAT_OGG,
+    MUSIC_FORMAT_QOA,
+} MusicFormat;
+
+// one track being decoded, only ever touched by the worker (and StartMusic before it starts)
+typedef struct MusicTrack {
+    bool isOpen;
+    MusicFormat format;
+    int channels;
+    unsigned int frameCount;
+    unsigned int framePosition;
+
+    stb_vorbis *vorbis;
+
+    // qoa decodes a whole frame at a time, so we hang on to whatever the last read didn't need
+    FILE *file;
+    qoa_desc qoa;
+    unsigned char frameBytes[MAX_QOA_FRAME_SIZE];
+    short decodedSamples[QOA_FRAME_LEN * MUSIC_CHANNELS];
+    unsigned int decodedFrameCount;
+    unsigned int decodedFrameCursor;
+} MusicTrack;
+
+static const char *sPaths[MAX_MUSIC_TRACKS];
+static int sPathCount;
+
+// two tracks, so the next one can fade in while the current one fades out
+static MusicTrack sTracks[2];
+static int sCurrentTrack;
+static int sCurrentPath;
+static int sNextPath;
+static bool sIsCrossfading;
+static int sCrossfadeFrame;
+static short sMixBuffer[MUSIC_DECODE_FRAMES * MUSIC_CHANNELS];
+static short sFadeInBuffer[MUSIC_DECODE_FRAMES * MUSIC_CHANNELS];
+
+// single producer (the worker) single consumer (the audio device's thread) ring of interleaved frames.
+// the indices only ever go up, wrapping is handled by masking when they're used
+static short sRing[MUSIC_RING_FRAMES * MUSIC_CHANNELS];
+static atomic_uint sRingWriteIndex;
+static atomic_uint sRingReadIndex;
+static atomic_int sUnderrunCount;
+
+static AudioStream sStream;
+static Thread sWorker;
+static atomic_bool sIsMusicRunning;
+
+static void CloseTrack(MusicTrack *track) {
+    if (track->vorbis != NULL) {
+        stb_vorbis_close(track->vorbis);
+        track->vorbis = NULL;
+    }
+    if (track->file != NULL) {
+        fclose(track->file);
+        track->file = NULL;
+    }
+    track->isOpen = false;
+}
+
+static bool OpenTrack(MusicTrack *track, const char *path) {
+    unsigned int sampleRate = 0;
+
+    track->framePosition = 0;
+    track->decodedFrameCount = 0;
+    track->decodedFrameCursor = 0;
+
+    if (IsFileExtension(path, ".ogg")) {
+        int error;
+        track->format = MUSIC_FORMAT_OGG;
+        track->vorbis = stb_vorbis_open_filename(path, &error, NULL);
+        if (track->vorbis == NULL) {
+            LogMessage("couldn't open %s as ogg!", path);
+            return false;
+        }
+
+        stb_vorbis_info info = stb_vorbis_get_info(track->vorbis);
+        sampleRate = info.sample_rate;
+        track->channels = info.channels;
+        track->frameCount = stb_vorbis_stream_length_in_samples(track->vorbis);
+    }
+    else if (IsFileExtension(path, ".qoa")) {
+        // the header decoder peeks at the first frame's header too
+        unsigned char header[QOA_MIN_FILESIZE];
+        track->format = MUSIC_FORMAT_QOA;
+        track->file = fopen(path, "rb");
+        if (track->file == NULL || fread(header, 1, sizeof(header), track->file) != sizeof(header) ||
+            qoa_decode_header(header, sizeof(header), &track->qoa) == 0) {
+            LogMessage("couldn't open %s as qoa!", path);
+            CloseTrack(track);
+            return false;
+        }
+
+        fseek(track->file, QOA_FILE_HEADER_SIZE, SEEK_SET);
+        sampleRate = track->qoa.samplerate;
+        track->channels = (int) track->qoa.channels;
+        track->frameCount = track->qoa.samples;
+    }
+    else {
+        LogMessage("%s isn't an ogg or qoa file!", path);
+        return false;
+    }
+
+    // no resampling or downmixing, the ring only holds one format
+    if (sampleRate != MUSIC_SAMPLE_RATE || track->channels < 1 || track->channels > MUSIC_CHANNELS) {
+        LogMessage("%s has to be %d Hz mono or stereo!", path, MUSIC_SAMPLE_RATE);
+        CloseTrack(track);
+        return false;
+    }
+
+    track->isOpen = true;
+    return true;
+}
+
+static void RewindTrack(MusicTrack *track) {
+    if (track->format == MUSIC_FORMAT_OGG) {
+        stb_vorbis_seek_start(track->vorbis);
+    }
+    else {
+        fseek(track->file, QOA_FILE_HEADER_SIZE, SEEK_SET);
+    }
+
+    track->framePosition = 0;
+    track->decodedFrameCount = 0;
+    track->decodedFrameCursor = 0;
+}
+
+static bool DecodeQoaFrame(MusicTrack *track) {
+    unsigned char *bytes = track->frameBytes;
+    if (fread(bytes, 1, QOA_FRAME_HEADER_SIZE, track->file) != QOA_FRAME_HEADER_SIZE) {
+        return false;
+    }
+
+    unsigned int frameSize = (unsigned int) bytes[6] << 8 | bytes[7];
+    if (frameSize < QOA_FRAME_HEADER_SIZE || frameSize > MAX_QOA_FRAME_SIZE) {
+        return false;
+    }
+    if (fread(bytes + QOA_FRAME_HEADER_SIZE, 1, frameSize - QOA_FRAME_HEADER_SIZE, track->file) != frameSize - QOA_FRAME_HEADER_SIZE) {
+        return false;
+    }
+
+    unsigned int frameLength;
+    if (qoa_decode_frame(bytes, frameSize, &track->qoa, track->decodedSamples, &frameLength) == 0) {
+        return false;
+    }
+
+    track->decodedFrameCount = frameLength;
+    track->decodedFrameCursor = 0;
+    return true;
+}
+
+// reads up to frameCount stereo frames, returns fewer once the track runs out
+static int ReadTrack(MusicTrack *track, short *frames, int frameCount) {
+    int readCount = 0;
+
+    while (readCount < frameCount) {
+        if (track->format == MUSIC_FORMAT_OGG) {
+            // stb_vorbis copies mono out to both channels for us
+            short *destination = frames + readCount * MUSIC_CHANNELS;
+            int decodedCount = stb_vorbis_get_samples_short_interleaved(track->vorbis, MUSIC_CHANNELS, destination, (frameCount - readCount) * MUSIC_CHANNELS);
+            if (decodedCount == 0) {
+                break;
+            }
+            readCount += decodedCount;
+            continue;
+        }
+
+        if (track->decodedFrameCursor == track->decodedFrameCount && !DecodeQoaFrame(track)) {
+            break;
+        }
+
+        while (readCount < frameCount && track->decodedFrameCursor < track->decodedFrameCount) {
+            const short *source = &track->decodedSamples[track->decodedFrameCursor * track->channels];
+            frames[readCount * MUSIC_CHANNELS] = source[0];
+            frames[readCount * MUSIC_CHANNELS + 1] = source[track->channels - 1];
+            track->decodedFrameCursor++;
+            readCount++;
+        }
+    }
+
+    track->framePosition += readCount;
+    return readCount;
+}
+
+// background music never runs out, it starts over instead
+static void ReadTrackLooping(MusicTrack *track, short *frames, int frameCount) {
+    int readCount = ReadTrack(track, frames, frameCount);
+
+    if (readCount < frameCount) {
+        RewindTrack(track);
+        readCount += ReadTrack(track, frames + readCount * MUSIC_CHANNELS, frameCount - readCount);
+    }
+
+    // a track that can't even fill one read after rewinding is broken, play silence instead of spinning
+    if (readCount < frameCount) {
+        memset(frames + readCount * MUSIC_CHANNELS, 0, (size_t) (frameCount - readCount) * MUSIC_CHANNELS * sizeof(short));
+    }
+}
+
+static void StartCrossfade() {
+    MusicTrack *nextTrack = &sTracks[1 - sCurrentTrack];
+
+    // skip anything that won't open, if nothing does the current track just loops
+    for (int i = 1; i < sPathCount; ++i) {
+        int path = (sCurrentPath + i) % sPathCount;
+        if (OpenTrack(nextTrack, sPaths[path])) {
+            sNextPath = path;
+            sIsCrossfading = true;
+            sCrossfadeFrame = 0;
+            return;
+        }
+    }
+}
+
+static void DecodeMusic(short *frames, int frameCount) {
+    MusicTrack *currentTrack = &sTracks[sCurrentTrack];
+
+    // start fading early enough that the next track is at full volume as this one ends
+    bool isEnding = currentTrack->frameCount - currentTrack->framePosition <= (unsigned int) MUSIC_CROSSFADE_FRAMES;
+    if (!sIsCrossfading && sPathCount > 1 && isEnding) {
+        StartCrossfade();
+    }
+
+    ReadTrackLooping(currentTrack, frames, frameCount);
+
+    if (!sIsCrossfading) {
+        return;
+    }
+
+    MusicTrack *nextTrack = &sTracks[1 - sCurrentTrack];
+    ReadTrackLooping(nextTrack, sFadeInBuffer, frameCount);
+
+    // equal power, so the fade doesn't dip in loudness halfway through
+    for (int i = 0; i < frameCount; ++i) {
+        float t = fminf((float) (sCrossfadeFrame + i) / MUSIC_CROSSFADE_FRAMES, 1);
+        float fadeOutGain = cosf(t * PI / 2);
+        float fadeInGain = sinf(t * PI / 2);
+        for (int channel = 0; channel < MUSIC_CHANNELS; ++channel) {
+            int sample = i * MUSIC_CHANNELS + channel;
+            frames[sample] = (short) (frames[sample] * fadeOutGain + sFadeInBuffer[sample] * fadeInGain);
+        }
+    }
+
+    sCrossfadeFrame += frameCount;
+    if (sCrossfadeFrame >= MUSIC_CROSSFADE_FRAMES) {
+        CloseTrack(currentTrack);
+        sCurrentTrack = 1 - sCurrentTrack;
+        sCurrentPath = sNextPath;
+        sIsCrossfading = false;
+    }
+}
+
+// decodes one step into the ring if there's room for it, returns false if there wasn't
+static bool FillRing() {
+    unsigned int writeIndex = atomic_load_explicit(&sRingWriteIndex, memory_order_relaxed);
+    unsigned int readIndex = atomic_load_explicit(&sRingReadIndex, memory_order_acquire);
+
+    if (MUSIC_RING_FRAMES - (writeIndex - readIndex) < MUSIC_DECODE_FRAMES) {
+        return false;
+    }
+
+    DecodeMusic(sMixBuffer, MUSIC_DECODE_FRAMES);
+
+    for (int i = 0; i < MUSIC_DECODE_FRAMES; ++i) {
+        unsigned int slot = (writeIndex + (unsigned int) i) & (MUSIC_RING_FRAMES - 1);
+        sRing[slot * MUSIC_CHANNELS] = sMixBuffer[i * MUSIC_CHANNELS];
+        sRing[slot * MUSIC_CHANNELS + 1] = sMixBuffer[i * MUSIC_CHANNELS + 1];
+    }
+
+    // publishes the samples written above
+    atomic_store_explicit(&sRingWriteIndex, writeIndex + MUSIC_DECODE_FRAMES, memory_order_release);
+    return true;
+}
+
+static void RunMusicWorker(void *userData) {
+    (void) userData;
+    while (atomic_load(&sIsMusicRunning)) {
+        if (!FillRing()) {
+            SleepSeconds(MUSIC_WORKER_SLEEP_TIME);
+        }
+    }
+}
+
+// runs on the audio device's thread, it can't wait on anything so it only ever copies what's ready
+static void FillDeviceBuffer(void *buffer, unsigned int frameCount) {
+    short *frames = buffer;
+    unsigned int readIndex = atomic_load_explicit(&sRingReadIndex, memory_order_relaxed);
+    unsigned int writeIndex = atomic_load_explicit(&sRingWriteIndex, memory_order_acquire);
+    unsigned int availableCount = writeIndex - readIndex;
+    unsigned int copyCount = availableCount < frameCount ? availableCount : frameCount;
+
+    for (unsigned int i = 0; i < copyCount; ++i) {
+        unsigned int slot = (readIndex + i) & (MUSIC_RING_FRAMES - 1);
+        frames[i * MUSIC_CHANNELS] = sRing[slot * MUSIC_CHANNELS];
+        frames[i * MUSIC_CHANNELS + 1] = sRing[slot * MUSIC_CHANNELS + 1];
+    }
+
+    // the worker fell behind, a gap of silence beats stalling the device
+    if (copyCount < frameCount) {
+        memset(frames + copyCount * MUSIC_CHANNELS, 0, (frameCount - copyCount) * MUSIC_CHANNELS * sizeof(short));
+        atomic_fetch_add(&sUnderrunCount, 1);
+    }
+
+    // hands the slots we just read back to the worker
+    atomic_store_explicit(&sRingReadIndex, readIndex + copyCount, memory_order_release);
+}
+
+bool StartMusic(const char **paths, int count) {
+    if (count > MAX_MUSIC_TRACKS) {
+        count = MAX_MUSIC_TRACKS;
+    }
+    for (int i = 0; i < count; ++i) {
+        sPaths[i] = paths[i];
+    }
+    sPathCount = count;
+    // the buffers are static, they're there whether or not a track opens
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_MUSIC, sTracks);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_MUSIC, sMixBuffer);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_MUSIC, sFadeInBuffer);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_MUSIC, sRing);
+
+    // the first track that opens starts things off
+    sCurrentTrack = 0;
+    sCurrentPath = 0;
+    while (sCurrentPath < sPathCount && !OpenTrack(&sTracks[0], sPaths[sCurrentPath])) {
+        sCurrentPath++;
+    }
+    if (sCurrentPath == sPathCount) {
+        printf("no music to play!\n");
+        return false;
+    }
+
+    atomic_init(&sRingWriteIndex, 0);
+    atomic_init(&sRingReadIndex, 0);
+    atomic_init(&sUnderrunCount, 0);
+
+    // fill up before the device starts pulling, so it doesn't open on silence
+    while (FillRing()) {
+    }
+
+    atomic_store(&sIsMusicRunning, true);
+    if (!StartThread(&sWorker, RunMusicWorker, NULL)) {
+        printf("couldn't start the music thread!\n");
+        atomic_store(&sIsMusicRunning, false);
+        CloseTrack(&sTracks[0]);
+        return false;
+    }
+
+    SetAudioStreamBufferSizeDefault(MUSIC_DEVICE_BUFFER_FRAMES);
+    sStream = LoadAudioStream(MUSIC_SAMPLE_RATE, 16, MUSIC_CHANNELS);
+    SetAudioStreamBufferSizeDefault(0);
+    SetAudioStreamCallback(sStream, FillDeviceBuffer);
+    SetAudioStreamVolume(sStream, MUSIC_VOLUME);
+    PlayAudioStream(sStream);
+    return true;
+}
+
+void StopMusic() {
+    if (!atomic_load(&sIsMusicRunning)) {
+        return;
+    }
+
+    // the device stops pulling before the worker stops pushing
+    StopAudioStream(sStream);
+    UnloadAudioStream(sStream);
+
+    atomic_store(&sIsMusicRunning, false);
+    JoinThread(&sWorker);
+    CloseTrack(&sTracks[0]);
+    CloseTrack(&sTracks[1]);
+
+    int underrunCount = atomic_load(&sUnderrunCount);
+    if (underrunCount > 0) {
+        printf("music ran dry %d times!\n", underrunCount);
+    }
+}
@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <string.h>
+#include "net.h"
+#include "log.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#define CLOSE_SOCKET closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#define CLOSE_SOCKET close
+#endif
+
+// a peer hanging up mid-send shouldn't kill the whole game with SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+bool InitNet() {
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        printf("couldn't start winsock!\n");
+        return false;
+    }
+#endif
+    return true;
+}
+
+void CloseNet() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+// small messages go out straight away instead of waiting to be batched with the next one
+static void SetSocketNoDelay(intptr_t handle) {
+    int isNoDelay = 1;
+    setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char *) &isNoDelay, sizeof(isNoDelay));
+}
+
+static void SetSocketNonBlocking(intptr_t handle) {
+#ifdef _WIN32
+    u_long isNonBlocking = 1;
+    ioctlsocket(handle, FIONBIO, &isNonBlocking);
+#else
+    fcntl((int) handle, F_SETFL, fcntl((int) handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+bool OpenUdpSocket(unsigned short port, intptr_t *result) {
+    intptr_t handle = (intptr_t) socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+#ifdef _WIN32
+    if ((SOCKET) handle == INVALID_SOCKET) {
+#else
+    if (handle < 0) {
+#endif
+        printf("couldn't create a udp socket!\n");
+        return false;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(handle, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        printf("couldn't bind udp port %u!\n", port);
+        CLOSE_SOCKET(handle);
+        return false;
+    }
+
+    // never block the game loop waiting on the network
+    SetSocketNonBlocking(handle);
+
+    *result = handle;
+    return true;
+}
+
+void CloseUdpSocket(intptr_t socket) {
+    CLOSE_SOCKET(socket);
+}
+
+bool ResolveNetAddress(const char *host, unsigned short port, NetAddress *address) {
+    struct addrinfo hints;
+    struct addrinfo *results = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if (getaddrinfo(host, NULL, &hints, &results) != 0 || results == NULL) {
+        printf("couldn't resolve %s!\n", host);
+        return false;
+    }
+
+    struct sockaddr_in *resolved = (struct sockaddr_in *) results->ai_addr;
+    address->host = ntohl(resolved->sin_addr.s_addr);
+    address->port = port;
+    freeaddrinfo(results);
+    return true;
+}
+
+bool SendUdp(intptr_t socket, NetAddress to, const void *data, int size) {
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(to.host);
+    address.sin_port = htons(to.port);
+
+    return sendto(socket, data, size, 0, (struct sockaddr *) &address, sizeof(address)) == size;
+}
+
+int ReceiveUdp(intptr_t socket, NetAddress *from, void *buffer, int capacity) {
+    struct sockaddr_in address;
+    socklen_t addressSize = sizeof(address);
+    int size = (int) recvfrom(socket, buffer, capacity, 0, (struct sockaddr *) &address, &addressSize);
+
+    if (size < 0) {
+        return -1;
+    }
+
+    from->host = ntohl(address.sin_addr.s_addr);
+    from->port = ntohs(address.sin_port);
+    return size;
+}
+
+bool OpenTcpListener(unsigned short port, bool isLanVisible, intptr_t *result) {
+    intptr_t handle = (intptr_t) socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+#ifdef _WIN32
+    if ((SOCKET) handle == INVALID_SOCKET) {
+#else
+    if (handle < 0) {
+#endif
+        printf("couldn't create a tcp socket!\n");
+        return false;
+    }
+
+    int isReusable = 1;
+    setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char *) &isReusable, sizeof(isReusable));
+
+    // only this machine gets to look, unless it's for the whole lan
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(isLanVisible ? INADDR_ANY : INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    // a lan crowd all turns up at once when a match starts
+    int backlog = isLanVisible ? SOMAXCONN : 4;
+
+    if (bind(handle, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(handle, backlog) != 0) {
+        printf("couldn't listen on tcp port %u!\n", port);
+        CLOSE_SOCKET(handle);
+        return false;
+    }
+
+    SetSocketNonBlocking(handle);
+    *result = handle;
+    return true;
+}
+
+bool AcceptTcpConnection(intptr_t listener, intptr_t *result) {
+    intptr_t handle = (intptr_t) accept(listener, NULL, NULL);
+
+#ifdef _WIN32
+    if ((SOCKET) handle == INVALID_SOCKET) {
+#else
+    if (handle < 0) {
+#endif
+        return false;
+    }
+
+    SetSocketNoDelay(handle);
+    SetSocketNonBlocking(handle);
+    *result = handle;
+    return true;
+}
+
+int ReceiveTcp(intptr_t socket, void *buffer, int capacity) {
+    int size = (int) recv(socket, buffer, capacity, 0);
+    return size < 0 ? -1 : size;
+}
+
+bool SendTcp(intptr_t socket, const void *data, int size) {
+    const char *cursor = data;
+
+    while (size > 0) {
+        int sentSize = (int) send(socket, cursor, size, SEND_FLAGS);
+        if (sentSize <= 0) {
+            return false;
+        }
+        cursor += sentSize;
+        size -= sentSize;
+    }
+    return true;
+}
+
+int SendTcpPartial(intptr_t socket, const void *data, int size) {
+    int sentSize = (int) send(socket, data, size, SEND_FLAGS);
+    if (sentSize >= 0) {
+        return sentSize;
+    }
+
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+#else
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+#endif
+}
+
+bool ConnectTcp(NetAddress to, intptr_t *result) {
+    intptr_t handle = (intptr_t) socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+#ifdef _WIN32
+    if ((SOCKET) handle == INVALID_SOCKET) {
+#else
+    if (handle < 0) {
+#endif
+        printf("couldn't create a tcp socket!\n");
+        return false;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(to.host);
+    address.sin_port = htons(to.port);
+
+    if (connect(handle, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        printf("couldn't connect to port %u!\n", to.port);
+        CLOSE_SOCKET(handle);
+        return false;
+    }
+
+    SetSocketNoDelay(handle);
+    SetSocketNonBlocking(handle);
+    *result = handle;
+    return true;
+}
+
+void CloseTcpSocket(intptr_t socket) {
+    CLOSE_SOCKET(socket);
+}
+
+static float SimulatedRandomFloat(SimulatedChannel *channel) {
+    unsigned int x = channel->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    channel->randomState = x;
+    return (float) (x >> 8) / (float) (1 << 24);
+}
+
+void InitSimulatedChannel(SimulatedChannel *channel, float latency, float jitter, float lossPercent, unsigned int seed) {
+    channel->now = 0;
+    channel->latency = latency;
+    channel->jitter = jitter;
+    channel->lossPercent = lossPercent;
+    channel->randomState = seed != 0 ? seed : 1;
+    channel->packetCount = 0;
+    channel->sentCount = 0;
+    channel->droppedCount = 0;
+}
+
+static bool SendOverSimulatedChannel(SimulatedChannel *channel, const void *data, int size) {
+    channel->sentCount++;
+
+    if (SimulatedRandomFloat(channel) * 100 < channel->lossPercent || channel->packetCount == MAX_SIMULATED_PACKETS) {
+        channel->droppedCount++;
+        return true; // as far as the sender knows it went out fine
+    }
+
+    SimulatedPacket *packet = &channel->packets[channel->packetCount++];
+    packet->deliveryTime = channel->now + channel->latency + SimulatedRandomFloat(channel) * channel->jitter;
+    packet->size = size;
+    memcpy(packet->data, data, size);
+    return true;
+}
+
+static int ReceiveFromSimulatedChannel(SimulatedChannel *channel, void *buffer, int capacity) {
+    // jitter can reorder packets, so hand out whichever arrived first
+    int earliest = -1;
+
+    for (int i = 0; i < channel->packetCount; ++i) {
+        SimulatedPacket *packet = &channel->packets[i];
+        if (packet->deliveryTime <= channel->now && (earliest == -1 || packet->deliveryTime < channel->packets[earliest].deliveryTime)) {
+            earliest = i;
+        }
+    }
+
+    if (earliest == -1) {
+        return -1;
+    }
+
+    SimulatedPacket *packet = &channel->packets[earliest];
+    int size = packet->size < capacity ? packet->size : capacity;
+    memcpy(buffer, packet->data, size);
+    *packet = channel->packets[--channel->packetCount];
+    return size;
+}
+
+bool SendOverLink(NetLink *link, const void *data, int size) {
+    if (size > MAX_PACKET_SIZE) {
+        LogMessage("packet too big to send!");
+        return false;
+    }
+
+    switch (link->type) {
+        case NET_LINK_UDP:
+            return link->udp.hasPeer && SendUdp(link->udp.socket, link->udp.peer, data, size);
+        case NET_LINK_SIMULATED:
+            return SendOverSimulatedChannel(link->simulated.outgoing, data, size);
+    }
+    return false;
+}
+
+int ReceiveFromLink(NetLink *link, void *buffer, int capacity) {
+    switch (link->type) {
+        case NET_LINK_UDP: {
+            NetAddress from;
+            int size;
+
+            // whoever talks to us first becomes our peer, everyone else is ignored
+            while ((size = ReceiveUdp(link->udp.socket, &from, buffer, capacity)) >= 0) {
+                if (!link->udp.hasPeer) {
+                    link->udp.peer = from;
+                    link->udp.hasPeer = true;
+                }
+                if (from.host == link->udp.peer.host && from.port == link->udp.peer.port) {
+                    return size;
+                }
+            }
+            return -1;
+        }
+        case NET_LINK_SIMULATED:
+            return ReceiveFromSimulatedChannel(link->simulated.incoming, buffer, capacity);
+    }
+    return -1;
+}
@@ -0,0 +1,225 @@
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "netplay.h"
+#include "rollback.h"
+#include "game.h"
+#include "sound.h"
+#include "platform.h"
+#include "memory_usage.h"
+
+// the real game only ever has the one session, the loopback test allocates its peer's
+static RollbackSession sSession;
+static NetLink sLinks[MAX_PLAYERS];
+static bool sIsNetplayActive;
+static float sTickAccumulator;
+
+static bool StartNetplay(unsigned short localPort, int localPlayer, unsigned int seed) {
+    if (!InitNet()) {
+        return false;
+    }
+
+    NetLink *link = &sLinks[0];
+    link->type = NET_LINK_UDP;
+    link->udp.hasPeer = false;
+
+    if (!OpenUdpSocket(localPort, &link->udp.socket)) {
+        CloseNet();
+        return false;
+    }
+
+    InitRollbackSession(&sSession, link, localPlayer, seed);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sSession);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sLinks);
+    sIsNetplayActive = true;
+    sTickAccumulator = 0;
+    return true;
+}
+
+bool StartNetplayHost(unsigned short port) {
+    printf("hosting on port %u\n", port);
+    return StartNetplay(port, 0, (unsigned int) time(NULL));
+}
+
+bool StartNetplayJoin(const char *host, unsigned short port) {
+    NetAddress address;
+    if (!ResolveNetAddress(host, port, &address)) {
+        return false;
+    }
+
+    if (!StartNetplay(0, 1, 0)) {
+        return false;
+    }
+
+    sLinks[0].udp.peer = address;
+    sLinks[0].udp.hasPeer = true;
+    printf("joining %s:%u\n", host, port);
+    return true;
+}
+
+void StopNetplay() {
+    if (!sIsNetplayActive) {
+        return;
+    }
+    CloseUdpSocket(sLinks[0].udp.socket);
+    CloseNet();
+    sIsNetplayActive = false;
+}
+
+bool IsNetplayActive() {
+    return sIsNetplayActive;
+}
+
+int GetLocalPlayer() {
+    return sIsNetplayActive ? sSession.localPlayer : 0;
+}
+
+void UpdateNetplay(float frameTime) {
+    sTickAccumulator += frameTime;
+    int tickCount = 0;
+    double now = GetMonotonicTime();
+
+    while (sTickAccumulator >= SIMULATION_TICK_TIME && tickCount < MAX_TICKS_PER_FRAME) {
+        PlayerInput input = TakeLocalInput(sSession.localPlayer, GetTickEndTime(now, sTickAccumulator));
+        AdvanceRollbackSession(&sSession, input);
+        sTickAccumulator -= SIMULATION_TICK_TIME;
+        tickCount++;
+    }
+
+    if (tickCount == MAX_TICKS_PER_FRAME) {
+        sTickAccumulator = 0;
+    }
+}
+
+void RenderNetplayStatus() {
+    if (!sIsNetplayActive) {
+        return;
+    }
+
+    RollbackSession *session = &sSession;
+
+    if (!session->isConnected) {
+        DrawText("waiting for the other player...", 10, 10, 20, GRAY);
+        return;
+    }
+
+    DrawText(TextFormat("P%d  tick %d  rollbacks %d  stalls %d", session->localPlayer + 1, session->currentTick,
+                        session->rollbackCount, session->stallCount), 10, 10, 10, GRAY);
+
+    if (session->desyncTick != -1) {
+        DrawText(TextFormat("DESYNC at tick %d", session->desyncTick), 10, 24, 20, RED);
+    }
+}
+
+static PlayerInput GetLoopbackBotInput(unsigned int *randomState, PlayerInput previousInput) {
+    unsigned int x = *randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *randomState = x;
+
+    // mostly hold whatever we were doing so inputs look like a person's
+    if (x % 100 < 90) {
+        return previousInput & ~INPUT_CONFIRM;
+    }
+
+    PlayerInput input = (PlayerInput) ((x >> 8) & (INPUT_UP | INPUT_DOWN | INPUT_LEFT | INPUT_RIGHT));
+    if ((x >> 16) % 10 == 0) {
+        input |= INPUT_CONFIRM;
+    }
+    return input;
+}
+
+int RunLoopbackTest(int tickCount, float latency, float lossPercent) {
+    static unsigned char worlds[MAX_PLAYERS][WORLD_SNAPSHOT_CAPACITY];
+    static size_t worldSizes[MAX_PLAYERS];
+    static SimulatedChannel channels[MAX_PLAYERS];
+
+    printf("loopback test: %d ticks, %.0f ms latency, %.1f%% loss\n", tickCount, latency * 1000, lossPercent);
+    SetSoundsMuted(true);
+
+    // we play the first player in the same session the real game uses, the others are ~11 MB
+    // of snapshots each that nothing but this test needs
+    RollbackSession *sessions[MAX_PLAYERS] = {&sSession};
+    for (int i = 1; i < MAX_PLAYERS; ++i) {
+        sessions[i] = malloc(sizeof(RollbackSession));
+        if (sessions[i] == NULL) {
+            printf("couldn't allocate a session for P%d!\n", i + 1);
+            for (int j = 1; j < i; ++j) {
+                free(sessions[j]);
+            }
+            return 1;
+        }
+    }
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sSession);
+    TrackHeapAllocation(MEMORY_TAG_NETWORK, (MAX_PLAYERS - 1) * sizeof(RollbackSession));
+
+    // run the normal startup once so every bit of world state is registered,
+    // then each peer gets its own copy that we swap in while it's their turn
+    SetPlayerCount(MAX_PLAYERS);
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        worldSizes[i] = SaveSnapshot(worlds[i], WORLD_SNAPSHOT_CAPACITY);
+        InitSimulatedChannel(&channels[i], latency, latency * 0.25f, lossPercent, 1234 + i);
+
+        // channel i carries packets sent by player i
+        sLinks[i].type = NET_LINK_SIMULATED;
+        sLinks[i].simulated.outgoing = &channels[i];
+        sLinks[i].simulated.incoming = &channels[1 - i];
+        InitRollbackSession(sessions[i], &sLinks[i], i, i == 0 ? 42 : 0);
+    }
+
+    unsigned int botRandomStates[MAX_PLAYERS] = {0x1234567u, 0x89ABCDEu};
+    PlayerInput botInputs[MAX_PLAYERS] = {0};
+    double maxAdvanceTime = 0;
+
+    for (int step = 0; step < tickCount; ++step) {
+        for (int i = 0; i < MAX_PLAYERS; ++i) {
+            channels[i].now = step * (double) SIMULATION_TICK_TIME;
+        }
+
+        for (int i = 0; i < MAX_PLAYERS; ++i) {
+            botInputs[i] = GetLoopbackBotInput(&botRandomStates[i], botInputs[i]);
+
+            LoadSnapshot(worlds[i], worldSizes[i]);
+            double startTime = GetMonotonicTime();
+            AdvanceRollbackSession(sessions[i], botInputs[i]);
+            double elapsedTime = GetMonotonicTime() - startTime;
+            worldSizes[i] = SaveSnapshot(worlds[i], WORLD_SNAPSHOT_CAPACITY);
+
+            if (elapsedTime > maxAdvanceTime) {
+                maxAdvanceTime = elapsedTime;
+            }
+        }
+    }
+
+    bool isInSync = true;
+
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        RollbackSession *session = sessions[i];
+        double averageTickTime = session->resimulatedTickCount > 0 ? session->totalRollbackTime / session->resimulatedTickCount : 0;
+
+        printf("P%d: tick %d, %d rollbacks (%d ticks, max %d), %d stalls, %d time sync skips\n",
+               i + 1, session->currentTick, session->rollbackCount, session->resimulatedTickCount,
+               session->maxRollbackTicks, session->stallCount, session->timeSyncSkipCount);
+        printf("    rollback max %.3f ms, %.4f ms per re-simulated tick (%d ticks = %.3f ms)\n",
+               session->maxRollbackTime * 1000, averageTickTime * 1000,
+               ROLLBACK_MAX_TICKS, averageTickTime * ROLLBACK_MAX_TICKS * 1000);
+        printf("    %d checksums verified, %d/%d packets dropped\n",
+               session->verifiedChecksumCount, channels[i].droppedCount, channels[i].sentCount);
+
+        if (!session->isConnected || session->desyncTick != -1 || session->verifiedChecksumCount == 0) {
+            isInSync = false;
+        }
+    }
+
+    printf("worst single advance %.3f ms\n", maxAdvanceTime * 1000);
+    for (int i = 1; i < MAX_PLAYERS; ++i) {
+        free(sessions[i]);
+    }
+    TrackHeapRelease(MEMORY_TAG_NETWORK, (MAX_PLAYERS - 1) * sizeof(RollbackSession));
+    printf(isInSync ? "loopback test PASSED\n" : "loopback test FAILED\n");
+    return isInSync ? 0 : 1;
+}
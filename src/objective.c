@@ -6,80 +6,96 @@
 #include "game.h"
 #include "player.h"
 #include "particles.h"
+#include "math_util.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "render_list.h"
+#include "field.h"
+#include "timer_wheel.h"
+#include "world.h"
 
-#define OBJECTIVE_GROUP_SIZE 3
 #define OBJECTIVE_SIZE 40        // in pixels
 #define OBJECTIVE_ANIM_TIME 15   // in weight lerp units
 #define OBJECTIVE_DELAY_TIME 1   // in seconds
 #define OBJECTIVE_ROTATE_SPEED 2 // in degrees per second
 
-typedef struct Objective {
-    Vector2 position;
-    float size;
-    bool isCollected;
-} Objective;
-
-int gCollectedObjectives;
-int gHighScoreObjectives;
-
-static Objective sObjectives[OBJECTIVE_GROUP_SIZE];
-static float sObjectiveDelayTime;
-static ObjectiveState sCurrentObjectiveState;
+static void HandleObjectivesReady(int target) {
+    (void) target;
+    ObjectiveWorld *objectives = &gWorld->objectives;
+    objectives->timer = TIMER_NONE;
+    ChangeObjectiveStateTo(OBJECTIVE_STATE_ACTIVE);
+}
 
 void InitObjectives() {
-    gCollectedObjectives = 0;
+    ObjectiveWorld *objectives = &gWorld->objectives;
+    objectives->collectedCount = 0;
     for (int i = 0; i < OBJECTIVE_GROUP_SIZE; ++i) {
-        sObjectives[i].size = 0;
+        objectives->instances[i].size = 0;
     }
+    objectives->timer = TIMER_NONE;
+    SetTimerHandler(TIMER_EVENT_OBJECTIVES_READY, HandleObjectivesReady);
     ChangeObjectiveStateTo(OBJECTIVE_STATE_DELAYED);
+
+    REGISTER_SNAPSHOT_VARIABLE(objectives->instances);
+    REGISTER_SNAPSHOT_VARIABLE(objectives->timer);
+    REGISTER_SNAPSHOT_VARIABLE(objectives->currentState);
+    REGISTER_SNAPSHOT_VARIABLE(objectives->collectedCount);
+    REGISTER_SNAPSHOT_VARIABLE(objectives->highScore);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_OBJECTIVES, objectives->instances);
 }
 
 void ChangeObjectiveStateTo(ObjectiveState state) {
-    sCurrentObjectiveState = state;
+    ObjectiveWorld *objectives = &gWorld->objectives;
+    objectives->currentState = state;
 
     switch (state) {
         case OBJECTIVE_STATE_ACTIVE: {
+            // somewhere on screen around the first player, so on a big field they're still reachable
+            Rectangle view = GetViewAround(GetPlayerPosition(0));
+
             for (int i = 0; i < OBJECTIVE_GROUP_SIZE; ++i) {
-                sObjectives[i].isCollected = false;
-                sObjectives[i].position.x = (float) GetRandomValue(OBJECTIVE_SIZE, GAME_WIDTH - OBJECTIVE_SIZE);
-                sObjectives[i].position.y = (float) GetRandomValue(OBJECTIVE_SIZE, GAME_HEIGHT - OBJECTIVE_SIZE);
-                sObjectives[i].size = 0;
+                objectives->instances[i].isCollected = false;
+                objectives->instances[i].position.x = view.x + (float) RandomInt(OBJECTIVE_SIZE, (int) view.width - OBJECTIVE_SIZE);
+                objectives->instances[i].position.y = view.y + (float) RandomInt(OBJECTIVE_SIZE, (int) view.height - OBJECTIVE_SIZE);
+                objectives->instances[i].size = 0;
             }
             break;
         }
         case OBJECTIVE_STATE_DELAYED: {
             for (int i = 0; i < OBJECTIVE_GROUP_SIZE; ++i) {
-                sObjectives[i].isCollected = true;
+                objectives->instances[i].isCollected = true;
             }
-            sObjectiveDelayTime = OBJECTIVE_DELAY_TIME;
+            CancelTimer(objectives->timer);
+            objectives->timer = ScheduleTimer(TIMER_EVENT_OBJECTIVES_READY, 0, SECONDS_TO_TICKS(OBJECTIVE_DELAY_TIME));
             break;
         }
     }
 }
 
 void UpdateObjectives(float deltaTime) {
+    ObjectiveWorld *objectives = &gWorld->objectives;
     // update objective size
     for (int i = 0; i < OBJECTIVE_GROUP_SIZE; ++i) {
-        float targetSize = sObjectives[i].isCollected ? 0.0f : OBJECTIVE_SIZE;
-        sObjectives[i].size = Lerp(sObjectives[i].size, targetSize, OBJECTIVE_ANIM_TIME * deltaTime);
+        float targetSize = objectives->instances[i].isCollected ? 0.0f : OBJECTIVE_SIZE;
+        objectives->instances[i].size = Lerp(objectives->instances[i].size, targetSize, OBJECTIVE_ANIM_TIME * deltaTime);
     }
 
     // state logic
-    switch (sCurrentObjectiveState) {
+    switch (objectives->currentState) {
         case OBJECTIVE_STATE_ACTIVE: {
             // check collision
             for (int i = 0; i < OBJECTIVE_GROUP_SIZE; ++i) {
-                if (!sObjectives[i].isCollected && CheckCollisionCircleRec(sObjectives[i].position, OBJECTIVE_SIZE, GetPlayerRect())) {
-                    PlaySound(gObjectiveCollectSound);
-                    PlayParticleBurst(sObjectives[i].position, YELLOW, 5);
-                    sObjectives[i].isCollected = true;
-                    gCollectedObjectives++;
+                if (!objectives->instances[i].isCollected && FindPlayerTouchingCircle(objectives->instances[i].position, OBJECTIVE_SIZE) != -1) {
+                    PlayGameSound(GAME_SOUND_OBJECTIVE_COLLECT);
+                    PlayParticleBurst(objectives->instances[i].position, YELLOW, 5);
+                    objectives->instances[i].isCollected = true;
+                    objectives->collectedCount++;
 
                     // check to see if we collected everything
                     int remainingObjectives = OBJECTIVE_GROUP_SIZE;
 
                     for (int j = 0; j < OBJECTIVE_GROUP_SIZE; ++j) {
-                        if (sObjectives[j].isCollected) {
+                        if (objectives->instances[j].isCollected) {
                             remainingObjectives--;
                         }
                     }
@@ -91,26 +107,45 @@ void UpdateObjectives(float deltaTime) {
             }
             break;
         }
-        case OBJECTIVE_STATE_DELAYED: {
-            sObjectiveDelayTime -= deltaTime;
-            if (sObjectiveDelayTime <= 0) {
-                ChangeObjectiveStateTo(OBJECTIVE_STATE_ACTIVE);
-            }
+        case OBJECTIVE_STATE_DELAYED:
+            // HandleObjectivesReady brings them back
             break;
+    }
+}
+
+bool GetNearestObjective(Vector2 position, Vector2 *result) {
+    ObjectiveWorld *objectives = &gWorld->objectives;
+    bool isFound = false;
+
+    for (int i = 0; i < OBJECTIVE_GROUP_SIZE; ++i) {
+        if (objectives->instances[i].isCollected) {
+            continue;
+        }
+        if (!isFound || Vector2DistanceSqr(position, objectives->instances[i].position) < Vector2DistanceSqr(position, *result)) {
+            *result = objectives->instances[i].position;
+            isFound = true;
         }
     }
+    return isFound;
 }
 
-void RenderObjectives() {
-    bool isSettingHighscore = gCollectedObjectives > gHighScoreObjectives;
-    DrawText(TextFormat("%u collected", gCollectedObjectives), 190, 200, 20, isSettingHighscore ? GREEN : RED);
-    DrawText(TextFormat("%u highscore", gHighScoreObjectives), 190, 180, 20, WHITE);
+void RenderScore() {
+    ObjectiveWorld *objectives = &gWorld->objectives;
+    bool isSettingHighscore = objectives->collectedCount > objectives->highScore;
+    DrawText(TextFormat("%u collected", objectives->collectedCount), 190, 200, 20, isSettingHighscore ? GREEN : RED);
+    DrawText(TextFormat("%u highscore", objectives->highScore), 190, 180, 20, WHITE);
+}
 
+void RenderObjectives() {
+    ObjectiveWorld *objectives = &gWorld->objectives;
     for (int i = 0; i < OBJECTIVE_GROUP_SIZE; ++i) {
-        float size = sObjectives[i].size;
+        float size = objectives->instances[i].size;
+        Vector2 position = objectives->instances[i].position;
+        if (!IsCircleInView(position, size)) {
+            continue;
+        }
 
         // construct triangle in local space
-        Vector2 position = sObjectives[i].position;
         Vector2 vertexA = {.x = 0, .y = 0.43f};
         Vector2 vertexB = {.x = -0.5f, .y = -0.43f};
         Vector2 vertexC = {.x = 0.5f, .y = -0.43f};
@@ -127,6 +162,6 @@ void RenderObjectives() {
         vertexC = Vector2Transform(vertexC, matrix);
 
         // render triangle
-        DrawTriangle(vertexC, vertexB, vertexA, YELLOW);
+        RecordTriangle(RENDER_LAYER_BACKGROUND, vertexC, vertexB, vertexA, YELLOW);
     }
 }
@@ -1,57 +1,79 @@
 #include <raylib.h>
 #include <raymath.h>
-#include <stdio.h>
 #include "particles.h"
 #include "math_util.h"
+#include "arena.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "render_list.h"
+#include "span_math.h"
+#include "field.h"
+#include "timer_wheel.h"
+#include "world.h"
 
-#define MAX_PARTICLES 100
-#define MAX_PARTICLE_BURSTS 10 
 #define BURST_DURATION 1          // in seconds
 #define PARTICLE_SIZE 5           // in pixels
 #define PARTICLE_SPEED 100        // in pixels per second
 
-typedef struct ParticleInstance {
-    Vector2 position;
-    Vector2 velocity;
-} ParticleInstance;
+static void HandleParticleBurstDone(int poolIndex) {
+    ParticleWorld *particles = &gWorld->particles;
+    for (int i = 0; i < particles->activeBurstCount; ++i) {
+        if (particles->activeBursts[i] == poolIndex) {
+            particles->activeBursts[i] = particles->activeBursts[--particles->activeBurstCount];
+            break;
+        }
+    }
+    ReleaseToPool(&particles->burstPool, GetPoolElement(&particles->burstPool, poolIndex));
+}
 
-typedef struct ParticleBurstInstance {
-    ParticleInstance particles[MAX_PARTICLES];
-    int particleCount;
-    Color color;
-    float elapsedTime;
-} ParticleBurstInstance;
+void InitParticles() {
+    ParticleWorld *particles = &gWorld->particles;
+    INIT_STATIC_POOL(particles->burstPool);
+    particles->activeBurstCount = 0;
 
-static ParticleBurstInstance sParticleBursts[MAX_PARTICLE_BURSTS];
+    REGISTER_SNAPSHOT_ARRAY(particles->activeBursts, particles->activeBurstCount);
+    RegisterSnapshotPool(&particles->burstPool);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_PARTICLES, particles->activeBursts, particles->activeBurstCount);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_PARTICLES, particles->burstPoolStorage);
+    SetTimerHandler(TIMER_EVENT_PARTICLE_BURST_DONE, HandleParticleBurstDone);
+}
 
 void PlayParticleBurst(Vector2 position, Color color, int amount) {
-    for (int i = 0; i < MAX_PARTICLE_BURSTS; ++i) {
-        ParticleBurstInstance *burst = &sParticleBursts[i];
-        if (burst->elapsedTime == -1) {
-            burst->elapsedTime = 0;
-            burst->color = color;
-            burst->particleCount = amount;
-            for (int j = 0; j < amount; ++j) {
-                burst->particles[j].position = position;
-                burst->particles[j].velocity = Vector2Scale(RandomPointOnUnitCircle(), PARTICLE_SPEED);
-            } 
-            return;
-        }
+    ParticleWorld *particles = &gWorld->particles;
+    ParticleBurstInstance *burst = AllocateFromPool(&particles->burstPool);
+
+    // the pool counts the miss, it shows up as pong_pool_exhausted_total
+    if (burst == NULL) {
+        return;
+    }
+
+    float *directionX = FRAME_ALLOCATE_ARRAY(float, amount);
+    float *directionY = FRAME_ALLOCATE_ARRAY(float, amount);
+    int poolIndex = GetPoolIndex(&particles->burstPool, burst);
+    if (directionX == NULL || directionY == NULL ||
+        ScheduleTimer(TIMER_EVENT_PARTICLE_BURST_DONE, poolIndex, SECONDS_TO_TICKS(BURST_DURATION)) == TIMER_NONE) {
+        ReleaseToPool(&particles->burstPool, burst);
+        return;
     }
-    printf("RAN OUT OF PARTICLES\n");
+    RandomPointOnUnitCircleSpan(directionX, directionY, amount);
+
+    burst->startTick = GetTimerTick();
+    burst->color = color;
+    burst->particleCount = amount;
+    for (int j = 0; j < amount; ++j) {
+        burst->particles[j].position = position;
+        burst->particles[j].velocity = Vector2Scale((Vector2) {directionX[j], directionY[j]}, PARTICLE_SPEED);
+    }
+    particles->activeBursts[particles->activeBurstCount++] = poolIndex;
 }
 
+// finished bursts are taken out by HandleParticleBurstDone
 void UpdateParticles(float deltaTime) {
-    for (int i = 0; i < MAX_PARTICLE_BURSTS; ++i) {
-        ParticleBurstInstance *burst = &sParticleBursts[i];
-
-        // invalid burst
-        if (burst->elapsedTime == -1) {
-            continue;
-        }
+    ParticleWorld *particles = &gWorld->particles;
+    for (int i = 0; i < particles->activeBurstCount; ++i) {
+        ParticleBurstInstance *burst = GetPoolElement(&particles->burstPool, particles->activeBursts[i]);
 
-        burst->elapsedTime += deltaTime;
-        float percentComplete = burst->elapsedTime / BURST_DURATION;
+        float percentComplete = GetTimerProgress(burst->startTick, SECONDS_TO_TICKS(BURST_DURATION));
         burst->color.a = Lerp(255.0f, 0.0f, percentComplete);
 
         for (int j = 0; j < burst->particleCount; ++j) {
@@ -59,29 +81,24 @@ void UpdateParticles(float deltaTime) {
             Vector2 frameVelocity = Vector2Scale(particle->velocity, deltaTime);
             particle->position = Vector2Add(particle->position, frameVelocity);
         }
-
-        if (percentComplete >= 1) {
-            burst->elapsedTime = -1;
-        }
     }
 }
 
 void RenderParticles() {
+    ParticleWorld *particles = &gWorld->particles;
     Vector2 particleSize = {
         .x = PARTICLE_SIZE,
         .y = PARTICLE_SIZE,
     };
-    for (int i = 0; i < MAX_PARTICLE_BURSTS; ++i) {
-        ParticleBurstInstance *burst = &sParticleBursts[i];
-
-        // invalid burst
-        if (burst->elapsedTime == -1) {
-            continue;
-        }
+    for (int i = 0; i < particles->activeBurstCount; ++i) {
+        ParticleBurstInstance *burst = GetPoolElement(&particles->burstPool, particles->activeBursts[i]);
 
         for (int j = 0; j < burst->particleCount; ++j) {
             ParticleInstance *particle = &burst->particles[j];
-            DrawRectangleV(particle->position, particleSize, burst->color);
+            if (!IsCircleInView(particle->position, PARTICLE_SIZE)) {
+                continue;
+            }
+            RecordRectangle(RENDER_LAYER_BACKGROUND, particle->position, particleSize, burst->color);
         }
     }
 }
\ No newline at end of file
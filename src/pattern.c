@@ -0,0 +1,353 @@
+#include <raylib.h>
+#include <raymath.h>
+#include <stdio.h>
+#include <string.h>
+#include "pattern.h"
+#include "bullet.h"
+#include "game.h"
+#include "player.h"
+#include "objective.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "log.h"
+#include "field.h"
+#include "world.h"
+
+#define MAX_PATTERN_LINE_LENGTH 128
+
+// an emitter that kicks in once the player has collected enough objectives
+typedef struct BossStage {
+    int requiredObjectives;
+    PatternId pattern;
+    Vector2 position;
+} BossStage;
+
+static const char *sPatternSources[PATTERN_COUNT] = {
+    [PATTERN_SPIRAL] =
+        "color 255 120 200\n"
+        "repeat 0\n"
+        "  ring 3 140\n"
+        "  rotate 13\n"
+        "  wait 0.06\n"
+        "end\n",
+    [PATTERN_RING_BURST] =
+        "color 120 200 255\n"
+        "size 8\n"
+        "repeat 0\n"
+        "  ring 24 110\n"
+        "  wait 0.4\n"
+        "  rotate 7.5\n"
+        "  ring 24 160\n"
+        "  wait 1.2\n"
+        "end\n",
+    [PATTERN_AIMED_FAN] =
+        "color 255 200 80\n"
+        "repeat 0\n"
+        "  repeat 5\n"
+        "    aimed 5 40 220\n"
+        "    wait 0.08\n"
+        "  end\n"
+        "  wait 1.5\n"
+        "end\n",
+    [PATTERN_FLOWER] =
+        "color 160 255 160\n"
+        "size 5\n"
+        "repeat 0\n"
+        "  repeat 12\n"
+        "    ring 8 90\n"
+        "    rotate 4\n"
+        "    wait 0.1\n"
+        "  end\n"
+        "  repeat 12\n"
+        "    ring 8 90\n"
+        "    rotate -4\n"
+        "    wait 0.1\n"
+        "  end\n"
+        "end\n",
+};
+
+static const char *sPatternNames[PATTERN_COUNT] = {
+    [PATTERN_SPIRAL] = "spiral",
+    [PATTERN_RING_BURST] = "ring burst",
+    [PATTERN_AIMED_FAN] = "aimed fan",
+    [PATTERN_FLOWER] = "flower",
+};
+
+static const BossStage sBossStages[] = {
+    {.requiredObjectives = 6, .pattern = PATTERN_SPIRAL, .position = {GAME_WIDTH / 2.0f, GAME_HEIGHT / 2.0f}},
+    {.requiredObjectives = 15, .pattern = PATTERN_AIMED_FAN, .position = {GAME_WIDTH / 2.0f, 40}},
+    {.requiredObjectives = 24, .pattern = PATTERN_RING_BURST, .position = {40, 40}},
+    {.requiredObjectives = 36, .pattern = PATTERN_FLOWER, .position = {GAME_WIDTH - 40, GAME_HEIGHT - 40}},
+};
+
+// compiled once up front, then only ever read so every thread can share them
+static PatternProgram sPatterns[PATTERN_COUNT];
+
+static bool ReportPatternError(const char *name, int lineNumber, const char *message, const char *line) {
+    printf("pattern %s line %d: %s \"%s\"\n", name, lineNumber, message, line);
+    return false;
+}
+
+bool CompilePattern(const char *name, const char *source, PatternProgram *program) {
+    int openRepeats[MAX_PATTERN_LOOP_DEPTH];
+    int openRepeatCount = 0;
+    int lineNumber = 0;
+
+    program->name = name;
+    program->instructionCount = 0;
+
+    while (*source != '\0') {
+        // copy out the next line so sscanf doesn't run into the one after it
+        char line[MAX_PATTERN_LINE_LENGTH];
+        size_t length = strcspn(source, "\n");
+        lineNumber++;
+
+        if (length >= sizeof(line)) {
+            return ReportPatternError(name, lineNumber, "line too long", "");
+        }
+        memcpy(line, source, length);
+        line[length] = '\0';
+        source += length;
+        if (*source == '\n') {
+            source++;
+        }
+
+        // skip blank lines + comments
+        char command[16];
+        if (sscanf(line, "%15s", command) != 1 || command[0] == '#') {
+            continue;
+        }
+
+        // leave room for the HALT we append at the end
+        if (program->instructionCount >= MAX_PATTERN_INSTRUCTIONS - 1) {
+            return ReportPatternError(name, lineNumber, "too many instructions at", line);
+        }
+
+        PatternInstruction *instruction = &program->instructions[program->instructionCount];
+        memset(instruction, 0, sizeof(*instruction));
+
+        int count = 0;
+        int red = 0;
+        int green = 0;
+        int blue = 0;
+        bool isValid = false;
+
+        if (strcmp(command, "ring") == 0) {
+            instruction->op = PATTERN_OP_RING;
+            isValid = sscanf(line, "%*s %d %f", &count, &instruction->shot.speed) == 2 && count > 0;
+        }
+        else if (strcmp(command, "aimed") == 0) {
+            instruction->op = PATTERN_OP_AIMED;
+            isValid = sscanf(line, "%*s %d %f %f", &count, &instruction->shot.spread, &instruction->shot.speed) == 3 && count > 0;
+        }
+        else if (strcmp(command, "rotate") == 0) {
+            instruction->op = PATTERN_OP_ROTATE;
+            isValid = sscanf(line, "%*s %f", &instruction->degrees) == 1;
+        }
+        else if (strcmp(command, "wait") == 0) {
+            instruction->op = PATTERN_OP_WAIT;
+            isValid = sscanf(line, "%*s %f", &instruction->seconds) == 1 && instruction->seconds >= 0;
+        }
+        else if (strcmp(command, "size") == 0) {
+            instruction->op = PATTERN_OP_SIZE;
+            isValid = sscanf(line, "%*s %f", &instruction->size) == 1 && instruction->size > 0;
+        }
+        else if (strcmp(command, "color") == 0) {
+            instruction->op = PATTERN_OP_COLOR;
+            isValid = sscanf(line, "%*s %d %d %d", &red, &green, &blue) == 3;
+            instruction->color = (Color) {
+                (unsigned char) Clamp((float) red, 0, 255),
+                (unsigned char) Clamp((float) green, 0, 255),
+                (unsigned char) Clamp((float) blue, 0, 255),
+                255,
+            };
+        }
+        else if (strcmp(command, "repeat") == 0) {
+            instruction->op = PATTERN_OP_REPEAT;
+            isValid = sscanf(line, "%*s %d", &count) == 1 && count >= 0;
+            if (isValid) {
+                if (openRepeatCount == MAX_PATTERN_LOOP_DEPTH) {
+                    return ReportPatternError(name, lineNumber, "repeats nested too deep at", line);
+                }
+                openRepeats[openRepeatCount++] = program->instructionCount;
+            }
+        }
+        else if (strcmp(command, "end") == 0) {
+            instruction->op = PATTERN_OP_END;
+            if (openRepeatCount == 0) {
+                return ReportPatternError(name, lineNumber, "end without repeat at", line);
+            }
+            instruction->repeatStart = openRepeats[--openRepeatCount] + 1;
+            isValid = true;
+        }
+
+        if (!isValid || count > 0xFFFF) {
+            return ReportPatternError(name, lineNumber, "can't parse", line);
+        }
+
+        instruction->count = (unsigned short) count;
+        program->instructionCount++;
+    }
+
+    if (openRepeatCount != 0) {
+        return ReportPatternError(name, lineNumber, "missing end for repeat", "");
+    }
+
+    PatternInstruction *halt = &program->instructions[program->instructionCount++];
+    memset(halt, 0, sizeof(*halt));
+    halt->op = PATTERN_OP_HALT;
+    return true;
+}
+
+void LoadPatterns() {
+    for (int i = 0; i < PATTERN_COUNT; ++i) {
+        if (!CompilePattern(sPatternNames[i], sPatternSources[i], &sPatterns[i])) {
+            // a broken pattern just does nothing
+            sPatterns[i].instructionCount = 1;
+            sPatterns[i].instructions[0].op = PATTERN_OP_HALT;
+        }
+    }
+}
+
+void InitPatterns() {
+    PatternWorld *patterns = &gWorld->patterns;
+    for (int i = 0; i < MAX_EMITTERS; ++i) {
+        patterns->emitters[i].isActive = false;
+    }
+    patterns->nextBossStage = 0;
+
+    REGISTER_SNAPSHOT_VARIABLE(patterns->emitters);
+    REGISTER_SNAPSHOT_VARIABLE(patterns->nextBossStage);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_PATTERNS, patterns->emitters);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_PATTERNS, sPatterns);
+}
+
+int StartEmitter(PatternId pattern, Vector2 position) {
+    PatternWorld *patterns = &gWorld->patterns;
+    for (int i = 0; i < MAX_EMITTERS; ++i) {
+        Emitter *emitter = &patterns->emitters[i];
+        if (emitter->isActive) {
+            continue;
+        }
+
+        // clear padding too, snapshots of the world get hashed byte for byte
+        memset(emitter, 0, sizeof(*emitter));
+        emitter->isActive = true;
+        emitter->pattern = pattern;
+        emitter->position = position;
+        emitter->color = WHITE;
+        emitter->bulletSize = BULLET_SIZE;
+        return i;
+    }
+
+    LogMessage("ran out of emitters!");
+    return -1;
+}
+
+void StopEmitter(int emitter) {
+    PatternWorld *patterns = &gWorld->patterns;
+    if (emitter >= 0 && emitter < MAX_EMITTERS) {
+        patterns->emitters[emitter].isActive = false;
+    }
+}
+
+// fires count bullets starting at angle, spaced step degrees apart
+static void FireBullets(Emitter *emitter, int count, float angle, float step, float speed, float lateness) {
+    int firstIndex;
+    int granted = ReserveBullets(count, &firstIndex);
+
+    if (granted < count) {
+        LogMessage("ran out of bullets!");
+    }
+
+    for (int i = 0; i < granted; ++i) {
+        SimScalar degrees = SIM_FROM_FLOAT(angle + step * (float) i);
+        SimVector2 direction = {SimCosDegrees(degrees), SimSinDegrees(degrees)};
+        Vector2 velocity = SimVector2ToVector2(SimVector2Scale(direction, SIM_FROM_FLOAT(speed)));
+
+        // a shot that was due partway through the tick has already been flying for a bit
+        Vector2 position = Vector2Add(emitter->position, Vector2Scale(velocity, lateness));
+        SetBullet(firstIndex + i, position, velocity, emitter->bulletSize, emitter->color);
+    }
+}
+
+static void RunEmitter(Emitter *emitter, float deltaTime) {
+    const PatternProgram *program = &sPatterns[emitter->pattern];
+    emitter->waitTime -= deltaTime;
+
+    for (int steps = 0; steps < MAX_PATTERN_STEPS_PER_TICK && emitter->waitTime <= 0; ++steps) {
+        // how long ago, within this tick, the current instruction should have run
+        float lateness = -emitter->waitTime;
+        const PatternInstruction *instruction = &program->instructions[emitter->programCounter++];
+
+        switch (instruction->op) {
+            case PATTERN_OP_HALT: {
+                emitter->isActive = false;
+                return;
+            }
+            case PATTERN_OP_RING: {
+                float step = 360.0f / (float) instruction->count;
+                FireBullets(emitter, instruction->count, emitter->angle, step, instruction->shot.speed, lateness);
+                break;
+            }
+            case PATTERN_OP_AIMED: {
+                Vector2 toPlayer = Vector2Subtract(GetNearestPlayerPosition(emitter->position), emitter->position);
+                float aimAngle = SIM_TO_FLOAT(SimAtan2Degrees(SIM_FROM_FLOAT(toPlayer.y), SIM_FROM_FLOAT(toPlayer.x)));
+                float spread = instruction->count > 1 ? instruction->shot.spread : 0;
+                float step = instruction->count > 1 ? spread / (float) (instruction->count - 1) : 0;
+                FireBullets(emitter, instruction->count, aimAngle - spread * 0.5f, step, instruction->shot.speed, lateness);
+                break;
+            }
+            case PATTERN_OP_ROTATE: {
+                emitter->angle = fmodf(emitter->angle + instruction->degrees, 360.0f);
+                break;
+            }
+            case PATTERN_OP_WAIT: {
+                emitter->waitTime += instruction->seconds;
+                break;
+            }
+            case PATTERN_OP_REPEAT: {
+                emitter->loopsRemaining[emitter->loopDepth++] = instruction->count == 0 ? -1 : instruction->count;
+                break;
+            }
+            case PATTERN_OP_END: {
+                int *remaining = &emitter->loopsRemaining[emitter->loopDepth - 1];
+                if (*remaining == -1 || --(*remaining) > 0) {
+                    emitter->programCounter = instruction->repeatStart;
+                }
+                else {
+                    emitter->loopDepth--;
+                }
+                break;
+            }
+            case PATTERN_OP_COLOR: {
+                emitter->color = instruction->color;
+                break;
+            }
+            case PATTERN_OP_SIZE: {
+                emitter->bulletSize = instruction->size;
+                break;
+            }
+        }
+    }
+}
+
+void UpdatePatterns(float deltaTime) {
+    PatternWorld *patterns = &gWorld->patterns;
+    // bring in the next boss stage once the player has earned it
+    int stageCount = sizeof(sBossStages) / sizeof(sBossStages[0]);
+
+    while (patterns->nextBossStage < stageCount && gWorld->objectives.collectedCount >= sBossStages[patterns->nextBossStage].requiredObjectives) {
+        // stage positions are laid out on the screen the match starts looking at
+        const BossStage *stage = &sBossStages[patterns->nextBossStage];
+        Rectangle homeView = GetViewAround(GetFieldCenter());
+        StartEmitter(stage->pattern, Vector2Add(stage->position, (Vector2) {homeView.x, homeView.y}));
+        patterns->nextBossStage++;
+    }
+
+    for (int i = 0; i < MAX_EMITTERS; ++i) {
+        if (patterns->emitters[i].isActive) {
+            RunEmitter(&patterns->emitters[i], deltaTime);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "platform.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+double GetMonotonicTime() {
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+}
+
+void SleepSeconds(double seconds) {
+    // raylib already asks for 1ms timer resolution, so this is about as good as it gets
+    Sleep((DWORD) (seconds * 1000));
+}
+
+static DWORD WINAPI RunThread(LPVOID parameter) {
+    Thread *thread = parameter;
+    thread->function(thread->userData);
+    return 0;
+}
+
+bool StartThread(Thread *thread, ThreadFunction function, void *userData) {
+    thread->function = function;
+    thread->userData = userData;
+    thread->handle = CreateThread(NULL, 0, RunThread, thread, 0, NULL);
+    return thread->handle != NULL;
+}
+
+void JoinThread(Thread *thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+int GetProcessorCount() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int) info.dwNumberOfProcessors;
+}
+
+#else
+#include <time.h>
+#include <unistd.h>
+
+double GetMonotonicTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+void SleepSeconds(double seconds) {
+    struct timespec duration = {
+        .tv_sec = (time_t) seconds,
+        .tv_nsec = (long) ((seconds - (double) (time_t) seconds) * 1e9),
+    };
+    nanosleep(&duration, NULL);
+}
+
+static void *RunThread(void *parameter) {
+    Thread *thread = parameter;
+    thread->function(thread->userData);
+    return NULL;
+}
+
+bool StartThread(Thread *thread, ThreadFunction function, void *userData) {
+    thread->function = function;
+    thread->userData = userData;
+    return pthread_create(&thread->handle, NULL, RunThread, thread) == 0;
+}
+
+void JoinThread(Thread *thread) {
+    pthread_join(thread->handle, NULL);
+}
+
+int GetProcessorCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int) count : 1;
+}
+
+#endif
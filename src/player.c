@@ -2,88 +2,135 @@
 #include <raymath.h>
 #include "player.h"
 #include "game.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "render_list.h"
+#include "fixed_math.h"
+#include "field.h"
+#include "world.h"
 
-Vector2 gPlayerPosition;
+static const Color sPlayerColors[MAX_PLAYERS] = {
+    {255, 255, 255, 255},
+    {102, 191, 255, 255},
+};
 
-static Vector2 sPlayerVelocity;
-static Vector2 sPlayerSize;
-
-static Vector2 GetPlayerTopLeftCorner() {
-    Vector2 topLeft = gPlayerPosition;
-    topLeft.x -= 0.5f * sPlayerSize.x;
-    topLeft.y -= 0.5f * sPlayerSize.y;
+static Vector2 GetPlayerTopLeftCorner(const PlayerInstance *player) {
+    Vector2 topLeft = SimVector2ToVector2(player->position);
+    Vector2 size = SimVector2ToVector2(player->size);
+    topLeft.x -= 0.5f * size.x;
+    topLeft.y -= 0.5f * size.y;
     return topLeft;
 }
 
-void InitPlayer() {
-    gPlayerPosition.x = GAME_WIDTH / 2.0f;
-    gPlayerPosition.y = (GAME_HEIGHT / 2.0f) + 100;
+static void UpdatePlayerSize(PlayerInstance *player) {
+    // animate size based on speed
+    player->size.y = SimLerp(
+        SIM_FROM_FLOAT(PLAYER_WIDTH),
+        SIM_FROM_FLOAT(PLAYER_WIDTH * PLAYER_SQUISH_AMOUNT),
+        SimDivide(SimAbs(player->velocity.x), SIM_FROM_FLOAT(PLAYER_SPEED))
+    );
+    player->size.x = SimLerp(
+        SIM_FROM_FLOAT(PLAYER_HEIGHT),
+        SIM_FROM_FLOAT(PLAYER_HEIGHT * PLAYER_SQUISH_AMOUNT),
+        SimDivide(SimAbs(player->velocity.y), SIM_FROM_FLOAT(PLAYER_SPEED))
+    );
+}
+
+void SetPlayerCount(int count) {
+    PlayerWorld *players = &gWorld->players;
+    players->count = (int) Clamp((float) count, 1, MAX_PLAYERS);
 }
 
-void RenderPlayer() {
-    DrawRectangleV(GetPlayerTopLeftCorner(), sPlayerSize, WHITE);
+void InitPlayers() {
+    PlayerWorld *players = &gWorld->players;
+    // spread everyone out in a row, centered where a solo player starts
+    Vector2 fieldCenter = GetFieldCenter();
+    float rowStart = fieldCenter.x - (players->count - 1) * PLAYER_SPAWN_SPACING * 0.5f;
+
+    for (int i = 0; i < players->count; ++i) {
+        PlayerInstance *player = &players->instances[i];
+        player->position.x = SIM_FROM_FLOAT(rowStart + i * PLAYER_SPAWN_SPACING);
+        player->position.y = SIM_FROM_FLOAT(fieldCenter.y + 100);
+        player->velocity = SimVector2Zero();
+        UpdatePlayerSize(player);
+    }
+
+    REGISTER_SNAPSHOT_ARRAY(players->instances, players->count);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_PLAYERS, players->instances, players->count);
+}
+
+void RenderPlayers() {
+    for (int i = 0; i < gWorld->players.count; ++i) {
+        RecordRectangle(RENDER_LAYER_PLAYERS, GetPlayerTopLeftCorner(&gWorld->players.instances[i]), SimVector2ToVector2(gWorld->players.instances[i].size), sPlayerColors[i]);
+    }
 }
 
-Rectangle GetPlayerRect() {
-    Vector2 topLeft = GetPlayerTopLeftCorner();
+Vector2 GetPlayerPosition(int player) {
+    return SimVector2ToVector2(gWorld->players.instances[player].position);
+}
+
+Rectangle GetPlayerRect(int player) {
+    Vector2 topLeft = GetPlayerTopLeftCorner(&gWorld->players.instances[player]);
+    Vector2 size = SimVector2ToVector2(gWorld->players.instances[player].size);
     Rectangle playerRect = {
         .x = topLeft.x,
         .y = topLeft.y,
-        .width = sPlayerSize.x,
-        .height = sPlayerSize.y,
+        .width = size.x,
+        .height = size.y,
     };
     return playerRect;
 }
 
-void UpdatePlayer(float deltaTime) {
-    Vector2 inputDirection = Vector2Zero();
+Vector2 GetNearestPlayerPosition(Vector2 position) {
+    Vector2 nearest = GetPlayerPosition(0);
 
-    if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) {
-        inputDirection.y -= 1;
-    }
-    if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) {
-        inputDirection.y += 1;
+    for (int i = 1; i < gWorld->players.count; ++i) {
+        Vector2 playerPosition = GetPlayerPosition(i);
+        if (Vector2DistanceSqr(position, playerPosition) < Vector2DistanceSqr(position, nearest)) {
+            nearest = playerPosition;
+        }
     }
-    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) {
-        inputDirection.x -= 1;
-    }
-    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) {
-        inputDirection.x += 1;
+    return nearest;
+}
+
+int FindPlayerTouchingCircle(Vector2 center, float radius) {
+    PlayerWorld *players = &gWorld->players;
+    for (int i = 0; i < players->count; ++i) {
+        if (CheckCollisionCircleRec(center, radius, GetPlayerRect(i))) {
+            return i;
+        }
     }
+    return -1;
+}
 
-    inputDirection = Vector2Normalize(inputDirection);
+void UpdatePlayer(int playerIndex, PlayerInput input, float deltaTime) {
+    PlayerWorld *players = &gWorld->players;
+    PlayerInstance *player = &players->instances[playerIndex];
+    Vector2 inputDirection = GetInputDirection(input);
     bool isAccelerating = (inputDirection.x != 0) || (inputDirection.y != 0);
 
     if (isAccelerating) {
-        Vector2 targetVelocity = Vector2Scale(inputDirection, PLAYER_SPEED);
-        sPlayerVelocity = Vector2MoveTowards(sPlayerVelocity, targetVelocity, PLAYER_ACCELERATION * deltaTime);
+        SimVector2 targetVelocity = SimVector2Scale(SimVector2FromVector2(inputDirection), SIM_FROM_FLOAT(PLAYER_SPEED));
+        player->velocity = SimVector2MoveTowards(player->velocity, targetVelocity, SIM_FROM_FLOAT(PLAYER_ACCELERATION * deltaTime));
     }
     else { // is decelerating
-        sPlayerVelocity = Vector2Lerp(sPlayerVelocity, Vector2Zero(), PLAYER_DECELERATION * deltaTime);
+        player->velocity = SimVector2Lerp(player->velocity, SimVector2Zero(), SIM_FROM_FLOAT(PLAYER_DECELERATION * deltaTime));
     }
 
-    gPlayerPosition = Vector2Add(gPlayerPosition, Vector2Scale(sPlayerVelocity, deltaTime));
+    player->position = SimVector2Add(player->position, SimVector2Scale(player->velocity, SIM_FROM_FLOAT(deltaTime)));
 
-    gPlayerPosition.x = Clamp(
-        gPlayerPosition.x, 
-        PLAYER_WIDTH * 0.5f, 
-        GAME_WIDTH - PLAYER_WIDTH * 0.5f
-    );
-    gPlayerPosition.y = Clamp(
-        gPlayerPosition.y, 
-        PLAYER_HEIGHT * 0.5f, 
-        GAME_HEIGHT - PLAYER_HEIGHT * 0.5f
-    );
+    Vector2 fieldSize = GetFieldSize();
 
-    // animate size based on speed
-    sPlayerSize.y = Lerp(
-        PLAYER_WIDTH,
-        PLAYER_WIDTH * PLAYER_SQUISH_AMOUNT,
-        fabsf(sPlayerVelocity.x) / PLAYER_SPEED
+    player->position.x = SimClamp(
+        player->position.x, 
+        SIM_FROM_FLOAT(PLAYER_WIDTH * 0.5f), 
+        SIM_FROM_FLOAT(fieldSize.x - PLAYER_WIDTH * 0.5f)
     );
-    sPlayerSize.x = Lerp(
-        PLAYER_HEIGHT,
-        PLAYER_HEIGHT * PLAYER_SQUISH_AMOUNT,
-        fabsf(sPlayerVelocity.y) / PLAYER_SPEED
+    player->position.y = SimClamp(
+        player->position.y, 
+        SIM_FROM_FLOAT(PLAYER_HEIGHT * 0.5f), 
+        SIM_FROM_FLOAT(fieldSize.y - PLAYER_HEIGHT * 0.5f)
     );
+
+    UpdatePlayerSize(player);
 }
@@ -0,0 +1,334 @@
+#include <raylib.h>
+#include <stdio.h>
+#include <string.h>
+#include "render_list.h"
+#include "game.h"
+#include "bot.h"
+#include "ball.h"
+#include "arena.h"
+#include "sound.h"
+#include "math_util.h"
+#include "platform.h"
+
+// every layer + blend + draw mode combination gets its own bucket, in the order they're drawn
+#define RENDER_BUCKET_COUNT (RENDER_LAYER_COUNT * RENDER_BLEND_COUNT * RENDER_DRAW_MODE_COUNT)
+#define INTERLEAVED_BENCHMARK_SPARKS 256
+
+// raylib is built with SUPPORT_QUADS_DRAW_MODE (its default), so the filled shapes all go out as
+// textured quads. DrawLineEx is the odd one out, it draws a triangle strip
+static const RenderDrawMode sPrimitiveDrawModes[RENDER_PRIMITIVE_COUNT] = {
+    [RENDER_PRIMITIVE_TRIANGLE] = RENDER_DRAW_MODE_QUADS,
+    [RENDER_PRIMITIVE_RECTANGLE] = RENDER_DRAW_MODE_QUADS,
+    [RENDER_PRIMITIVE_CIRCLE] = RENDER_DRAW_MODE_QUADS,
+    [RENDER_PRIMITIVE_RING] = RENDER_DRAW_MODE_QUADS,
+    [RENDER_PRIMITIVE_LINE] = RENDER_DRAW_MODE_TRIANGLES,
+    [RENDER_PRIMITIVE_POLY] = RENDER_DRAW_MODE_QUADS,
+};
+
+static RenderCommand sCommands[MAX_RENDER_COMMANDS];
+static RenderCommand sSortedCommands[MAX_RENDER_COMMANDS];
+static int sCommandCount;
+static int sBucketCounts[RENDER_BUCKET_COUNT];
+static RenderBlend sCurrentBlend;
+static int sLastDrawState = -1;
+static RenderListStats sRecordingStats;
+static RenderListStats sLastStats;
+
+static unsigned int sRecordingChecksum = 2166136261u;
+
+// layers don't exist as far as the gpu is concerned, only these two end a draw call
+static int GetDrawState(RenderBlend blend, RenderDrawMode drawMode) {
+    return (int) blend * RENDER_DRAW_MODE_COUNT + (int) drawMode;
+}
+
+static int GetBucket(RenderLayer layer, RenderBlend blend, RenderPrimitive primitive) {
+    return (int) layer * RENDER_BLEND_COUNT * RENDER_DRAW_MODE_COUNT + GetDrawState(blend, sPrimitiveDrawModes[primitive]);
+}
+
+void SetRenderBlend(RenderBlend blend) {
+    sCurrentBlend = blend;
+}
+
+static RenderCommand *AddCommand(RenderLayer layer, RenderPrimitive primitive, Color color) {
+    if (sCommandCount == MAX_RENDER_COMMANDS) {
+        sRecordingStats.droppedCount++;
+        return NULL;
+    }
+
+    // immediate mode would have needed a new draw call every time the state changed
+    int drawState = GetDrawState(sCurrentBlend, sPrimitiveDrawModes[primitive]);
+    if (drawState != sLastDrawState) {
+        sRecordingStats.unsortedBatchCount++;
+        sLastDrawState = drawState;
+    }
+    sBucketCounts[GetBucket(layer, sCurrentBlend, primitive)]++;
+
+    // zeroed so the padding is the same every time, the recording backend checksums the raw bytes
+    RenderCommand *command = &sCommands[sCommandCount++];
+    memset(command, 0, sizeof(*command));
+    command->layer = (unsigned char) layer;
+    command->blend = (unsigned char) sCurrentBlend;
+    command->primitive = (unsigned char) primitive;
+    command->color = color;
+    return command;
+}
+
+void RecordTriangle(RenderLayer layer, Vector2 a, Vector2 b, Vector2 c, Color color) {
+    RenderCommand *command = AddCommand(layer, RENDER_PRIMITIVE_TRIANGLE, color);
+    if (command != NULL) {
+        command->triangle.a = a;
+        command->triangle.b = b;
+        command->triangle.c = c;
+    }
+}
+
+void RecordRectangle(RenderLayer layer, Vector2 position, Vector2 size, Color color) {
+    RenderCommand *command = AddCommand(layer, RENDER_PRIMITIVE_RECTANGLE, color);
+    if (command != NULL) {
+        command->rectangle.position = position;
+        command->rectangle.size = size;
+    }
+}
+
+void RecordCircle(RenderLayer layer, Vector2 center, float radius, Color color) {
+    RenderCommand *command = AddCommand(layer, RENDER_PRIMITIVE_CIRCLE, color);
+    if (command != NULL) {
+        command->circle.center = center;
+        command->circle.radius = radius;
+    }
+}
+
+void RecordRing(RenderLayer layer, Vector2 center, float innerRadius, float outerRadius, Color color) {
+    RenderCommand *command = AddCommand(layer, RENDER_PRIMITIVE_RING, color);
+    if (command != NULL) {
+        command->ring.center = center;
+        command->ring.innerRadius = innerRadius;
+        command->ring.outerRadius = outerRadius;
+    }
+}
+
+void RecordLine(RenderLayer layer, Vector2 start, Vector2 end, float thickness, Color color) {
+    RenderCommand *command = AddCommand(layer, RENDER_PRIMITIVE_LINE, color);
+    if (command != NULL) {
+        command->line.start = start;
+        command->line.end = end;
+        command->line.thickness = thickness;
+    }
+}
+
+void RecordPoly(RenderLayer layer, Vector2 center, int sides, float radius, Color color) {
+    RenderCommand *command = AddCommand(layer, RENDER_PRIMITIVE_POLY, color);
+    if (command != NULL) {
+        command->poly.center = center;
+        command->poly.radius = radius;
+        command->poly.sides = sides;
+    }
+}
+
+void SubmitRenderList(const RenderBackend *backend) {
+    // there are only a handful of buckets, so a counting sort does it in two passes
+    // and keeps recorded order inside each bucket for free
+    int bucketStarts[RENDER_BUCKET_COUNT];
+    int start = 0;
+    for (int i = 0; i < RENDER_BUCKET_COUNT; ++i) {
+        bucketStarts[i] = start;
+        start += sBucketCounts[i];
+    }
+
+    int bucketEnds[RENDER_BUCKET_COUNT];
+    memcpy(bucketEnds, bucketStarts, sizeof(bucketEnds));
+    for (int i = 0; i < sCommandCount; ++i) {
+        const RenderCommand *command = &sCommands[i];
+        int bucket = GetBucket(command->layer, command->blend, command->primitive);
+        sSortedCommands[bucketEnds[bucket]++] = *command;
+    }
+
+    sRecordingStats.commandCount = sCommandCount;
+    int lastDrawState = -1;
+    for (int i = 0; i < RENDER_BUCKET_COUNT; ++i) {
+        if (sBucketCounts[i] == 0) {
+            continue;
+        }
+
+        RenderBatch batch = {
+            .layer = (RenderLayer) (i / (RENDER_BLEND_COUNT * RENDER_DRAW_MODE_COUNT)),
+            .blend = (RenderBlend) (i / RENDER_DRAW_MODE_COUNT % RENDER_BLEND_COUNT),
+            .drawMode = (RenderDrawMode) (i % RENDER_DRAW_MODE_COUNT),
+            .commands = &sSortedCommands[bucketStarts[i]],
+            .commandCount = sBucketCounts[i],
+        };
+        backend->SubmitBatch(&batch);
+
+        // the next layer picking up in the same state carries on with the same draw call
+        int drawState = GetDrawState(batch.blend, batch.drawMode);
+        if (drawState != lastDrawState) {
+            sRecordingStats.batchCount++;
+            lastDrawState = drawState;
+        }
+    }
+
+    sLastStats = sRecordingStats;
+    memset(&sRecordingStats, 0, sizeof(sRecordingStats));
+    memset(sBucketCounts, 0, sizeof(sBucketCounts));
+    sCommandCount = 0;
+    sCurrentBlend = RENDER_BLEND_ALPHA;
+    sLastDrawState = -1;
+}
+
+RenderListStats GetRenderListStats() {
+    return sLastStats;
+}
+
+static void SubmitRaylibBatch(const RenderBatch *batch) {
+    if (batch->blend == RENDER_BLEND_ADDITIVE) {
+        BeginBlendMode(BLEND_ADDITIVE);
+    }
+
+    // raylib keeps adding to its vertex buffer until the draw mode or texture changes,
+    // so the whole batch ends up as a single draw call whatever mix of primitives it has
+    for (int i = 0; i < batch->commandCount; ++i) {
+        const RenderCommand *command = &batch->commands[i];
+
+        switch ((RenderPrimitive) command->primitive) {
+            case RENDER_PRIMITIVE_TRIANGLE:
+                DrawTriangle(command->triangle.a, command->triangle.b, command->triangle.c, command->color);
+                break;
+            case RENDER_PRIMITIVE_RECTANGLE:
+                DrawRectangleV(command->rectangle.position, command->rectangle.size, command->color);
+                break;
+            case RENDER_PRIMITIVE_CIRCLE:
+                DrawCircleV(command->circle.center, command->circle.radius, command->color);
+                break;
+            case RENDER_PRIMITIVE_RING:
+                DrawRing(command->ring.center, command->ring.innerRadius, command->ring.outerRadius, 0, 360, 30, command->color);
+                break;
+            case RENDER_PRIMITIVE_LINE:
+                DrawLineEx(command->line.start, command->line.end, command->line.thickness, command->color);
+                break;
+            case RENDER_PRIMITIVE_POLY:
+                DrawPoly(command->poly.center, command->poly.sides, command->poly.radius, 0, command->color);
+                break;
+            case RENDER_PRIMITIVE_COUNT:
+                break;
+        }
+    }
+
+    if (batch->blend == RENDER_BLEND_ADDITIVE) {
+        EndBlendMode();
+    }
+}
+
+static void SubmitRecordingBatch(const RenderBatch *batch) {
+    // fnv-1a over the batch header + command bytes, any change in what or how much gets drawn changes it
+    const unsigned char *bytes = (const unsigned char *) batch->commands;
+    size_t size = (size_t) batch->commandCount * sizeof(RenderCommand);
+    unsigned int checksum = sRecordingChecksum;
+
+    checksum = (checksum ^ (unsigned int) (batch->layer << 16 | batch->blend << 8 | batch->drawMode)) * 16777619u;
+    for (size_t i = 0; i < size; ++i) {
+        checksum = (checksum ^ bytes[i]) * 16777619u;
+    }
+    sRecordingChecksum = checksum;
+}
+
+const RenderBackend gRaylibRenderBackend = {"raylib", SubmitRaylibBatch};
+const RenderBackend gRecordingRenderBackend = {"recording", SubmitRecordingBatch};
+
+unsigned int GetRecordingBackendChecksum() {
+    return sRecordingChecksum;
+}
+
+typedef struct RenderBenchmarkTotals {
+    long long commandCount;
+    long long batchCount;
+    long long unsortedBatchCount;
+    long long droppedCount;
+    int maxCommandCount;
+    double recordTime;
+    double submitTime;
+} RenderBenchmarkTotals;
+
+// sparks drawn the way an effect naturally records them: a body, a streak + an additive glow
+// each, so in recorded order every single command changes the draw mode or blend
+static void RecordInterleavedSparks() {
+    for (int i = 0; i < INTERLEAVED_BENCHMARK_SPARKS; ++i) {
+        Vector2 center = {(float) RandomInt(0, GAME_WIDTH), (float) RandomInt(0, GAME_HEIGHT)};
+        Vector2 direction = RandomPointOnUnitCircle();
+        Vector2 tail = {center.x - direction.x * 12, center.y - direction.y * 12};
+        Color color = RandomColor();
+
+        SetRenderBlend(RENDER_BLEND_ALPHA);
+        RecordCircle(RENDER_LAYER_HAZARDS, center, 3, color);
+        RecordLine(RENDER_LAYER_HAZARDS, tail, center, 2, color);
+        SetRenderBlend(RENDER_BLEND_ADDITIVE);
+        RecordRing(RENDER_LAYER_HAZARDS, center, 3, 8, color);
+    }
+    SetRenderBlend(RENDER_BLEND_ALPHA);
+}
+
+static void SubmitBenchmarkFrame(RenderBenchmarkTotals *totals, double startTime) {
+    double recordedTime = GetMonotonicTime();
+    SubmitRenderList(&gRecordingRenderBackend);
+    double submittedTime = GetMonotonicTime();
+
+    totals->recordTime += recordedTime - startTime;
+    totals->submitTime += submittedTime - recordedTime;
+
+    RenderListStats stats = GetRenderListStats();
+    totals->commandCount += stats.commandCount;
+    totals->batchCount += stats.batchCount;
+    totals->unsortedBatchCount += stats.unsortedBatchCount;
+    totals->droppedCount += stats.droppedCount;
+    if (stats.commandCount > totals->maxCommandCount) {
+        totals->maxCommandCount = stats.commandCount;
+    }
+}
+
+static void ReportBenchmarkTotals(const char *name, const RenderBenchmarkTotals *totals, int frameCount) {
+    printf("%s: %.0f commands per frame (%d at most), %lld dropped\n",
+           name, (double) totals->commandCount / frameCount, totals->maxCommandCount, totals->droppedCount);
+    printf("%s: %.1f batches per frame sorted, %.1f in recorded order\n",
+           name, (double) totals->batchCount / frameCount, (double) totals->unsortedBatchCount / frameCount);
+    printf("%s: record %.1f us + sort/submit %.1f us per frame\n",
+           name, totals->recordTime / frameCount * 1000000, totals->submitTime / frameCount * 1000000);
+}
+
+int RunRenderBenchmark(int frameCount) {
+    printf("render benchmark: %d frames of a %d ball bot match, then %d of %d interleaved sparks\n",
+           frameCount, CROWDED_BALL_COUNT, frameCount, INTERLEAVED_BENCHMARK_SPARKS);
+    SetSoundsMuted(true);
+    // same match every run, so the checksum only changes when what gets drawn does
+    SeedRandom(1);
+    InitBot();
+    SetStartingBallCount(CROWDED_BALL_COUNT);
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    RenderBenchmarkTotals matchTotals = {0};
+    for (int frame = 0; frame < frameCount; ++frame) {
+        ResetFrameArenas();
+        PlayerInput input = GetBotInput(0);
+        SimulateTick(&input);
+
+        // the bot doesn't need to survive, the world just needs to stay busy
+        if (GetGameState() == GAME_STATE_OVER) {
+            ChangeGameStateTo(GAME_STATE_PLAYING);
+        }
+
+        double startTime = GetMonotonicTime();
+        RecordGameWorld();
+        SubmitBenchmarkFrame(&matchTotals, startTime);
+    }
+
+    RenderBenchmarkTotals sparkTotals = {0};
+    for (int frame = 0; frame < frameCount; ++frame) {
+        double startTime = GetMonotonicTime();
+        RecordInterleavedSparks();
+        SubmitBenchmarkFrame(&sparkTotals, startTime);
+    }
+
+    ReportBenchmarkTotals("match", &matchTotals, frameCount);
+    ReportBenchmarkTotals("sparks", &sparkTotals, frameCount);
+    printf("checksum %08x\n", GetRecordingBackendChecksum());
+
+    return matchTotals.droppedCount + sparkTotals.droppedCount == 0 ? 0 : 1;
+}
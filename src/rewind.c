@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <string.h>
+#include "rewind.h"
+#include "snapshot.h"
+#include "metrics.h"
+#include "log.h"
+#include "memory_usage.h"
+
+// a keyframe, then a delta for each tick after it
+typedef struct RewindGroup {
+    int firstTick;
+    int tickCount;
+    size_t keyframeSize;
+    size_t usedSize;
+    size_t recordOffsets[REWIND_KEYFRAME_INTERVAL]; // the keyframe is always at 0
+} RewindGroup;
+
+static unsigned char sGroupMemory[REWIND_GROUP_COUNT][REWIND_GROUP_CAPACITY];
+static RewindGroup sGroups[REWIND_GROUP_COUNT];
+static int sOldestGroup;
+static int sGroupCount;
+
+// the newest recorded world in full, what the next delta gets compared against
+static unsigned char sWorlds[2][WORLD_SNAPSHOT_CAPACITY];
+static unsigned char *sPreviousWorld = sWorlds[0];
+static unsigned char *sScratchWorld = sWorlds[1];
+static size_t sPreviousWorldSize;
+static int sNextTick;
+
+static Metric sRewindBytesMetric;
+static Metric sRewindSecondsMetric;
+
+static RewindGroup *GetNewestGroup() {
+    return sGroupCount > 0 ? &sGroups[(sOldestGroup + sGroupCount - 1) % REWIND_GROUP_COUNT] : NULL;
+}
+
+static int GetGroupMemoryIndex(const RewindGroup *group) {
+    return (int) (group - sGroups);
+}
+
+static void UpdateRewindMetrics() {
+    size_t usedSize = 0;
+    for (int i = 0; i < sGroupCount; ++i) {
+        usedSize += sGroups[(sOldestGroup + i) % REWIND_GROUP_COUNT].usedSize;
+    }
+    SetGauge(&sRewindBytesMetric, (double) usedSize);
+    SetGauge(&sRewindSecondsMetric, sGroupCount > 0 ? (double) (sNextTick - GetOldestRewindTick()) / SIMULATION_TICK_RATE : 0);
+}
+
+static bool StartGroup(const unsigned char *world, size_t worldSize) {
+    if (worldSize > REWIND_GROUP_CAPACITY) {
+        return false;
+    }
+
+    if (sGroupCount == REWIND_GROUP_COUNT) {
+        sOldestGroup = (sOldestGroup + 1) % REWIND_GROUP_COUNT;
+        sGroupCount--;
+    }
+    sGroupCount++;
+
+    RewindGroup *group = GetNewestGroup();
+    memcpy(sGroupMemory[GetGroupMemoryIndex(group)], world, worldSize);
+    group->firstTick = sNextTick;
+    group->tickCount = 1;
+    group->keyframeSize = worldSize;
+    group->usedSize = worldSize;
+    group->recordOffsets[0] = 0;
+    return true;
+}
+
+void InitRewind() {
+    RegisterGauge(&sRewindBytesMetric, "pong_rewind_bytes", "Memory the rewind history is using.");
+    RegisterGauge(&sRewindSecondsMetric, "pong_rewind_history_seconds", "How far back the rewind history goes.");
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_REWIND, sGroupMemory);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_REWIND, sWorlds);
+    ResetRewind();
+}
+
+void ResetRewind() {
+    sOldestGroup = 0;
+    sGroupCount = 0;
+    sPreviousWorldSize = 0;
+    sNextTick = 0;
+    UpdateRewindMetrics();
+}
+
+void RecordRewindTick() {
+    size_t worldSize = SaveSnapshot(sScratchWorld, WORLD_SNAPSHOT_CAPACITY);
+    if (worldSize == 0) {
+        return;
+    }
+
+    RewindGroup *group = GetNewestGroup();
+    bool isRecorded = false;
+
+    if (group != NULL && group->tickCount < REWIND_KEYFRAME_INTERVAL) {
+        unsigned char *memory = sGroupMemory[GetGroupMemoryIndex(group)];
+        size_t deltaSize = EncodeSnapshotDelta(memory + group->usedSize, REWIND_GROUP_CAPACITY - group->usedSize,
+                                               sPreviousWorld, sPreviousWorldSize, sScratchWorld, worldSize);
+        if (deltaSize != 0) {
+            group->recordOffsets[group->tickCount++] = group->usedSize;
+            group->usedSize += deltaSize;
+            isRecorded = true;
+        }
+    }
+
+    if (!isRecorded && !StartGroup(sScratchWorld, worldSize)) {
+        LogMessage("a %zu byte world doesn't fit in a rewind group!", worldSize);
+        ResetRewind();
+        return;
+    }
+
+    unsigned char *previousWorld = sPreviousWorld;
+    sPreviousWorld = sScratchWorld;
+    sScratchWorld = previousWorld;
+    sPreviousWorldSize = worldSize;
+    sNextTick++;
+    UpdateRewindMetrics();
+}
+
+int GetOldestRewindTick() {
+    return sGroupCount > 0 ? sGroups[sOldestGroup].firstTick : -1;
+}
+
+int GetNewestRewindTick() {
+    return sGroupCount > 0 ? sNextTick - 1 : -1;
+}
+
+// rebuilds the world at tick in the scratch world, returns its size or 0 if it isn't recorded
+static size_t RebuildWorld(int tick) {
+    for (int i = 0; i < sGroupCount; ++i) {
+        const RewindGroup *group = &sGroups[(sOldestGroup + i) % REWIND_GROUP_COUNT];
+        if (tick < group->firstTick || tick >= group->firstTick + group->tickCount) {
+            continue;
+        }
+
+        const unsigned char *memory = sGroupMemory[GetGroupMemoryIndex(group)];
+        size_t worldSize = group->keyframeSize;
+        memcpy(sScratchWorld, memory, worldSize);
+
+        for (int j = 1; j <= tick - group->firstTick; ++j) {
+            size_t deltaSize = group->usedSize - group->recordOffsets[j];
+            worldSize = ApplySnapshotDelta(sScratchWorld, WORLD_SNAPSHOT_CAPACITY, memory + group->recordOffsets[j], deltaSize);
+        }
+        return worldSize;
+    }
+    return 0;
+}
+
+bool SeekRewind(int tick) {
+    size_t worldSize = RebuildWorld(tick);
+    return worldSize != 0 && LoadSnapshot(sScratchWorld, worldSize);
+}
+
+void TruncateRewind(int tick) {
+    size_t worldSize = RebuildWorld(tick);
+    if (worldSize == 0) {
+        return;
+    }
+
+    // the rebuilt world is what the next delta gets compared against
+    while (sGroupCount > 0 && GetNewestGroup()->firstTick > tick) {
+        sGroupCount--;
+    }
+    RewindGroup *group = GetNewestGroup();
+    int tickCount = tick - group->firstTick + 1;
+    if (tickCount < group->tickCount) {
+        group->usedSize = group->recordOffsets[tickCount];
+        group->tickCount = tickCount;
+    }
+
+    unsigned char *previousWorld = sPreviousWorld;
+    sPreviousWorld = sScratchWorld;
+    sScratchWorld = previousWorld;
+    sPreviousWorldSize = worldSize;
+    sNextTick = tick + 1;
+    UpdateRewindMetrics();
+}
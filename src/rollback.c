@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <string.h>
+#include "rollback.h"
+#include "game.h"
+#include "sound.h"
+#include "metrics.h"
+#include "math_util.h"
+#include "platform.h"
+#include "log.h"
+
+typedef enum PacketType {
+    PACKET_HELLO = 1,   // client -> host, until it hears back
+    PACKET_WELCOME = 2, // host -> client, carries the seed
+    PACKET_INPUT = 3,
+} PacketType;
+
+// little endian on the wire, whatever the machine is
+static unsigned char *WriteU8(unsigned char *cursor, unsigned int value) {
+    *cursor++ = (unsigned char) value;
+    return cursor;
+}
+
+static unsigned char *WriteU32(unsigned char *cursor, unsigned int value) {
+    for (int i = 0; i < 4; ++i) {
+        *cursor++ = (unsigned char) (value >> (8 * i));
+    }
+    return cursor;
+}
+
+static const unsigned char *ReadU32(const unsigned char *cursor, unsigned int *value) {
+    *value = 0;
+    for (int i = 0; i < 4; ++i) {
+        *value |= (unsigned int) cursor[i] << (8 * i);
+    }
+    return cursor + 4;
+}
+
+static PlayerInput GetInput(const RollbackSession *session, int player, int tick) {
+    return session->inputs[player][tick % ROLLBACK_INPUT_HISTORY];
+}
+
+static void SetInput(RollbackSession *session, int player, int tick, PlayerInput input) {
+    session->inputs[player][tick % ROLLBACK_INPUT_HISTORY] = input;
+}
+
+static void StartMatch(RollbackSession *session) {
+    session->isConnected = true;
+    SeedRandom(session->seed);
+    SetPlayerCount(MAX_PLAYERS);
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+}
+
+void InitRollbackSession(RollbackSession *session, NetLink *link, int localPlayer, unsigned int seed) {
+    session->link = link;
+    session->localPlayer = localPlayer;
+    session->remotePlayer = 1 - localPlayer;
+    session->seed = seed;
+    session->isConnected = false;
+
+    session->currentTick = 0;
+    memset(session->inputs, 0, sizeof(session->inputs));
+    // the first few ticks run before anyone's input could arrive, they're neutral for both
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        session->confirmedTicks[i] = ROLLBACK_INPUT_DELAY - 1;
+    }
+    session->firstMispredictedTick = -1;
+    session->remoteAckTick = -1;
+    session->remoteTick = 0;
+    session->remoteAdvantage = 0;
+    session->lastTimeSyncTick = 0;
+
+    for (int i = 0; i < ROLLBACK_SNAPSHOT_SLOTS; ++i) {
+        session->snapshotTicks[i] = -1;
+    }
+    for (int i = 0; i < ROLLBACK_INPUT_HISTORY; ++i) {
+        session->checksumTicks[i] = -1;
+    }
+    session->lastChecksumTick = -1;
+    session->desyncTick = -1;
+
+    session->rollbackCount = 0;
+    session->resimulatedTickCount = 0;
+    session->maxRollbackTicks = 0;
+    session->maxRollbackTime = 0;
+    session->totalRollbackTime = 0;
+    session->stallCount = 0;
+    session->timeSyncSkipCount = 0;
+    session->verifiedChecksumCount = 0;
+}
+
+static void SendHandshake(RollbackSession *session, PacketType type) {
+    unsigned char packet[16];
+    unsigned char *cursor = WriteU32(packet, ROLLBACK_PACKET_MAGIC);
+    cursor = WriteU8(cursor, type);
+    cursor = WriteU32(cursor, session->seed);
+    SendOverLink(session->link, packet, (int) (cursor - packet));
+}
+
+static void SendInputs(RollbackSession *session) {
+    int newestTick = session->confirmedTicks[session->localPlayer];
+    int firstTick = session->remoteAckTick + 1;
+
+    if (firstTick < newestTick - ROLLBACK_REDUNDANT_INPUTS + 1) {
+        firstTick = newestTick - ROLLBACK_REDUNDANT_INPUTS + 1;
+    }
+    if (firstTick < 0) {
+        firstTick = 0;
+    }
+
+    int checksumTick = session->lastChecksumTick;
+    unsigned int checksum = checksumTick >= 0 ? session->checksums[checksumTick % ROLLBACK_INPUT_HISTORY] : 0;
+    int localAdvantage = session->currentTick - session->remoteTick;
+
+    unsigned char packet[MAX_PACKET_SIZE];
+    unsigned char *cursor = WriteU32(packet, ROLLBACK_PACKET_MAGIC);
+    cursor = WriteU8(cursor, PACKET_INPUT);
+    cursor = WriteU32(cursor, (unsigned int) session->currentTick);
+    cursor = WriteU32(cursor, (unsigned int) localAdvantage);
+    cursor = WriteU32(cursor, (unsigned int) session->confirmedTicks[session->remotePlayer]);
+    cursor = WriteU32(cursor, (unsigned int) checksumTick);
+    cursor = WriteU32(cursor, checksum);
+    cursor = WriteU32(cursor, (unsigned int) firstTick);
+    cursor = WriteU8(cursor, newestTick - firstTick + 1);
+
+    for (int tick = firstTick; tick <= newestTick; ++tick) {
+        cursor = WriteU8(cursor, GetInput(session, session->localPlayer, tick));
+    }
+
+    SendOverLink(session->link, packet, (int) (cursor - packet));
+}
+
+static void CheckRemoteChecksum(RollbackSession *session, int tick, unsigned int checksum) {
+    if (tick < 0 || session->desyncTick != -1) {
+        return;
+    }
+
+    int slot = tick % ROLLBACK_INPUT_HISTORY;
+    if (session->checksumTicks[slot] != tick) {
+        return; // we haven't gotten there yet, or it's too old to compare
+    }
+
+    if (session->checksums[slot] == checksum) {
+        session->verifiedChecksumCount++;
+    }
+    else {
+        session->desyncTick = tick;
+        LogMessage("desync at tick %d!", tick);
+    }
+}
+
+static void ReceiveInputs(RollbackSession *session, const unsigned char *cursor, const unsigned char *end) {
+    unsigned int remoteTick, remoteAdvantage, ackTick, checksumTick, checksum, firstTick;
+
+    if (end - cursor < 25) {
+        return;
+    }
+    cursor = ReadU32(cursor, &remoteTick);
+    cursor = ReadU32(cursor, &remoteAdvantage);
+    cursor = ReadU32(cursor, &ackTick);
+    cursor = ReadU32(cursor, &checksumTick);
+    cursor = ReadU32(cursor, &checksum);
+    cursor = ReadU32(cursor, &firstTick);
+    int inputCount = *cursor++;
+
+    if (end - cursor < inputCount) {
+        return;
+    }
+
+    // packets can show up out of order, only ever move forward
+    if ((int) remoteTick > session->remoteTick) {
+        session->remoteTick = (int) remoteTick;
+        session->remoteAdvantage = (int) remoteAdvantage;
+    }
+    if ((int) ackTick > session->remoteAckTick) {
+        session->remoteAckTick = (int) ackTick;
+    }
+    CheckRemoteChecksum(session, (int) checksumTick, checksum);
+
+    int remote = session->remotePlayer;
+
+    for (int i = 0; i < inputCount; ++i) {
+        int tick = (int) firstTick + i;
+        PlayerInput input = cursor[i];
+
+        // we only take inputs in order, anything past a gap waits for a resend
+        if (tick != session->confirmedTicks[remote] + 1) {
+            continue;
+        }
+        if (tick >= session->currentTick + ROLLBACK_INPUT_HISTORY / 2) {
+            break;
+        }
+
+        // already simulated this tick with a guess, if the guess was wrong we need to go back
+        if (tick < session->currentTick && GetInput(session, remote, tick) != input) {
+            if (session->firstMispredictedTick == -1 || tick < session->firstMispredictedTick) {
+                session->firstMispredictedTick = tick;
+            }
+        }
+
+        SetInput(session, remote, tick, input);
+        session->confirmedTicks[remote] = tick;
+    }
+}
+
+static void ReceivePackets(RollbackSession *session) {
+    unsigned char packet[MAX_PACKET_SIZE];
+    int size;
+
+    while ((size = ReceiveFromLink(session->link, packet, sizeof(packet))) >= 0) {
+        unsigned int magic;
+        if (size < 5) {
+            continue;
+        }
+        const unsigned char *cursor = ReadU32(packet, &magic);
+        if (magic != ROLLBACK_PACKET_MAGIC) {
+            continue;
+        }
+
+        PacketType type = *cursor++;
+        const unsigned char *end = packet + size;
+
+        switch (type) {
+            case PACKET_HELLO:
+                // our welcome might have been lost, so answer every hello
+                if (session->localPlayer == 0) {
+                    SendHandshake(session, PACKET_WELCOME);
+                    if (!session->isConnected) {
+                        StartMatch(session);
+                    }
+                }
+                break;
+            case PACKET_WELCOME:
+                if (session->localPlayer != 0 && !session->isConnected && end - cursor >= 4) {
+                    ReadU32(cursor, &session->seed);
+                    StartMatch(session);
+                }
+                break;
+            case PACKET_INPUT:
+                if (session->isConnected) {
+                    ReceiveInputs(session, cursor, end);
+                }
+                break;
+        }
+    }
+}
+
+static void SaveTickSnapshot(RollbackSession *session, int tick) {
+    int slot = tick % ROLLBACK_SNAPSHOT_SLOTS;
+    session->snapshotSizes[slot] = SaveSnapshot(session->snapshots[slot], WORLD_SNAPSHOT_CAPACITY);
+    session->snapshotTicks[slot] = tick;
+}
+
+static void SimulateSessionTick(RollbackSession *session, int tick) {
+    // no input from the peer yet, guess they're still doing whatever they did last
+    int remote = session->remotePlayer;
+    if (tick > session->confirmedTicks[remote]) {
+        SetInput(session, remote, tick, GetInput(session, remote, session->confirmedTicks[remote]));
+    }
+
+    PlayerInput inputs[MAX_PLAYERS];
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        inputs[i] = GetInput(session, i, tick);
+    }
+
+    SaveTickSnapshot(session, tick);
+    SimulateTick(inputs);
+}
+
+static void RollBack(RollbackSession *session) {
+    int fromTick = session->firstMispredictedTick;
+    session->firstMispredictedTick = -1;
+
+    int slot = fromTick % ROLLBACK_SNAPSHOT_SLOTS;
+    if (session->snapshotTicks[slot] != fromTick) {
+        LogMessage("can't roll back to tick %d, snapshot is gone!", fromTick);
+        return;
+    }
+
+    double startTime = GetMonotonicTime();
+    // carrying on from the mispredicted world would only find out a few checksums later
+    if (!LoadSnapshot(session->snapshots[slot], session->snapshotSizes[slot])) {
+        if (session->desyncTick == -1) {
+            session->desyncTick = fromTick;
+        }
+        LogMessage("can't roll back to tick %d, snapshot didn't load!", fromTick);
+        return;
+    }
+
+    // replay up to where we were, nobody needs to hear the same bounce twice
+    SetSoundsMuted(true);
+    SetMetricsMuted(true);
+    for (int tick = fromTick; tick < session->currentTick; ++tick) {
+        SimulateSessionTick(session, tick);
+    }
+    SetSoundsMuted(false);
+    SetMetricsMuted(false);
+
+    double elapsedTime = GetMonotonicTime() - startTime;
+    int tickCount = session->currentTick - fromTick;
+    session->rollbackCount++;
+    session->resimulatedTickCount += tickCount;
+    session->totalRollbackTime += elapsedTime;
+    if (tickCount > session->maxRollbackTicks) {
+        session->maxRollbackTicks = tickCount;
+    }
+    if (elapsedTime > session->maxRollbackTime) {
+        session->maxRollbackTime = elapsedTime;
+    }
+}
+
+static void RecordChecksums(RollbackSession *session) {
+    // the state before tick t is final once every input before t is confirmed
+    int finalTick = session->confirmedTicks[0] < session->confirmedTicks[1] ? session->confirmedTicks[0] : session->confirmedTicks[1];
+    finalTick += 1;
+
+    for (int tick = session->lastChecksumTick + 1; tick <= finalTick && tick < session->currentTick; ++tick) {
+        int slot = tick % ROLLBACK_SNAPSHOT_SLOTS;
+        if (session->snapshotTicks[slot] != tick) {
+            break;
+        }
+        session->checksums[tick % ROLLBACK_INPUT_HISTORY] = HashSnapshot(session->snapshots[slot], session->snapshotSizes[slot]);
+        session->checksumTicks[tick % ROLLBACK_INPUT_HISTORY] = tick;
+        session->lastChecksumTick = tick;
+    }
+}
+
+void AdvanceRollbackSession(RollbackSession *session, PlayerInput localInput) {
+    ReceivePackets(session);
+
+    if (!session->isConnected) {
+        if (session->localPlayer != 0) {
+            SendHandshake(session, PACKET_HELLO);
+        }
+        return;
+    }
+
+    if (session->firstMispredictedTick != -1) {
+        RollBack(session);
+    }
+    RecordChecksums(session);
+
+    // too far ahead of what we've heard from the peer, wait for them to catch up
+    int remote = session->remotePlayer;
+    if (session->currentTick > session->confirmedTicks[remote] + ROLLBACK_MAX_TICKS) {
+        session->stallCount++;
+        SendInputs(session);
+        return;
+    }
+
+    // consistently ahead of the peer means they're rolling back more than us, ease off a tick
+    int localAdvantage = session->currentTick - session->remoteTick;
+    if (localAdvantage - session->remoteAdvantage > 2 * ROLLBACK_TIME_SYNC_THRESHOLD &&
+        session->currentTick - session->lastTimeSyncTick > ROLLBACK_TIME_SYNC_INTERVAL) {
+        session->lastTimeSyncTick = session->currentTick;
+        session->timeSyncSkipCount++;
+        SendInputs(session);
+        return;
+    }
+
+    int inputTick = session->currentTick + ROLLBACK_INPUT_DELAY;
+    SetInput(session, session->localPlayer, inputTick, localInput);
+    session->confirmedTicks[session->localPlayer] = inputTick;
+    SendInputs(session);
+
+    SimulateSessionTick(session, session->currentTick);
+    session->currentTick++;
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <string.h>
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "world.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+// a delta is this, then runCount runs, each a SnapshotRun followed by its bytes
+typedef struct SnapshotDeltaHeader {
+    unsigned int snapshotSize;
+    unsigned int runCount;
+} SnapshotDeltaHeader;
+
+typedef struct SnapshotRun {
+    unsigned int offset;
+    unsigned int size;
+} SnapshotRun;
+
+// only the main thread saves + loads files
+static unsigned char sFileBuffer[WORLD_SNAPSHOT_CAPACITY];
+
+static unsigned int HashBytes(unsigned int hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static void AddRegion(const char *name, void *data, size_t size, int capacity, int *count, size_t elementSize) {
+    SnapshotRegistry *snapshots = &gWorld->snapshots;
+    for (int i = 0; i < snapshots->regionCount; ++i) {
+        if (snapshots->regions[i].data == data) {
+            return;
+        }
+    }
+
+    if (snapshots->regionCount == MAX_SNAPSHOT_REGIONS) {
+        printf("ran out of snapshot regions for %s!\n", name);
+        return;
+    }
+
+    // a fresh world's registry is all zeroes, the first region starts its hash off
+    if (snapshots->regionCount == 0) {
+        snapshots->layoutHash = FNV_OFFSET_BASIS;
+    }
+    int index = snapshots->regionCount++;
+    snapshots->regions[index] = (SnapshotRegion) {
+        .name = name,
+        .data = data,
+        .size = size,
+        .capacity = capacity,
+        .count = count,
+        .elementSize = elementSize,
+    };
+
+    // two regions swapping places or names can keep every size the same, so those go in too.
+    // the name's terminator keeps "ab" + "c" apart from "a" + "bc"
+    bool isArray = count != NULL;
+    snapshots->layoutHash = HashBytes(snapshots->layoutHash, &index, sizeof(index));
+    snapshots->layoutHash = HashBytes(snapshots->layoutHash, name, strlen(name) + 1);
+    snapshots->layoutHash = HashBytes(snapshots->layoutHash, &size, sizeof(size));
+    snapshots->layoutHash = HashBytes(snapshots->layoutHash, &capacity, sizeof(capacity));
+    snapshots->layoutHash = HashBytes(snapshots->layoutHash, &isArray, sizeof(isArray));
+}
+
+void RegisterSnapshotRegion(const char *name, void *data, size_t size) {
+    AddRegion(name, data, size, 1, NULL, 0);
+}
+
+void RegisterSnapshotArray(const char *name, void *data, size_t elementSize, int capacity, int *count) {
+    AddRegion(name, data, elementSize, capacity, count, elementSize);
+}
+
+void RegisterSnapshotPool(Pool *pool) {
+    AddRegion(pool->name, pool->memory, pool->elementSize * (size_t) pool->capacity, 1, NULL, pool->elementSize);
+    AddRegion(pool->name, &pool->freeHead, sizeof(pool->freeHead), 1, NULL, 0);
+    AddRegion(pool->name, &pool->usedCount, sizeof(pool->usedCount), 1, NULL, 0);
+}
+
+size_t SaveSnapshot(void *buffer, size_t capacity) {
+    SnapshotRegistry *snapshots = &gWorld->snapshots;
+    unsigned char *cursor = buffer;
+    unsigned char *end = cursor + capacity;
+
+    if (capacity < sizeof(SnapshotHeader)) {
+        return 0;
+    }
+    cursor += sizeof(SnapshotHeader);
+
+    for (int i = 0; i < snapshots->regionCount; ++i) {
+        const SnapshotRegion *region = &snapshots->regions[i];
+        size_t size = region->size;
+
+        if (region->count != NULL) {
+            if ((size_t) (end - cursor) < sizeof(int)) {
+                return 0;
+            }
+            memcpy(cursor, region->count, sizeof(int));
+            cursor += sizeof(int);
+            size *= (size_t) *region->count;
+        }
+
+        if ((size_t) (end - cursor) < size) {
+            return 0;
+        }
+        memcpy(cursor, region->data, size);
+        cursor += size;
+    }
+
+    SnapshotHeader header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION | SNAPSHOT_FLAVOR,
+        .layoutHash = snapshots->layoutHash,
+        .size = (unsigned int) (cursor - (unsigned char *) buffer),
+    };
+    memcpy(buffer, &header, sizeof(header));
+    return header.size;
+}
+
+// walks the regions without touching the world, so a bad snapshot can't half load
+static bool IsSnapshotValid(const unsigned char *cursor, const unsigned char *end) {
+    SnapshotRegistry *snapshots = &gWorld->snapshots;
+    for (int i = 0; i < snapshots->regionCount; ++i) {
+        const SnapshotRegion *region = &snapshots->regions[i];
+        size_t regionSize = region->size;
+
+        if (region->count != NULL) {
+            int count;
+            if ((size_t) (end - cursor) < sizeof(count)) {
+                return false;
+            }
+            memcpy(&count, cursor, sizeof(count));
+            cursor += sizeof(count);
+            if (count < 0 || count > region->capacity) {
+                return false;
+            }
+            regionSize *= (size_t) count;
+        }
+
+        if ((size_t) (end - cursor) < regionSize) {
+            return false;
+        }
+        cursor += regionSize;
+    }
+
+    return cursor == end;
+}
+
+bool LoadSnapshot(const void *buffer, size_t size) {
+    SnapshotRegistry *snapshots = &gWorld->snapshots;
+    const unsigned char *cursor = buffer;
+    SnapshotHeader header;
+
+    if (size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, cursor, sizeof(header));
+
+    if (header.magic != SNAPSHOT_MAGIC || header.size > size || header.size < sizeof(header)) {
+        printf("not a snapshot!\n");
+        return false;
+    }
+    if (header.version != (SNAPSHOT_VERSION | SNAPSHOT_FLAVOR) || header.layoutHash != snapshots->layoutHash) {
+        printf("snapshot doesn't match the current world layout!\n");
+        return false;
+    }
+
+    const unsigned char *end = cursor + header.size;
+    cursor += sizeof(header);
+
+    if (!IsSnapshotValid(cursor, end)) {
+        printf("snapshot is corrupt!\n");
+        return false;
+    }
+
+    for (int i = 0; i < snapshots->regionCount; ++i) {
+        const SnapshotRegion *region = &snapshots->regions[i];
+        size_t regionSize = region->size;
+
+        if (region->count != NULL) {
+            memcpy(region->count, cursor, sizeof(int));
+            cursor += sizeof(int);
+            regionSize *= (size_t) *region->count;
+        }
+
+        memcpy(region->data, cursor, regionSize);
+        cursor += regionSize;
+    }
+
+    snapshots->loadCount++;
+    return true;
+}
+
+unsigned int GetSnapshotLoadCount() {
+    SnapshotRegistry *snapshots = &gWorld->snapshots;
+    return snapshots->loadCount;
+}
+
+unsigned int HashSnapshot(const void *buffer, size_t size) {
+    return HashBytes(FNV_OFFSET_BASIS, buffer, size);
+}
+
+static size_t GetDeltaBlockSize(size_t offset, size_t size) {
+    return size - offset < SNAPSHOT_DELTA_BLOCK ? size - offset : SNAPSHOT_DELTA_BLOCK;
+}
+
+size_t EncodeSnapshotDelta(void *buffer, size_t capacity, const void *previous, size_t previousSize,
+                           const void *current, size_t currentSize) {
+    if (capacity < sizeof(SnapshotDeltaHeader)) {
+        return 0;
+    }
+
+    unsigned char *out = buffer;
+    const unsigned char *previousBytes = previous;
+    const unsigned char *currentBytes = current;
+    SnapshotDeltaHeader header = {.snapshotSize = (unsigned int) currentSize, .runCount = 0};
+    size_t size = sizeof(header);
+
+    // neighbouring blocks that changed share a run
+    size_t offset = 0;
+    while (offset < currentSize) {
+        size_t blockSize = GetDeltaBlockSize(offset, currentSize);
+        if (offset + blockSize <= previousSize && memcmp(previousBytes + offset, currentBytes + offset, blockSize) == 0) {
+            offset += blockSize;
+            continue;
+        }
+
+        size_t runStart = offset;
+        while (offset < currentSize) {
+            blockSize = GetDeltaBlockSize(offset, currentSize);
+            if (offset + blockSize <= previousSize && memcmp(previousBytes + offset, currentBytes + offset, blockSize) == 0) {
+                break;
+            }
+            offset += blockSize;
+        }
+
+        SnapshotRun run = {.offset = (unsigned int) runStart, .size = (unsigned int) (offset - runStart)};
+        if (capacity - size < sizeof(run) + run.size) {
+            return 0;
+        }
+        memcpy(out + size, &run, sizeof(run));
+        memcpy(out + size + sizeof(run), currentBytes + runStart, run.size);
+        size += sizeof(run) + run.size;
+        header.runCount++;
+    }
+
+    memcpy(out, &header, sizeof(header));
+    return size;
+}
+
+size_t ApplySnapshotDelta(void *snapshot, size_t capacity, const void *delta, size_t deltaSize) {
+    if (deltaSize < sizeof(SnapshotDeltaHeader)) {
+        return 0;
+    }
+
+    // deltas can come off the network, so nothing gets written without checking it fits first
+    SnapshotDeltaHeader header;
+    memcpy(&header, delta, sizeof(header));
+    const unsigned char *cursor = (const unsigned char *) delta + sizeof(header);
+    const unsigned char *end = (const unsigned char *) delta + deltaSize;
+    if (header.snapshotSize > capacity) {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < header.runCount; ++i) {
+        SnapshotRun run;
+        if ((size_t) (end - cursor) < sizeof(run)) {
+            return 0;
+        }
+        memcpy(&run, cursor, sizeof(run));
+        cursor += sizeof(run);
+
+        if ((size_t) (end - cursor) < run.size || run.offset > header.snapshotSize || run.size > header.snapshotSize - run.offset) {
+            return 0;
+        }
+        memcpy((unsigned char *) snapshot + run.offset, cursor, run.size);
+        cursor += run.size;
+    }
+    return header.snapshotSize;
+}
+
+bool FindSnapshotDifference(const void *first, const void *second, SnapshotDifference *difference) {
+    SnapshotRegistry *snapshots = &gWorld->snapshots;
+    const unsigned char *firstCursor = (const unsigned char *) first + sizeof(SnapshotHeader);
+    const unsigned char *secondCursor = (const unsigned char *) second + sizeof(SnapshotHeader);
+
+    for (int i = 0; i < snapshots->regionCount; ++i) {
+        const SnapshotRegion *region = &snapshots->regions[i];
+        size_t firstSize = region->size;
+        size_t secondSize = region->size;
+
+        difference->regionName = region->name;
+        difference->element = -1;
+        difference->offset = 0;
+
+        if (region->count != NULL) {
+            int firstCount;
+            int secondCount;
+            memcpy(&firstCount, firstCursor, sizeof(int));
+            memcpy(&secondCount, secondCursor, sizeof(int));
+            if (firstCount != secondCount) {
+                return true;
+            }
+            firstCursor += sizeof(int);
+            secondCursor += sizeof(int);
+            firstSize *= (size_t) firstCount;
+            secondSize *= (size_t) secondCount;
+        }
+
+        for (size_t j = 0; j < firstSize; ++j) {
+            if (firstCursor[j] != secondCursor[j]) {
+                if (region->elementSize != 0) {
+                    difference->element = (int) (j / region->elementSize);
+                    difference->offset = j % region->elementSize;
+                }
+                else {
+                    difference->offset = j;
+                }
+                return true;
+            }
+        }
+
+        firstCursor += firstSize;
+        secondCursor += secondSize;
+    }
+    return false;
+}
+
+bool SaveSnapshotToFile(const char *path) {
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_SNAPSHOTS, sFileBuffer);
+    size_t size = SaveSnapshot(sFileBuffer, sizeof(sFileBuffer));
+    if (size == 0) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("couldn't open %s for writing!\n", path);
+        return false;
+    }
+
+    bool isWritten = fwrite(sFileBuffer, 1, size, file) == size;
+    fclose(file);
+    return isWritten;
+}
+
+bool LoadSnapshotFromFile(const char *path) {
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_SNAPSHOTS, sFileBuffer);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("couldn't open %s!\n", path);
+        return false;
+    }
+
+    size_t size = fread(sFileBuffer, 1, sizeof(sFileBuffer), file);
+    fclose(file);
+    return LoadSnapshot(sFileBuffer, size);
+}
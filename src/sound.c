@@ -1,29 +1,132 @@
+#include <stdio.h>
+#include <stdatomic.h>
 #include <raylib.h>
 #include <incbin.h>
 #include "sound.h"
+#include "platform.h"
+#include "memory_usage.h"
+#include "world.h"
 
-Sound gBallHitSound;
 INCBIN(BallHitSound, "sfx_ball_hit.wav");
-
-Sound gRestartSound;
 INCBIN(ObjectiveCollectSound, "sfx_objective_collect.wav");
-
-Sound gObjectiveCollectSound;
 INCBIN(RestartSound, "sfx_scratch.wav");
 
+// fixed size, so pushing one is a single copy
+typedef struct SoundTrigger {
+    GameSound sound;
+} SoundTrigger;
+
+// only the audio thread touches these once it's running
+static Sound sSounds[GAME_SOUND_COUNT];
+
+// single producer (whichever thread has sounds unmuted) single consumer (the audio thread)
+static SoundTrigger sQueue[SOUND_QUEUE_TRIGGERS];
+static atomic_uint sQueueWriteIndex;
+static atomic_uint sQueueReadIndex;
+static atomic_int sDroppedTriggerCount;
+
+static Thread sAudioThread;
+static atomic_bool sIsAudioThreadRunning;
+
 #define LOAD_AUDIO(NAME) LoadSoundFromMemory(".wav", g ## NAME ## Data, (int) g ## NAME ## Size)
 
+// the decoded samples, in the format the device plays them in
+static size_t GetSoundBytes(Sound sound) {
+    return (size_t) sound.frameCount * sound.stream.channels * (sound.stream.sampleSize / 8);
+}
+
 static Sound LoadSoundFromMemory(
     const char *fileType, const unsigned char *data, int dataSize
 ) {
     Wave wave = LoadWaveFromMemory(fileType, data, dataSize);
     Sound sound = LoadSoundFromWave(wave);
     UnloadWave(wave);
+    TrackHeapAllocation(MEMORY_TAG_SOUNDS, GetSoundBytes(sound));
     return sound;
 }
 
+// plays everything that's been queued, returns false if there wasn't anything
+static bool PlayQueuedSounds() {
+    unsigned int readIndex = atomic_load_explicit(&sQueueReadIndex, memory_order_relaxed);
+    unsigned int writeIndex = atomic_load_explicit(&sQueueWriteIndex, memory_order_acquire);
+    if (readIndex == writeIndex) {
+        return false;
+    }
+
+    for (; readIndex != writeIndex; ++readIndex) {
+        PlaySound(sSounds[sQueue[readIndex & (SOUND_QUEUE_TRIGGERS - 1)].sound]);
+    }
+    // hands the slots back to the producer
+    atomic_store_explicit(&sQueueReadIndex, readIndex, memory_order_release);
+    return true;
+}
+
+static void RunAudioThread(void *userData) {
+    (void) userData;
+    while (atomic_load(&sIsAudioThreadRunning)) {
+        if (!PlayQueuedSounds()) {
+            SleepSeconds(SOUND_THREAD_SLEEP_TIME);
+        }
+    }
+}
+
+void PlayGameSound(GameSound sound) {
+    if (gWorld->areSoundsMuted) {
+        return;
+    }
+
+    // no thread to hand it to, so play it here
+    if (!atomic_load_explicit(&sIsAudioThreadRunning, memory_order_relaxed)) {
+        PlaySound(sSounds[sound]);
+        return;
+    }
+
+    unsigned int writeIndex = atomic_load_explicit(&sQueueWriteIndex, memory_order_relaxed);
+    unsigned int readIndex = atomic_load_explicit(&sQueueReadIndex, memory_order_acquire);
+    // a sound that's this late isn't worth playing anyway
+    if (writeIndex - readIndex == SOUND_QUEUE_TRIGGERS) {
+        atomic_fetch_add_explicit(&sDroppedTriggerCount, 1, memory_order_relaxed);
+        return;
+    }
+
+    sQueue[writeIndex & (SOUND_QUEUE_TRIGGERS - 1)] = (SoundTrigger) {.sound = sound};
+    // publishes the trigger written above
+    atomic_store_explicit(&sQueueWriteIndex, writeIndex + 1, memory_order_release);
+}
+
+void SetSoundsMuted(bool isMuted) {
+    gWorld->areSoundsMuted = isMuted;
+}
+
 void LoadSounds() {
-    gBallHitSound = LOAD_AUDIO(BallHitSound);
-    gRestartSound = LOAD_AUDIO(RestartSound);
-    gObjectiveCollectSound = LOAD_AUDIO(ObjectiveCollectSound);
-}
\ No newline at end of file
+    sSounds[GAME_SOUND_BALL_HIT] = LOAD_AUDIO(BallHitSound);
+    sSounds[GAME_SOUND_RESTART] = LOAD_AUDIO(RestartSound);
+    sSounds[GAME_SOUND_OBJECTIVE_COLLECT] = LOAD_AUDIO(ObjectiveCollectSound);
+
+    atomic_init(&sQueueWriteIndex, 0);
+    atomic_init(&sQueueReadIndex, 0);
+    atomic_init(&sDroppedTriggerCount, 0);
+
+    atomic_store(&sIsAudioThreadRunning, true);
+    if (!StartThread(&sAudioThread, RunAudioThread, NULL)) {
+        atomic_store(&sIsAudioThreadRunning, false);
+        printf("couldn't start the audio thread, playing sounds from the game thread!\n");
+    }
+}
+
+void UnloadSounds() {
+    if (atomic_load(&sIsAudioThreadRunning)) {
+        atomic_store(&sIsAudioThreadRunning, false);
+        JoinThread(&sAudioThread);
+    }
+
+    int droppedTriggerCount = atomic_load(&sDroppedTriggerCount);
+    if (droppedTriggerCount > 0) {
+        printf("%d sounds didn't fit in the audio queue!\n", droppedTriggerCount);
+    }
+
+    for (int i = 0; i < GAME_SOUND_COUNT; ++i) {
+        TrackHeapRelease(MEMORY_TAG_SOUNDS, GetSoundBytes(sSounds[i]));
+        UnloadSound(sSounds[i]);
+    }
+}
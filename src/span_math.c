@@ -0,0 +1,647 @@
+#include <raylib.h>
+#include <raymath.h>
+#include <stdio.h>
+#include <string.h>
+#include "span_math.h"
+#include "math_util.h"
+#include "platform.h"
+
+// a fused multiply + add rounds once instead of twice, which would break matching the scalar path.
+// avx512f has fma built in, so gcc happily fuses our separate mul + add intrinsics unless told not to
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SPAN_MATH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET(ISA)
+#else
+#include <cpuid.h>
+// lets one file hold every kernel without building it for the newest cpu, callers check the cpu first
+#define TARGET(ISA) __attribute__((target(ISA)))
+#endif
+#endif
+
+typedef struct SpanMathKernels {
+    void (*ScaleAdd)(float *result, const float *values, float scale, int count);
+    void (*FixedScaleAdd)(Fixed *result, const Fixed *values, Fixed scale, int count);
+    void (*Lerp)(float *result, const float *from, const float *to, float amount, int count);
+    void (*Normalize)(float *x, float *y, int count);
+    void (*Ease)(float *values, Easing easing, int count);
+} SpanMathKernels;
+
+// the scalar path is the reference, it's written in terms of the helpers everything used before
+static void ScaleAddScalar(float *result, const float *values, float scale, int count) {
+    for (int i = 0; i < count; ++i) {
+        result[i] += values[i] * scale;
+    }
+}
+
+static void FixedScaleAddScalar(Fixed *result, const Fixed *values, Fixed scale, int count) {
+    for (int i = 0; i < count; ++i) {
+        result[i] += FixedMultiply(values[i], scale);
+    }
+}
+
+static void LerpScalar(float *result, const float *from, const float *to, float amount, int count) {
+    for (int i = 0; i < count; ++i) {
+        result[i] = Lerp(from[i], to[i], amount);
+    }
+}
+
+static void NormalizeScalar(float *x, float *y, int count) {
+    for (int i = 0; i < count; ++i) {
+        Vector2 normalized = Vector2Normalize((Vector2) {x[i], y[i]});
+        x[i] = normalized.x;
+        y[i] = normalized.y;
+    }
+}
+
+static float Ease(float t, Easing easing) {
+    switch (easing) {
+        case EASING_SMOOTH_STOP2: return SmoothStop2(t);
+        case EASING_SMOOTH_STOP3: return SmoothStop3(t);
+        case EASING_SMOOTH_STOP4: return SmoothStop4(t);
+        case EASING_SMOOTH_START2: return SmoothStart2(t);
+        case EASING_SMOOTH_START3: return SmoothStart3(t);
+        case EASING_SMOOTH_START4: return SmoothStart4(t);
+    }
+    return t;
+}
+
+static void EaseScalar(float *values, Easing easing, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = Ease(values[i], easing);
+    }
+}
+
+static const SpanMathKernels sScalarKernels = {ScaleAddScalar, FixedScaleAddScalar, LerpScalar, NormalizeScalar, EaseScalar};
+
+// smooth stops are 1 - (1 - t)^n, smooth starts are just t^n
+static bool IsSmoothStop(Easing easing) {
+    return easing <= EASING_SMOOTH_STOP4;
+}
+
+static int GetEasingPower(Easing easing) {
+    return 2 + (int) (IsSmoothStop(easing) ? easing - EASING_SMOOTH_STOP2 : easing - EASING_SMOOTH_START2);
+}
+
+#ifdef SPAN_MATH_X86
+
+// every kernel does whole vectors, then hands the leftovers to the scalar path
+
+TARGET("sse2") static void ScaleAddSse2(float *result, const float *values, float scale, int count) {
+    __m128 scales = _mm_set1_ps(scale);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 scaled = _mm_mul_ps(_mm_loadu_ps(values + i), scales);
+        _mm_storeu_ps(result + i, _mm_add_ps(_mm_loadu_ps(result + i), scaled));
+    }
+    ScaleAddScalar(result + i, values + i, scale, count - i);
+}
+
+// a fixed point product is bits 16..47 of the 64 bit one. the 32 x 32 -> 64 multiplies only do
+// even lanes, so odd lanes get shifted down first and their results shifted back up into place.
+// sse2 only multiplies unsigned, the high half of a signed product is that minus a correction
+TARGET("sse2") static __m128i MultiplyFixedSse2(__m128i a, __m128i b) {
+    __m128i evenMask = _mm_set_epi32(0, -1, 0, -1);
+    __m128i evenProducts = _mm_srli_epi64(_mm_mul_epu32(a, b), FIXED_FRACTION_BITS);
+    __m128i oddProducts = _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), 32 - FIXED_FRACTION_BITS);
+    __m128i products = _mm_or_si128(_mm_and_si128(evenMask, evenProducts), _mm_andnot_si128(evenMask, oddProducts));
+
+    __m128i correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b), _mm_and_si128(_mm_srai_epi32(b, 31), a));
+    return _mm_sub_epi32(products, _mm_slli_epi32(correction, 32 - FIXED_FRACTION_BITS));
+}
+
+TARGET("sse2") static void FixedScaleAddSse2(Fixed *result, const Fixed *values, Fixed scale, int count) {
+    __m128i scales = _mm_set1_epi32(scale);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i scaled = MultiplyFixedSse2(_mm_loadu_si128((const __m128i *) (values + i)), scales);
+        _mm_storeu_si128((__m128i *) (result + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (result + i)), scaled));
+    }
+    FixedScaleAddScalar(result + i, values + i, scale, count - i);
+}
+
+TARGET("sse2") static void LerpSse2(float *result, const float *from, const float *to, float amount, int count) {
+    __m128 amounts = _mm_set1_ps(amount);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 start = _mm_loadu_ps(from + i);
+        __m128 offset = _mm_mul_ps(amounts, _mm_sub_ps(_mm_loadu_ps(to + i), start));
+        _mm_storeu_ps(result + i, _mm_add_ps(start, offset));
+    }
+    LerpScalar(result + i, from + i, to + i, amount, count - i);
+}
+
+TARGET("sse2") static void NormalizeSse2(float *x, float *y, int count) {
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+        __m128 inverseLength = _mm_div_ps(one, length);
+
+        // no blend instruction before sse4.1, mask it by hand
+        __m128 isNonZero = _mm_cmpgt_ps(length, zero);
+        __m128 nx = _mm_mul_ps(vx, inverseLength);
+        __m128 ny = _mm_mul_ps(vy, inverseLength);
+        _mm_storeu_ps(x + i, _mm_or_ps(_mm_and_ps(isNonZero, nx), _mm_andnot_ps(isNonZero, vx)));
+        _mm_storeu_ps(y + i, _mm_or_ps(_mm_and_ps(isNonZero, ny), _mm_andnot_ps(isNonZero, vy)));
+    }
+    NormalizeScalar(x + i, y + i, count - i);
+}
+
+TARGET("sse2") static void EaseSse2(float *values, Easing easing, int count) {
+    bool isStop = IsSmoothStop(easing);
+    int power = GetEasingPower(easing);
+    __m128 one = _mm_set1_ps(1);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 t = _mm_loadu_ps(values + i);
+        __m128 base = isStop ? _mm_sub_ps(one, t) : t;
+        __m128 product = _mm_mul_ps(base, base);
+        for (int p = 2; p < power; ++p) {
+            product = _mm_mul_ps(product, base);
+        }
+        _mm_storeu_ps(values + i, isStop ? _mm_sub_ps(one, product) : product);
+    }
+    EaseScalar(values + i, easing, count - i);
+}
+
+TARGET("avx2") static void ScaleAddAvx2(float *result, const float *values, float scale, int count) {
+    __m256 scales = _mm256_set1_ps(scale);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 scaled = _mm256_mul_ps(_mm256_loadu_ps(values + i), scales);
+        _mm256_storeu_ps(result + i, _mm256_add_ps(_mm256_loadu_ps(result + i), scaled));
+    }
+    ScaleAddScalar(result + i, values + i, scale, count - i);
+}
+
+TARGET("avx2") static __m256i MultiplyFixedAvx2(__m256i a, __m256i b) {
+    __m256i evenProducts = _mm256_srli_epi64(_mm256_mul_epi32(a, b), FIXED_FRACTION_BITS);
+    __m256i oddProducts = _mm256_slli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), 32 - FIXED_FRACTION_BITS);
+    return _mm256_blend_epi32(evenProducts, oddProducts, 0xaa);
+}
+
+TARGET("avx2") static void FixedScaleAddAvx2(Fixed *result, const Fixed *values, Fixed scale, int count) {
+    __m256i scales = _mm256_set1_epi32(scale);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i scaled = MultiplyFixedAvx2(_mm256_loadu_si256((const __m256i *) (values + i)), scales);
+        _mm256_storeu_si256((__m256i *) (result + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (result + i)), scaled));
+    }
+    FixedScaleAddScalar(result + i, values + i, scale, count - i);
+}
+
+TARGET("avx2") static void LerpAvx2(float *result, const float *from, const float *to, float amount, int count) {
+    __m256 amounts = _mm256_set1_ps(amount);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 start = _mm256_loadu_ps(from + i);
+        __m256 offset = _mm256_mul_ps(amounts, _mm256_sub_ps(_mm256_loadu_ps(to + i), start));
+        _mm256_storeu_ps(result + i, _mm256_add_ps(start, offset));
+    }
+    LerpScalar(result + i, from + i, to + i, amount, count - i);
+}
+
+TARGET("avx2") static void NormalizeAvx2(float *x, float *y, int count) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+        __m256 inverseLength = _mm256_div_ps(one, length);
+        __m256 isNonZero = _mm256_cmp_ps(length, zero, _CMP_GT_OQ);
+        _mm256_storeu_ps(x + i, _mm256_blendv_ps(vx, _mm256_mul_ps(vx, inverseLength), isNonZero));
+        _mm256_storeu_ps(y + i, _mm256_blendv_ps(vy, _mm256_mul_ps(vy, inverseLength), isNonZero));
+    }
+    NormalizeScalar(x + i, y + i, count - i);
+}
+
+TARGET("avx2") static void EaseAvx2(float *values, Easing easing, int count) {
+    bool isStop = IsSmoothStop(easing);
+    int power = GetEasingPower(easing);
+    __m256 one = _mm256_set1_ps(1);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 t = _mm256_loadu_ps(values + i);
+        __m256 base = isStop ? _mm256_sub_ps(one, t) : t;
+        __m256 product = _mm256_mul_ps(base, base);
+        for (int p = 2; p < power; ++p) {
+            product = _mm256_mul_ps(product, base);
+        }
+        _mm256_storeu_ps(values + i, isStop ? _mm256_sub_ps(one, product) : product);
+    }
+    EaseScalar(values + i, easing, count - i);
+}
+
+TARGET("avx512f") static void ScaleAddAvx512(float *result, const float *values, float scale, int count) {
+    __m512 scales = _mm512_set1_ps(scale);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 scaled = _mm512_mul_ps(_mm512_loadu_ps(values + i), scales);
+        _mm512_storeu_ps(result + i, _mm512_add_ps(_mm512_loadu_ps(result + i), scaled));
+    }
+    ScaleAddScalar(result + i, values + i, scale, count - i);
+}
+
+TARGET("avx512f") static __m512i MultiplyFixedAvx512(__m512i a, __m512i b) {
+    __m512i evenProducts = _mm512_srli_epi64(_mm512_mul_epi32(a, b), FIXED_FRACTION_BITS);
+    __m512i oddProducts = _mm512_slli_epi64(_mm512_mul_epi32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32)), 32 - FIXED_FRACTION_BITS);
+    return _mm512_mask_blend_epi32(0xaaaa, evenProducts, oddProducts);
+}
+
+TARGET("avx512f") static void FixedScaleAddAvx512(Fixed *result, const Fixed *values, Fixed scale, int count) {
+    __m512i scales = _mm512_set1_epi32(scale);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i scaled = MultiplyFixedAvx512(_mm512_loadu_si512(values + i), scales);
+        _mm512_storeu_si512(result + i, _mm512_add_epi32(_mm512_loadu_si512(result + i), scaled));
+    }
+    FixedScaleAddScalar(result + i, values + i, scale, count - i);
+}
+
+TARGET("avx512f") static void LerpAvx512(float *result, const float *from, const float *to, float amount, int count) {
+    __m512 amounts = _mm512_set1_ps(amount);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 start = _mm512_loadu_ps(from + i);
+        __m512 offset = _mm512_mul_ps(amounts, _mm512_sub_ps(_mm512_loadu_ps(to + i), start));
+        _mm512_storeu_ps(result + i, _mm512_add_ps(start, offset));
+    }
+    LerpScalar(result + i, from + i, to + i, amount, count - i);
+}
+
+TARGET("avx512f") static void NormalizeAvx512(float *x, float *y, int count) {
+    __m512 zero = _mm512_setzero_ps();
+    __m512 one = _mm512_set1_ps(1);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 vx = _mm512_loadu_ps(x + i);
+        __m512 vy = _mm512_loadu_ps(y + i);
+        __m512 length = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(vx, vx), _mm512_mul_ps(vy, vy)));
+        __m512 inverseLength = _mm512_div_ps(one, length);
+        __mmask16 isNonZero = _mm512_cmp_ps_mask(length, zero, _CMP_GT_OQ);
+        _mm512_storeu_ps(x + i, _mm512_mask_mul_ps(vx, isNonZero, vx, inverseLength));
+        _mm512_storeu_ps(y + i, _mm512_mask_mul_ps(vy, isNonZero, vy, inverseLength));
+    }
+    NormalizeScalar(x + i, y + i, count - i);
+}
+
+TARGET("avx512f") static void EaseAvx512(float *values, Easing easing, int count) {
+    bool isStop = IsSmoothStop(easing);
+    int power = GetEasingPower(easing);
+    __m512 one = _mm512_set1_ps(1);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 t = _mm512_loadu_ps(values + i);
+        __m512 base = isStop ? _mm512_sub_ps(one, t) : t;
+        __m512 product = _mm512_mul_ps(base, base);
+        for (int p = 2; p < power; ++p) {
+            product = _mm512_mul_ps(product, base);
+        }
+        _mm512_storeu_ps(values + i, isStop ? _mm512_sub_ps(one, product) : product);
+    }
+    EaseScalar(values + i, easing, count - i);
+}
+
+static const SpanMathKernels sSse2Kernels = {ScaleAddSse2, FixedScaleAddSse2, LerpSse2, NormalizeSse2, EaseSse2};
+static const SpanMathKernels sAvx2Kernels = {ScaleAddAvx2, FixedScaleAddAvx2, LerpAvx2, NormalizeAvx2, EaseAvx2};
+static const SpanMathKernels sAvx512Kernels = {ScaleAddAvx512, FixedScaleAddAvx512, LerpAvx512, NormalizeAvx512, EaseAvx512};
+
+static void GetCpuid(unsigned int leaf, unsigned int subleaf, unsigned int registers[4]) {
+#ifdef _MSC_VER
+    __cpuidex((int *) registers, (int) leaf, (int) subleaf);
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// which register files the os saves on a context switch, a cpu with avx is no use if the os doesn't
+static unsigned long long GetEnabledCpuState() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((unsigned long long) high << 32) | low;
+#endif
+}
+
+static SpanMathLevel DetectSpanMathLevel() {
+    unsigned int registers[4];
+    GetCpuid(0, 0, registers);
+    unsigned int maxLeaf = registers[0];
+
+    GetCpuid(1, 0, registers);
+    bool hasSse2 = registers[3] & (1u << 26);
+    bool hasOsXsave = registers[2] & (1u << 27);
+    bool hasAvx = registers[2] & (1u << 28);
+
+    if (!hasSse2) {
+        return SPAN_MATH_SCALAR;
+    }
+    if (!hasOsXsave || !hasAvx || maxLeaf < 7) {
+        return SPAN_MATH_SSE2;
+    }
+
+    unsigned long long cpuState = GetEnabledCpuState();
+    bool isYmmEnabled = (cpuState & 0x6) == 0x6;   // xmm + upper ymm
+    bool isZmmEnabled = (cpuState & 0xe6) == 0xe6; // that + opmask + both halves of zmm
+    GetCpuid(7, 0, registers);
+    bool hasAvx2 = registers[1] & (1u << 5);
+    bool hasAvx512 = registers[1] & (1u << 16);
+
+    if (hasAvx512 && isZmmEnabled) {
+        return SPAN_MATH_AVX512;
+    }
+    if (hasAvx2 && isYmmEnabled) {
+        return SPAN_MATH_AVX2;
+    }
+    return SPAN_MATH_SSE2;
+}
+
+#else
+
+static SpanMathLevel DetectSpanMathLevel() {
+    return SPAN_MATH_SCALAR;
+}
+
+#endif
+
+static const SpanMathKernels *sKernels = &sScalarKernels;
+static SpanMathLevel sLevel = SPAN_MATH_SCALAR;
+static SpanMathLevel sSupportedLevel = SPAN_MATH_SCALAR;
+
+static const SpanMathKernels *GetKernels(SpanMathLevel level) {
+    switch (level) {
+#ifdef SPAN_MATH_X86
+        case SPAN_MATH_SSE2: return &sSse2Kernels;
+        case SPAN_MATH_AVX2: return &sAvx2Kernels;
+        case SPAN_MATH_AVX512: return &sAvx512Kernels;
+#endif
+        default: return &sScalarKernels;
+    }
+}
+
+void InitSpanMath() {
+    sSupportedLevel = DetectSpanMathLevel();
+    SetSpanMathLevel(sSupportedLevel);
+}
+
+SpanMathLevel GetSpanMathLevel() {
+    return sLevel;
+}
+
+SpanMathLevel GetSupportedSpanMathLevel() {
+    return sSupportedLevel;
+}
+
+bool SetSpanMathLevel(SpanMathLevel level) {
+    if (level > sSupportedLevel) {
+        return false;
+    }
+    sLevel = level;
+    sKernels = GetKernels(level);
+    return true;
+}
+
+const char *GetSpanMathLevelName(SpanMathLevel level) {
+    switch (level) {
+        case SPAN_MATH_SCALAR: return "scalar";
+        case SPAN_MATH_SSE2: return "sse2";
+        case SPAN_MATH_AVX2: return "avx2";
+        case SPAN_MATH_AVX512: return "avx512";
+        case SPAN_MATH_LEVEL_COUNT: break;
+    }
+    return "unknown";
+}
+
+void ScaleAddSpan(float *result, const float *values, float scale, int count) {
+    sKernels->ScaleAdd(result, values, scale, count);
+}
+
+void FixedScaleAddSpan(Fixed *result, const Fixed *values, Fixed scale, int count) {
+    sKernels->FixedScaleAdd(result, values, scale, count);
+}
+
+void LerpSpan(float *result, const float *from, const float *to, float amount, int count) {
+    sKernels->Lerp(result, from, to, amount, count);
+}
+
+void NormalizeSpan(float *x, float *y, int count) {
+    sKernels->Normalize(x, y, count);
+}
+
+void EaseSpan(float *values, Easing easing, int count) {
+    sKernels->Ease(values, easing, count);
+}
+
+void RandomPointOnUnitCircleSpan(float *x, float *y, int count) {
+    // each draw depends on the last one, so only the normalize can go wide
+    for (int i = 0; i < count; ++i) {
+        x[i] = (RandomFloat() * 2) - 1;
+        y[i] = (RandomFloat() * 2) - 1;
+    }
+    NormalizeSpan(x, y, count);
+}
+
+static float sCheckInputA[SPAN_MATH_CHECK_COUNT];
+static float sCheckInputB[SPAN_MATH_CHECK_COUNT];
+static float sCheckExpectedA[SPAN_MATH_CHECK_COUNT];
+static float sCheckExpectedB[SPAN_MATH_CHECK_COUNT];
+static float sCheckActualA[SPAN_MATH_CHECK_COUNT];
+static float sCheckActualB[SPAN_MATH_CHECK_COUNT];
+
+// its own generator, checking shouldn't move the simulation's random state
+static float GetCheckValue(unsigned int *state, float range) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return ((float) (x >> 8) / (float) (1 << 24) * 2 - 1) * range;
+}
+
+static void FillCheckInputs(float range) {
+    unsigned int state = 12345;
+    for (int i = 0; i < SPAN_MATH_CHECK_COUNT; ++i) {
+        sCheckInputA[i] = GetCheckValue(&state, range);
+        sCheckInputB[i] = GetCheckValue(&state, range);
+    }
+
+    // zero vectors take a different path through normalize
+    for (int i = 0; i < SPAN_MATH_CHECK_COUNT; i += 17) {
+        sCheckInputA[i] = 0;
+        sCheckInputB[i] = 0;
+    }
+}
+
+static bool IsCheckMatching(int count) {
+    return memcmp(sCheckExpectedA, sCheckActualA, (size_t) count * sizeof(float)) == 0 &&
+           memcmp(sCheckExpectedB, sCheckActualB, (size_t) count * sizeof(float)) == 0;
+}
+
+// runs one operation on the reference + the kernels under test, returns nanoseconds per element or -1 on a mismatch
+typedef void (*CheckOperation)(const SpanMathKernels *kernels, float *a, float *b, int count);
+
+static double CheckKernels(const SpanMathKernels *kernels, CheckOperation operation, float range) {
+    FillCheckInputs(range);
+    memcpy(sCheckExpectedA, sCheckInputA, sizeof(sCheckInputA));
+    memcpy(sCheckExpectedB, sCheckInputB, sizeof(sCheckInputB));
+    operation(&sScalarKernels, sCheckExpectedA, sCheckExpectedB, SPAN_MATH_CHECK_COUNT);
+
+    // every length up to a couple of avx512 vectors, then the whole thing, so no tail goes unchecked
+    for (int count = 0; count <= 40; ++count) {
+        memcpy(sCheckActualA, sCheckInputA, sizeof(sCheckInputA));
+        memcpy(sCheckActualB, sCheckInputB, sizeof(sCheckInputB));
+        operation(kernels, sCheckActualA, sCheckActualB, count);
+        if (!IsCheckMatching(count)) {
+            return -1;
+        }
+    }
+
+    double totalTime = 0;
+    for (int round = 0; round < SPAN_MATH_CHECK_ROUNDS; ++round) {
+        memcpy(sCheckActualA, sCheckInputA, sizeof(sCheckInputA));
+        memcpy(sCheckActualB, sCheckInputB, sizeof(sCheckInputB));
+        double startTime = GetMonotonicTime();
+        operation(kernels, sCheckActualA, sCheckActualB, SPAN_MATH_CHECK_COUNT);
+        totalTime += GetMonotonicTime() - startTime;
+
+        if (!IsCheckMatching(SPAN_MATH_CHECK_COUNT)) {
+            return -1;
+        }
+    }
+    return totalTime / SPAN_MATH_CHECK_ROUNDS / SPAN_MATH_CHECK_COUNT * 1e9;
+}
+
+static void CheckScaleAdd(const SpanMathKernels *kernels, float *a, float *b, int count) {
+    kernels->ScaleAdd(a, b, 1.0f / 60, count);
+    kernels->ScaleAdd(b, a, -3.7f, count);
+}
+
+static void CheckLerp(const SpanMathKernels *kernels, float *a, float *b, int count) {
+    kernels->Lerp(a, a, b, 0.3f, count);
+    kernels->Lerp(b, b, a, 1.7f, count);
+}
+
+static void CheckNormalize(const SpanMathKernels *kernels, float *a, float *b, int count) {
+    kernels->Normalize(a, b, count);
+}
+
+static void CheckEase(const SpanMathKernels *kernels, float *a, float *b, int count) {
+    // a bit past [0, 1] on purpose, nothing clamps before easing
+    for (Easing easing = EASING_SMOOTH_STOP2; easing <= EASING_SMOOTH_START4; ++easing) {
+        kernels->Ease(easing % 2 == 0 ? a : b, easing, count);
+    }
+}
+
+static Fixed sCheckFixedInput[SPAN_MATH_CHECK_COUNT];
+static Fixed sCheckFixedExpected[SPAN_MATH_CHECK_COUNT];
+static Fixed sCheckFixedActual[SPAN_MATH_CHECK_COUNT];
+
+// same idea as CheckKernels, for the one integer kernel
+static double CheckFixedScaleAdd(const SpanMathKernels *kernels) {
+    // negative values + scales both, since sse2 has to patch up the sign of every product itself
+    unsigned int state = 54321;
+    for (int i = 0; i < SPAN_MATH_CHECK_COUNT; ++i) {
+        sCheckFixedInput[i] = FixedFromFloat(GetCheckValue(&state, 1000));
+    }
+    Fixed scales[] = {FixedFromFloat(1.0f / 60), FixedFromFloat(-3.7f)};
+
+    memcpy(sCheckFixedExpected, sCheckFixedInput, sizeof(sCheckFixedInput));
+    for (int j = 0; j < 2; ++j) {
+        FixedScaleAddScalar(sCheckFixedExpected, sCheckFixedInput, scales[j], SPAN_MATH_CHECK_COUNT);
+    }
+
+    for (int count = 0; count <= 40; ++count) {
+        memcpy(sCheckFixedActual, sCheckFixedInput, sizeof(sCheckFixedInput));
+        for (int j = 0; j < 2; ++j) {
+            kernels->FixedScaleAdd(sCheckFixedActual, sCheckFixedInput, scales[j], count);
+        }
+        if (memcmp(sCheckFixedExpected, sCheckFixedActual, (size_t) count * sizeof(Fixed)) != 0) {
+            return -1;
+        }
+    }
+
+    double totalTime = 0;
+    for (int round = 0; round < SPAN_MATH_CHECK_ROUNDS; ++round) {
+        memcpy(sCheckFixedActual, sCheckFixedInput, sizeof(sCheckFixedInput));
+        double startTime = GetMonotonicTime();
+        for (int j = 0; j < 2; ++j) {
+            kernels->FixedScaleAdd(sCheckFixedActual, sCheckFixedInput, scales[j], SPAN_MATH_CHECK_COUNT);
+        }
+        totalTime += GetMonotonicTime() - startTime;
+
+        if (memcmp(sCheckFixedExpected, sCheckFixedActual, sizeof(sCheckFixedActual)) != 0) {
+            return -1;
+        }
+    }
+    return totalTime / SPAN_MATH_CHECK_ROUNDS / SPAN_MATH_CHECK_COUNT * 1e9;
+}
+
+static bool CheckRandomPointOnUnitCircleSpan() {
+    SeedRandom(777);
+    for (int i = 0; i < SPAN_MATH_CHECK_COUNT; ++i) {
+        Vector2 point = RandomPointOnUnitCircle();
+        sCheckExpectedA[i] = point.x;
+        sCheckExpectedB[i] = point.y;
+    }
+
+    SeedRandom(777);
+    RandomPointOnUnitCircleSpan(sCheckActualA, sCheckActualB, SPAN_MATH_CHECK_COUNT);
+    return IsCheckMatching(SPAN_MATH_CHECK_COUNT);
+}
+
+int RunSpanMathCheck() {
+    printf("span math: this cpu supports up to %s\n", GetSpanMathLevelName(sSupportedLevel));
+    printf("level    scale-add     lerp  normalize     ease  fixed s-a   (ns per element)\n");
+
+    SpanMathLevel selectedLevel = sLevel;
+    int mismatchCount = 0;
+
+    for (SpanMathLevel level = SPAN_MATH_SCALAR; level <= sSupportedLevel; ++level) {
+        const SpanMathKernels *kernels = GetKernels(level);
+        double times[5] = {
+            CheckKernels(kernels, CheckScaleAdd, 1000),
+            CheckKernels(kernels, CheckLerp, 1000),
+            CheckKernels(kernels, CheckNormalize, 1000),
+            CheckKernels(kernels, CheckEase, 1.2f),
+            CheckFixedScaleAdd(kernels),
+        };
+
+        printf("%-7s", GetSpanMathLevelName(level));
+        for (int i = 0; i < 5; ++i) {
+            if (times[i] < 0) {
+                printf("   MISMATCH");
+                mismatchCount++;
+            }
+            else {
+                printf(" %10.3f", times[i]);
+            }
+        }
+        printf("\n");
+
+        SetSpanMathLevel(level);
+        if (!CheckRandomPointOnUnitCircleSpan()) {
+            printf("%s random points on the unit circle don't match RandomPointOnUnitCircle!\n", GetSpanMathLevelName(level));
+            mismatchCount++;
+        }
+    }
+
+    SetSpanMathLevel(selectedLevel);
+    printf(mismatchCount == 0 ? "every level matches the scalar path\n" : "%d mismatches!\n", mismatchCount);
+    return mismatchCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,842 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "spectator.h"
+#include "snapshot.h"
+#include "net.h"
+#include "game.h"
+#include "bot.h"
+#include "sound.h"
+#include "arena.h"
+#include "metrics.h"
+#include "platform.h"
+#include "log.h"
+#include "memory_usage.h"
+#include "timer_wheel.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#define HAS_EPOLL
+#endif
+
+#define LISTENER_EVENT_ID MAX_SPECTATORS   // what epoll tags the listener with, spectators are tagged with their index
+#define WAKE_EVENT_ID (MAX_SPECTATORS + 1) // and the eventfd StopSpectatorServer wakes the broadcast thread with
+
+// a world on its way from the game thread to the broadcast thread
+typedef struct QueuedWorld {
+    size_t size;
+    unsigned char bytes[SPECTATOR_WORLD_CAPACITY];
+} QueuedWorld;
+
+// a world that went out, kept so spectators still on it can get deltas against it
+typedef struct BroadcastWorld {
+    int tick; // -1 when empty
+    unsigned int hash;
+    size_t size;
+    unsigned char bytes[SPECTATOR_WORLD_CAPACITY];
+} BroadcastWorld;
+
+typedef struct SpectatorMessage {
+    int tick;              // -1 when empty
+    int requestedBaseTick; // what it was made for, the header says -1 if a whole world turned out smaller
+    bool isWholeWorld;
+    int senderCount;       // spectators still sending it, it can only be replaced at 0
+    size_t size;
+    unsigned char bytes[sizeof(SpectatorMessageHeader) + SPECTATOR_WORLD_CAPACITY];
+} SpectatorMessage;
+
+typedef struct Spectator {
+    bool isConnected;
+    intptr_t socket;
+    int tick;                  // the newest tick it's acked, -1 before its first
+    int sentTick;              // the newest tick it's been sent, it's ready for more once it acks it
+    SpectatorMessage *message; // going out right now, NULL when idle
+    size_t sentSize;
+    bool isWaitingToWrite;     // its socket's buffer filled up, epoll says when there's room again
+    unsigned char ackBytes[sizeof(int)];
+    int ackSize;
+} Spectator;
+
+// the receiving end of the stream
+typedef struct SpectatorViewer {
+    bool isConnected;
+    intptr_t socket;
+    int tick; // -1 before the first world
+    unsigned char *world;
+    size_t worldSize;
+    size_t worldCapacity;
+    unsigned char *message; // header + payload, has room for sizeof(SpectatorMessageHeader) + worldCapacity
+    size_t messageSize;     // received so far
+    int worldCount;
+    int badMessageCount;
+} SpectatorViewer;
+
+// single producer (the game thread) single consumer (the broadcast thread)
+static QueuedWorld sQueue[SPECTATOR_QUEUE_WORLDS];
+static atomic_uint sQueueWriteIndex;
+static atomic_uint sQueueReadIndex;
+
+static bool sIsServerRunning;
+static intptr_t sListener;
+static Thread sBroadcastThread;
+static atomic_bool sIsBroadcastThreadRunning;
+static int sDroppedWorldCount;
+// the world last published, frames in between ticks have nothing new to send
+static int sPublishedTimerTick;
+static unsigned int sPublishedLoadCount;
+
+// written by the broadcast thread, read by the game thread for metrics + to skip publishing to nobody
+static atomic_int sSpectatorCount;
+static atomic_ullong sSentByteCount;
+static atomic_int sWholeWorldCount;
+static atomic_int sDeltaCount;
+static unsigned long long sReportedSentByteCount;
+
+static Metric sSpectatorsMetric;
+static Metric sSentBytesMetric;
+static Metric sDroppedWorldsMetric;
+
+// only the broadcast thread touches these once it's running
+static int sEpoll = -1;
+static int sWakeEvent = -1;
+static Spectator sSpectators[MAX_SPECTATORS];
+static BroadcastWorld sHistory[SPECTATOR_HISTORY_TICKS];
+static SpectatorMessage sMessages[SPECTATOR_MESSAGE_SLOTS];
+static int sNewestTick;
+
+static bool sIsSpectating;
+static SpectatorViewer sViewer;
+static unsigned char sViewerWorld[SPECTATOR_WORLD_CAPACITY];
+static unsigned char sViewerMessage[sizeof(SpectatorMessageHeader) + SPECTATOR_WORLD_CAPACITY];
+
+#ifdef HAS_EPOLL
+
+static void CloseSpectator(Spectator *spectator) {
+    if (spectator->message != NULL) {
+        spectator->message->senderCount--;
+        spectator->message = NULL;
+    }
+    epoll_ctl(sEpoll, EPOLL_CTL_DEL, (int) spectator->socket, NULL);
+    CloseTcpSocket(spectator->socket);
+    spectator->isConnected = false;
+    atomic_fetch_sub(&sSpectatorCount, 1);
+}
+
+static void AcceptSpectators() {
+    intptr_t socket;
+
+    while (AcceptTcpConnection(sListener, &socket)) {
+        int index = 0;
+        while (index < MAX_SPECTATORS && sSpectators[index].isConnected) {
+            index++;
+        }
+        if (index == MAX_SPECTATORS) {
+            LogMessage("turned a spectator away, there's already %d!", MAX_SPECTATORS);
+            CloseTcpSocket(socket);
+            continue;
+        }
+
+        struct epoll_event event = {.events = EPOLLIN, .data.u32 = (unsigned int) index};
+        if (epoll_ctl(sEpoll, EPOLL_CTL_ADD, (int) socket, &event) != 0) {
+            CloseTcpSocket(socket);
+            continue;
+        }
+
+        sSpectators[index] = (Spectator) {
+            .isConnected = true,
+            .socket = socket,
+            .tick = -1,
+            .sentTick = -1,
+        };
+        atomic_fetch_add(&sSpectatorCount, 1);
+    }
+}
+
+static void SetWaitingToWrite(Spectator *spectator, bool isWaiting) {
+    if (spectator->isWaitingToWrite == isWaiting) {
+        return;
+    }
+
+    struct epoll_event event = {
+        .events = isWaiting ? EPOLLIN | EPOLLOUT : EPOLLIN,
+        .data.u32 = (unsigned int) (spectator - sSpectators),
+    };
+    epoll_ctl(sEpoll, EPOLL_CTL_MOD, (int) spectator->socket, &event);
+    spectator->isWaitingToWrite = isWaiting;
+}
+
+// sends as much of the current message as the socket takes, returns false if the spectator is gone
+static bool SendPending(Spectator *spectator) {
+    while (spectator->message != NULL) {
+        SpectatorMessage *message = spectator->message;
+        int sentSize = SendTcpPartial(spectator->socket, message->bytes + spectator->sentSize, (int) (message->size - spectator->sentSize));
+        if (sentSize < 0) {
+            return false;
+        }
+        if (sentSize == 0) {
+            SetWaitingToWrite(spectator, true);
+            return true;
+        }
+
+        atomic_fetch_add_explicit(&sSentByteCount, (unsigned long long) sentSize, memory_order_relaxed);
+        spectator->sentSize += sentSize;
+        if (spectator->sentSize == message->size) {
+            message->senderCount--;
+            spectator->message = NULL;
+        }
+    }
+
+    SetWaitingToWrite(spectator, false);
+    return true;
+}
+
+// returns false if the spectator hung up
+static bool ReceiveAcks(Spectator *spectator) {
+    for (;;) {
+        int capacity = (int) sizeof(spectator->ackBytes) - spectator->ackSize;
+        int size = ReceiveTcp(spectator->socket, spectator->ackBytes + spectator->ackSize, capacity);
+        if (size == 0) {
+            return false;
+        }
+        if (size < 0) {
+            return true;
+        }
+
+        spectator->ackSize += size;
+        if (spectator->ackSize == (int) sizeof(spectator->ackBytes)) {
+            int tick;
+            memcpy(&tick, spectator->ackBytes, sizeof(tick));
+            spectator->ackSize = 0;
+
+            // anything else is stale (or made up), and would point deltas at a world it doesn't have
+            if (tick == spectator->sentTick) {
+                spectator->tick = tick;
+            }
+        }
+    }
+}
+
+static const BroadcastWorld *FindBroadcastWorld(int tick) {
+    if (tick < 0) {
+        return NULL;
+    }
+    const BroadcastWorld *world = &sHistory[tick % SPECTATOR_HISTORY_TICKS];
+    return world->tick == tick ? world : NULL;
+}
+
+// only the newest world published matters, anything between it and the last one gets skipped
+// returns false if nothing new was published
+static bool TakeNewestWorld() {
+    unsigned int readIndex = atomic_load_explicit(&sQueueReadIndex, memory_order_relaxed);
+    unsigned int writeIndex = atomic_load_explicit(&sQueueWriteIndex, memory_order_acquire);
+    if (readIndex == writeIndex) {
+        return false;
+    }
+
+    int tick = (int) (writeIndex - 1);
+    const QueuedWorld *queued = &sQueue[(writeIndex - 1) & (SPECTATOR_QUEUE_WORLDS - 1)];
+    BroadcastWorld *world = &sHistory[tick % SPECTATOR_HISTORY_TICKS];
+    memcpy(world->bytes, queued->bytes, queued->size);
+    world->size = queued->size;
+    world->tick = tick;
+    world->hash = HashSnapshot(world->bytes, world->size);
+
+    // hands the slots back to the producer
+    atomic_store_explicit(&sQueueReadIndex, writeIndex, memory_order_release);
+    sNewestTick = tick;
+    return true;
+}
+
+// the newest world for a spectator that has baseTick, shared with anyone else that has it too.
+// returns NULL if every message slot is still going out
+static SpectatorMessage *GetNewestMessage(int baseTick) {
+    const BroadcastWorld *world = FindBroadcastWorld(sNewestTick);
+    const BroadcastWorld *base = FindBroadcastWorld(baseTick);
+    int requestedBaseTick = base != NULL ? baseTick : -1;
+    SpectatorMessage *message = NULL;
+
+    for (int i = 0; i < SPECTATOR_MESSAGE_SLOTS; ++i) {
+        SpectatorMessage *candidate = &sMessages[i];
+        if (candidate->tick == sNewestTick && candidate->requestedBaseTick == requestedBaseTick) {
+            return candidate;
+        }
+        // replace whatever's oldest, so this tick's messages stick around for the spectators after this one
+        if (candidate->senderCount == 0 && (message == NULL || candidate->tick < message->tick)) {
+            message = candidate;
+        }
+    }
+
+    if (message == NULL) {
+        return NULL;
+    }
+
+    SpectatorMessageHeader header = {
+        .magic = SPECTATOR_MAGIC,
+        .tick = sNewestTick,
+        .baseTick = -1,
+        .worldHash = world->hash,
+        .payloadSize = (unsigned int) world->size,
+    };
+    unsigned char *payload = message->bytes + sizeof(header);
+
+    // a delta that's bigger than the whole world isn't worth it
+    if (base != NULL) {
+        size_t deltaSize = EncodeSnapshotDelta(payload, world->size, base->bytes, base->size, world->bytes, world->size);
+        if (deltaSize != 0) {
+            header.baseTick = baseTick;
+            header.payloadSize = (unsigned int) deltaSize;
+        }
+    }
+    if (header.baseTick == -1) {
+        memcpy(payload, world->bytes, world->size);
+    }
+
+    memcpy(message->bytes, &header, sizeof(header));
+    message->tick = sNewestTick;
+    message->requestedBaseTick = requestedBaseTick;
+    message->isWholeWorld = header.baseTick == -1;
+    message->size = sizeof(header) + header.payloadSize;
+    return message;
+}
+
+static void SendNewestWorld() {
+    if (sNewestTick < 0) {
+        return;
+    }
+
+    for (int i = 0; i < MAX_SPECTATORS; ++i) {
+        Spectator *spectator = &sSpectators[i];
+        // one message at a time, and not until the last one's been acked
+        bool isReady = spectator->isConnected && spectator->message == NULL && spectator->tick == spectator->sentTick;
+        if (!isReady || spectator->tick == sNewestTick) {
+            continue;
+        }
+
+        SpectatorMessage *message = GetNewestMessage(spectator->tick);
+        if (message == NULL) {
+            continue;
+        }
+
+        message->senderCount++;
+        spectator->message = message;
+        spectator->sentSize = 0;
+        spectator->sentTick = sNewestTick;
+        atomic_fetch_add_explicit(message->isWholeWorld ? &sWholeWorldCount : &sDeltaCount, 1, memory_order_relaxed);
+
+        if (!SendPending(spectator)) {
+            CloseSpectator(spectator);
+        }
+    }
+}
+
+static void RunBroadcastThread(void *userData) {
+    (void) userData;
+    struct epoll_event events[MAX_SPECTATORS + 2];
+    double nextWorldTime = GetMonotonicTime();
+
+    while (atomic_load(&sIsBroadcastThreadRunning)) {
+        // with nobody watching there's nothing to do until someone connects (or we're stopped).
+        // otherwise acks + sockets with room again wake us, and the timeout is when the next
+        // world should have been published, a tick after the last one
+        int timeout = -1;
+        if (atomic_load_explicit(&sSpectatorCount, memory_order_relaxed) > 0) {
+            double now = GetMonotonicTime();
+            if (nextWorldTime <= now) {
+                nextWorldTime = now + SIMULATION_TICK_TIME;
+            }
+            timeout = (int) ((nextWorldTime - now) * 1000) + 1;
+        }
+        int eventCount = epoll_wait(sEpoll, events, MAX_SPECTATORS + 2, timeout);
+
+        for (int i = 0; i < eventCount; ++i) {
+            unsigned int id = events[i].data.u32;
+            if (id == LISTENER_EVENT_ID) {
+                AcceptSpectators();
+                continue;
+            }
+            if (id == WAKE_EVENT_ID) {
+                continue;
+            }
+
+            Spectator *spectator = &sSpectators[id];
+            if (!spectator->isConnected) {
+                continue;
+            }
+
+            bool isAlive = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0;
+            if (isAlive && (events[i].events & EPOLLIN)) {
+                isAlive = ReceiveAcks(spectator);
+            }
+            if (isAlive && (events[i].events & EPOLLOUT)) {
+                isAlive = SendPending(spectator);
+            }
+            if (!isAlive) {
+                CloseSpectator(spectator);
+            }
+        }
+
+        if (TakeNewestWorld()) {
+            nextWorldTime = GetMonotonicTime() + SIMULATION_TICK_TIME;
+        }
+        SendNewestWorld();
+    }
+}
+
+#endif // HAS_EPOLL
+
+bool StartSpectatorServer(unsigned short port) {
+#ifdef HAS_EPOLL
+    if (sIsServerRunning) {
+        return true;
+    }
+
+    if (!InitNet()) {
+        return false;
+    }
+
+    if (!OpenTcpListener(port, true, &sListener)) {
+        CloseNet();
+        return false;
+    }
+
+    sEpoll = epoll_create1(0);
+    sWakeEvent = eventfd(0, EFD_NONBLOCK);
+    struct epoll_event event = {.events = EPOLLIN, .data.u32 = LISTENER_EVENT_ID};
+    struct epoll_event wakeEvent = {.events = EPOLLIN, .data.u32 = WAKE_EVENT_ID};
+    if (sEpoll < 0 || sWakeEvent < 0 || epoll_ctl(sEpoll, EPOLL_CTL_ADD, (int) sListener, &event) != 0 ||
+        epoll_ctl(sEpoll, EPOLL_CTL_ADD, sWakeEvent, &wakeEvent) != 0) {
+        printf("couldn't set up epoll for the spectator server!\n");
+        if (sEpoll >= 0) {
+            close(sEpoll);
+        }
+        if (sWakeEvent >= 0) {
+            close(sWakeEvent);
+        }
+        CloseTcpSocket(sListener);
+        CloseNet();
+        return false;
+    }
+
+    for (int i = 0; i < SPECTATOR_HISTORY_TICKS; ++i) {
+        sHistory[i].tick = -1;
+    }
+    for (int i = 0; i < SPECTATOR_MESSAGE_SLOTS; ++i) {
+        sMessages[i].tick = -1;
+        sMessages[i].senderCount = 0;
+    }
+    for (int i = 0; i < MAX_SPECTATORS; ++i) {
+        sSpectators[i].isConnected = false;
+    }
+    sNewestTick = -1;
+    sDroppedWorldCount = 0;
+    sPublishedTimerTick = -1;
+    sReportedSentByteCount = 0;
+    atomic_store(&sQueueWriteIndex, 0);
+    atomic_store(&sQueueReadIndex, 0);
+    atomic_store(&sSpectatorCount, 0);
+    atomic_store(&sSentByteCount, 0);
+    atomic_store(&sWholeWorldCount, 0);
+    atomic_store(&sDeltaCount, 0);
+
+    RegisterGauge(&sSpectatorsMetric, "pong_spectators", "Spectators connected to the broadcast.");
+    RegisterCounter(&sSentBytesMetric, "pong_spectator_sent_bytes_total", "Bytes sent to spectators.");
+    RegisterCounter(&sDroppedWorldsMetric, "pong_spectator_dropped_worlds_total", "Worlds that weren't broadcast because the broadcast thread was behind.");
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sQueue);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sSpectators);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sHistory);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sMessages);
+
+    atomic_store(&sIsBroadcastThreadRunning, true);
+    if (!StartThread(&sBroadcastThread, RunBroadcastThread, NULL)) {
+        printf("couldn't start the broadcast thread!\n");
+        atomic_store(&sIsBroadcastThreadRunning, false);
+        close(sEpoll);
+        close(sWakeEvent);
+        CloseTcpSocket(sListener);
+        CloseNet();
+        return false;
+    }
+
+    printf("broadcasting to spectators on port %u\n", port);
+    sIsServerRunning = true;
+    return true;
+#else
+    printf("the spectator server needs epoll, it's linux only for now!\n");
+    return false;
+#endif
+}
+
+void StopSpectatorServer() {
+#ifdef HAS_EPOLL
+    if (!sIsServerRunning) {
+        return;
+    }
+
+    // the broadcast thread might be waiting on epoll with no timeout
+    atomic_store(&sIsBroadcastThreadRunning, false);
+    eventfd_write(sWakeEvent, 1);
+    JoinThread(&sBroadcastThread);
+
+    for (int i = 0; i < MAX_SPECTATORS; ++i) {
+        if (sSpectators[i].isConnected) {
+            CloseSpectator(&sSpectators[i]);
+        }
+    }
+    close(sEpoll);
+    sEpoll = -1;
+    close(sWakeEvent);
+    sWakeEvent = -1;
+    CloseTcpSocket(sListener);
+    CloseNet();
+    sIsServerRunning = false;
+#endif
+}
+
+void PublishSpectatorWorld() {
+    if (!sIsServerRunning) {
+        return;
+    }
+
+    unsigned long long sentByteCount = atomic_load_explicit(&sSentByteCount, memory_order_relaxed);
+    AddToCounter(&sSentBytesMetric, (double) (sentByteCount - sReportedSentByteCount));
+    sReportedSentByteCount = sentByteCount;
+    int spectatorCount = atomic_load_explicit(&sSpectatorCount, memory_order_relaxed);
+    SetGauge(&sSpectatorsMetric, spectatorCount);
+
+    // nobody to send it to, and the broadcast thread is asleep until someone connects. forgetting
+    // what went out last means whoever does gets the world as it is then, even if it hasn't moved on
+    if (spectatorCount == 0) {
+        sPublishedTimerTick = -1;
+        return;
+    }
+
+    // the world only changes when a tick gets simulated or a snapshot loaded (a restart, rollback,
+    // rewind...), anything else would be the same world again under a new spectator tick
+    int timerTick = GetTimerTick();
+    unsigned int loadCount = GetSnapshotLoadCount();
+    if (timerTick == sPublishedTimerTick && loadCount == sPublishedLoadCount) {
+        return;
+    }
+    sPublishedTimerTick = timerTick;
+    sPublishedLoadCount = loadCount;
+
+    unsigned int writeIndex = atomic_load_explicit(&sQueueWriteIndex, memory_order_relaxed);
+    unsigned int readIndex = atomic_load_explicit(&sQueueReadIndex, memory_order_acquire);
+
+    // skipped if the broadcast thread is behind, or if the world's too big to send
+    bool isQueued = writeIndex - readIndex < SPECTATOR_QUEUE_WORLDS;
+    if (isQueued) {
+        QueuedWorld *queued = &sQueue[writeIndex & (SPECTATOR_QUEUE_WORLDS - 1)];
+        queued->size = SaveSnapshot(queued->bytes, SPECTATOR_WORLD_CAPACITY);
+        isQueued = queued->size != 0;
+    }
+
+    if (isQueued) {
+        // publishes the world written above
+        atomic_store_explicit(&sQueueWriteIndex, writeIndex + 1, memory_order_release);
+    }
+    else {
+        sDroppedWorldCount++;
+        AddToCounter(&sDroppedWorldsMetric, 1);
+    }
+}
+
+static void InitViewer(SpectatorViewer *viewer, intptr_t socket, unsigned char *world, unsigned char *message, size_t worldCapacity) {
+    *viewer = (SpectatorViewer) {
+        .isConnected = true,
+        .socket = socket,
+        .tick = -1,
+        .world = world,
+        .worldCapacity = worldCapacity,
+        .message = message,
+    };
+}
+
+static bool ApplyViewerMessage(SpectatorViewer *viewer, const SpectatorMessageHeader *header) {
+    const unsigned char *payload = viewer->message + sizeof(*header);
+    size_t worldSize = 0;
+
+    if (header->baseTick == -1) {
+        memcpy(viewer->world, payload, header->payloadSize);
+        worldSize = header->payloadSize;
+    }
+    else if (header->baseTick == viewer->tick) {
+        worldSize = ApplySnapshotDelta(viewer->world, viewer->worldCapacity, payload, header->payloadSize);
+    }
+
+    if (worldSize == 0 || HashSnapshot(viewer->world, worldSize) != header->worldHash) {
+        viewer->badMessageCount++;
+        return false;
+    }
+
+    viewer->worldSize = worldSize;
+    viewer->tick = header->tick;
+    viewer->worldCount++;
+
+    // the server can make deltas against this one now
+    return SendTcp(viewer->socket, &viewer->tick, sizeof(viewer->tick));
+}
+
+// reads whatever's arrived, returns how many worlds it finished or -1 if the stream ended or went bad
+static int PollViewer(SpectatorViewer *viewer) {
+    int worldCount = 0;
+
+    for (;;) {
+        SpectatorMessageHeader header;
+        size_t messageSize = sizeof(header);
+        if (viewer->messageSize >= sizeof(header)) {
+            memcpy(&header, viewer->message, sizeof(header));
+            messageSize += header.payloadSize;
+        }
+
+        int size = ReceiveTcp(viewer->socket, viewer->message + viewer->messageSize, (int) (messageSize - viewer->messageSize));
+        if (size == 0) {
+            return -1;
+        }
+        if (size < 0) {
+            return worldCount;
+        }
+
+        viewer->messageSize += size;
+        if (viewer->messageSize < sizeof(header)) {
+            continue;
+        }
+
+        memcpy(&header, viewer->message, sizeof(header));
+        if (header.magic != SPECTATOR_MAGIC || header.payloadSize == 0 || header.payloadSize > viewer->worldCapacity) {
+            viewer->badMessageCount++;
+            return -1;
+        }
+        if (viewer->messageSize < sizeof(header) + header.payloadSize) {
+            continue;
+        }
+
+        viewer->messageSize = 0;
+        if (!ApplyViewerMessage(viewer, &header)) {
+            return -1;
+        }
+        worldCount++;
+    }
+}
+
+bool StartSpectating(const char *host, unsigned short port) {
+    if (!InitNet()) {
+        return false;
+    }
+
+    NetAddress address;
+    intptr_t socket;
+    if (!ResolveNetAddress(host, port, &address) || !ConnectTcp(address, &socket)) {
+        CloseNet();
+        return false;
+    }
+
+    InitViewer(&sViewer, socket, sViewerWorld, sViewerMessage, SPECTATOR_WORLD_CAPACITY);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sViewerWorld);
+    REGISTER_STATIC_MEMORY(MEMORY_TAG_NETWORK, sViewerMessage);
+    printf("spectating %s:%u\n", host, port);
+    sIsSpectating = true;
+    return true;
+}
+
+void StopSpectating() {
+    if (!sIsSpectating) {
+        return;
+    }
+    CloseTcpSocket(sViewer.socket);
+    CloseNet();
+    sIsSpectating = false;
+}
+
+bool IsSpectating() {
+    return sIsSpectating;
+}
+
+void UpdateSpectating() {
+    int worldCount = PollViewer(&sViewer);
+    if (worldCount < 0) {
+        printf("lost the match being spectated!\n");
+        StopSpectating();
+        return;
+    }
+
+    // only the newest world gets shown, anything in between already got folded into it
+    if (worldCount > 0 && !LoadSnapshot(sViewer.world, sViewer.worldSize)) {
+        printf("the match being spectated is from a different build!\n");
+        StopSpectating();
+    }
+}
+
+#ifdef HAS_EPOLL
+
+typedef struct LoadTestViewer {
+    SpectatorViewer viewer;
+    unsigned char world[SPECTATOR_LOAD_TEST_WORLD_CAPACITY];
+    unsigned char message[sizeof(SpectatorMessageHeader) + SPECTATOR_LOAD_TEST_WORLD_CAPACITY];
+} LoadTestViewer;
+
+typedef struct LoadTestCrowd {
+    int viewerCount;
+    int connectedCount;
+    unsigned short port;
+    LoadTestViewer *viewers; // viewerCount of them, only allocated for the length of the test
+} LoadTestCrowd;
+
+static atomic_bool sAreLoadTestViewersRunning;
+
+// the whole crowd on one thread, waiting on epoll the same way the server does
+static void RunLoadTestViewers(void *userData) {
+    LoadTestCrowd *crowd = userData;
+    NetAddress server = {.host = 0x7f000001, .port = crowd->port}; // 127.0.0.1
+    int viewerEpoll = epoll_create1(0);
+
+    for (int i = 0; i < crowd->viewerCount && viewerEpoll >= 0; ++i) {
+        intptr_t socket;
+        if (!ConnectTcp(server, &socket)) {
+            break;
+        }
+
+        struct epoll_event event = {.events = EPOLLIN, .data.u32 = (unsigned int) i};
+        epoll_ctl(viewerEpoll, EPOLL_CTL_ADD, (int) socket, &event);
+        LoadTestViewer *viewer = &crowd->viewers[i];
+        InitViewer(&viewer->viewer, socket, viewer->world, viewer->message, SPECTATOR_LOAD_TEST_WORLD_CAPACITY);
+        crowd->connectedCount++;
+    }
+
+    struct epoll_event events[MAX_SPECTATORS];
+    while (atomic_load(&sAreLoadTestViewersRunning) && viewerEpoll >= 0) {
+        int eventCount = epoll_wait(viewerEpoll, events, MAX_SPECTATORS, SPECTATOR_LOAD_TEST_POLL_TIMEOUT);
+
+        for (int i = 0; i < eventCount; ++i) {
+            SpectatorViewer *viewer = &crowd->viewers[events[i].data.u32].viewer;
+            if (viewer->isConnected && PollViewer(viewer) < 0) {
+                epoll_ctl(viewerEpoll, EPOLL_CTL_DEL, (int) viewer->socket, NULL);
+                CloseTcpSocket(viewer->socket);
+                viewer->isConnected = false;
+            }
+        }
+    }
+
+    for (int i = 0; i < crowd->connectedCount; ++i) {
+        if (crowd->viewers[i].viewer.isConnected) {
+            CloseTcpSocket(crowd->viewers[i].viewer.socket);
+        }
+    }
+    if (viewerEpoll >= 0) {
+        close(viewerEpoll);
+    }
+}
+
+#endif // HAS_EPOLL
+
+int RunSpectatorLoadTest(int viewerCount, float seconds) {
+#ifdef HAS_EPOLL
+    viewerCount = viewerCount < 1 ? 1 : (viewerCount > MAX_SPECTATORS ? MAX_SPECTATORS : viewerCount);
+    printf("spectator load test: %d viewers watching a bot match for %.0f s\n", viewerCount, seconds);
+    SetSoundsMuted(true);
+    SetMetricsMuted(true);
+    InitBot();
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+
+    // 128 KB of buffers per viewer, nothing but this test needs them
+    size_t viewersSize = (size_t) viewerCount * sizeof(LoadTestViewer);
+    LoadTestCrowd crowd = {.viewerCount = viewerCount, .port = SPECTATOR_DEFAULT_PORT, .viewers = malloc(viewersSize)};
+    if (crowd.viewers == NULL) {
+        printf("couldn't allocate %d viewers!\n", viewerCount);
+        return 1;
+    }
+    TrackHeapAllocation(MEMORY_TAG_NETWORK, viewersSize);
+
+    if (!StartSpectatorServer(SPECTATOR_DEFAULT_PORT)) {
+        free(crowd.viewers);
+        TrackHeapRelease(MEMORY_TAG_NETWORK, viewersSize);
+        return 1;
+    }
+
+    Thread viewerThread;
+    atomic_store(&sAreLoadTestViewersRunning, true);
+    if (!StartThread(&viewerThread, RunLoadTestViewers, &crowd)) {
+        printf("couldn't start the viewer thread!\n");
+        StopSpectatorServer();
+        free(crowd.viewers);
+        TrackHeapRelease(MEMORY_TAG_NETWORK, viewersSize);
+        return 1;
+    }
+
+    // ticks at the real rate, so the crowd sees the same stream a real match would make
+    int tickCount = (int) (seconds * SIMULATION_TICK_RATE);
+    double simulateTime = 0;
+    double publishTime = 0;
+    double maxPublishTime = 0;
+    double nextTickTime = GetMonotonicTime();
+
+    for (int tick = 0; tick < tickCount; ++tick) {
+        ResetFrameArenas();
+        double startTime = GetMonotonicTime();
+        PlayerInput input = GetBotInput(0);
+        SimulateTick(&input);
+        if (GetGameState() == GAME_STATE_OVER) {
+            ChangeGameStateTo(GAME_STATE_PLAYING);
+        }
+
+        double publishStartTime = GetMonotonicTime();
+        PublishSpectatorWorld();
+        double endTime = GetMonotonicTime();
+
+        simulateTime += publishStartTime - startTime;
+        publishTime += endTime - publishStartTime;
+        if (endTime - publishStartTime > maxPublishTime) {
+            maxPublishTime = endTime - publishStartTime;
+        }
+
+        nextTickTime += SIMULATION_TICK_TIME;
+        if (nextTickTime > endTime) {
+            SleepSeconds(nextTickTime - endTime);
+        }
+    }
+
+    atomic_store(&sAreLoadTestViewersRunning, false);
+    JoinThread(&viewerThread);
+    int droppedWorldCount = sDroppedWorldCount;
+    StopSpectatorServer();
+
+    int stillConnectedCount = 0;
+    int minWorldCount = tickCount;
+    long long totalWorldCount = 0;
+    int badMessageCount = 0;
+
+    for (int i = 0; i < crowd.connectedCount; ++i) {
+        const SpectatorViewer *viewer = &crowd.viewers[i].viewer;
+        stillConnectedCount += viewer->isConnected ? 1 : 0;
+        minWorldCount = viewer->worldCount < minWorldCount ? viewer->worldCount : minWorldCount;
+        totalWorldCount += viewer->worldCount;
+        badMessageCount += viewer->badMessageCount;
+    }
+
+    double averageWorldCount = crowd.connectedCount > 0 ? (double) totalWorldCount / crowd.connectedCount : 0;
+    double sentKilobytes = (double) atomic_load(&sSentByteCount) / 1024;
+
+    printf("%d ticks, simulating %.1f us + publishing %.1f us per tick, worst publish %.1f us\n",
+           tickCount, simulateTime / tickCount * 1000000, publishTime / tickCount * 1000000, maxPublishTime * 1000000);
+    printf("%d/%d viewers connected, %d still there at the end\n", crowd.connectedCount, viewerCount, stillConnectedCount);
+    printf("viewers saw %.1f%% of ticks on average, %.1f%% at worst\n",
+           averageWorldCount * 100 / tickCount, (double) minWorldCount * 100 / tickCount);
+    printf("%d whole worlds + %d deltas sent, %.1f KB/s per viewer, %d worlds dropped before broadcast\n",
+           atomic_load(&sWholeWorldCount), atomic_load(&sDeltaCount),
+           crowd.connectedCount > 0 ? sentKilobytes / crowd.connectedCount / seconds : 0, droppedWorldCount);
+    printf("%d bad messages\n", badMessageCount);
+    free(crowd.viewers);
+    TrackHeapRelease(MEMORY_TAG_NETWORK, viewersSize);
+
+    bool isPassed = crowd.connectedCount == viewerCount && stillConnectedCount == viewerCount &&
+                    badMessageCount == 0 && minWorldCount > 0;
+    printf(isPassed ? "spectator load test PASSED\n" : "spectator load test FAILED\n");
+    return isPassed ? 0 : 1;
+#else
+    printf("the spectator load test needs epoll, it's linux only for now!\n");
+    return 1;
+#endif
+}
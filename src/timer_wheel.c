@@ -0,0 +1,192 @@
+#include "timer_wheel.h"
+#include "snapshot.h"
+#include "memory_usage.h"
+#include "metrics.h"
+#include "log.h"
+#include "world.h"
+
+#define TIMER_INDEX_BITS 16
+#define TIMER_INDEX_MASK ((1u << TIMER_INDEX_BITS) - 1)
+#define FIRING_SLOT TIMER_SLOT_COUNT // timers taken out of a slot to be fired, still cancellable
+#define FREE_SLOT -1
+
+static Metric sPendingTimersMetric;
+
+static TimerId MakeTimerId(int index) {
+    return (gWorld->timers.instances[index].generation << TIMER_INDEX_BITS) | (unsigned int) index;
+}
+
+static void LinkTimer(int index, int slot) {
+    TimerWorld *timers = &gWorld->timers;
+    Timer *timer = &timers->instances[index];
+    timer->slot = slot;
+    timer->previous = -1;
+    timer->next = timers->slotHeads[slot];
+    if (timer->next != -1) {
+        timers->instances[timer->next].previous = index;
+    }
+    timers->slotHeads[slot] = index;
+}
+
+static void UnlinkTimer(int index) {
+    TimerWorld *timers = &gWorld->timers;
+    Timer *timer = &timers->instances[index];
+    if (timer->previous != -1) {
+        timers->instances[timer->previous].next = timer->next;
+    }
+    else {
+        timers->slotHeads[timer->slot] = timer->next;
+    }
+    if (timer->next != -1) {
+        timers->instances[timer->next].previous = timer->previous;
+    }
+}
+
+// the lowest level that reaches as far as the timer's expiry. anything further out than
+// the top level reaches waits in its furthest slot, and gets placed again when that comes round
+static void PlaceTimer(int index) {
+    TimerWorld *timers = &gWorld->timers;
+    int tick = timers->instances[index].expireTick;
+    int delay = tick - timers->currentTick;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delay >= 1 << ((level + 1) * TIMER_WHEEL_SLOT_BITS)) {
+        level++;
+    }
+
+    int reach = 1 << ((level + 1) * TIMER_WHEEL_SLOT_BITS);
+    if (delay >= reach) {
+        tick = timers->currentTick + reach - 1;
+    }
+    LinkTimer(index, level * TIMER_WHEEL_SLOTS + ((tick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1)));
+}
+
+static void ReleaseTimer(int index) {
+    TimerWorld *timers = &gWorld->timers;
+    Timer *timer = &timers->instances[index];
+    timer->slot = FREE_SLOT;
+    timer->generation = timer->generation + 1 > (0xFFFFFFFFu >> TIMER_INDEX_BITS) ? 1 : timer->generation + 1;
+    timer->next = timers->freeTimer;
+    timers->freeTimer = index;
+    timers->pendingTimerCount--;
+}
+
+void InitTimers() {
+    TimerWorld *timers = &gWorld->timers;
+    timers->usedTimerCount = 0;
+    timers->pendingTimerCount = 0;
+    timers->freeTimer = -1;
+    timers->currentTick = 0;
+    for (int i = 0; i < TIMER_SLOT_COUNT + 1; ++i) {
+        timers->slotHeads[i] = -1;
+    }
+
+    REGISTER_SNAPSHOT_ARRAY(timers->instances, timers->usedTimerCount);
+    REGISTER_SNAPSHOT_VARIABLE(timers->pendingTimerCount);
+    REGISTER_SNAPSHOT_VARIABLE(timers->freeTimer);
+    REGISTER_SNAPSHOT_VARIABLE(timers->slotHeads);
+    REGISTER_SNAPSHOT_VARIABLE(timers->currentTick);
+    REGISTER_STATIC_ARRAY_MEMORY(MEMORY_TAG_TIMERS, timers->instances, timers->pendingTimerCount);
+
+    RegisterGauge(&sPendingTimersMetric, "pong_timers_pending", "Scheduled events that haven't fired yet.");
+}
+
+void SetTimerHandler(TimerEvent event, TimerHandler handler) {
+    gWorld->timers.handlers[event] = handler;
+}
+
+TimerId ScheduleTimer(TimerEvent event, int target, int delayTicks) {
+    TimerWorld *timers = &gWorld->timers;
+    int index = timers->freeTimer;
+    if (index != -1) {
+        timers->freeTimer = timers->instances[index].next;
+    }
+    else if (timers->usedTimerCount < MAX_TIMERS) {
+        index = timers->usedTimerCount++;
+        timers->instances[index].generation = 1;
+    }
+    else {
+        LogMessage("too many timers pending, event %d was dropped!", event);
+        return TIMER_NONE;
+    }
+
+    Timer *timer = &timers->instances[index];
+    timer->expireTick = timers->currentTick + (delayTicks > 1 ? delayTicks : 1);
+    timer->event = event;
+    timer->target = target;
+    PlaceTimer(index);
+    timers->pendingTimerCount++;
+    return MakeTimerId(index);
+}
+
+void CancelTimer(TimerId timer) {
+    TimerWorld *timers = &gWorld->timers;
+    int index = (int) (timer & TIMER_INDEX_MASK);
+    if (timer == TIMER_NONE || index >= timers->usedTimerCount || timers->instances[index].slot == FREE_SLOT || MakeTimerId(index) != timer) {
+        return;
+    }
+    UnlinkTimer(index);
+    ReleaseTimer(index);
+}
+
+// everything in a higher level slot gets placed again now that it's closer, which lands it a level (or more) lower
+static void CascadeSlot(int slot) {
+    TimerWorld *timers = &gWorld->timers;
+    int index = timers->slotHeads[slot];
+    timers->slotHeads[slot] = -1;
+    while (index != -1) {
+        int next = timers->instances[index].next;
+        PlaceTimer(index);
+        index = next;
+    }
+}
+
+void AdvanceTimers() {
+    TimerWorld *timers = &gWorld->timers;
+    timers->currentTick++;
+
+    // top level first, so what comes down from it can carry on down in the same tick
+    for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; --level) {
+        int levelShift = level * TIMER_WHEEL_SLOT_BITS;
+        if ((timers->currentTick & ((1 << levelShift) - 1)) == 0) {
+            CascadeSlot(level * TIMER_WHEEL_SLOTS + ((timers->currentTick >> levelShift) & (TIMER_WHEEL_SLOTS - 1)));
+        }
+    }
+
+    // the slot moves to the firing list as a whole, a handler can still cancel anything on it
+    int slot = timers->currentTick & (TIMER_WHEEL_SLOTS - 1);
+    timers->slotHeads[FIRING_SLOT] = timers->slotHeads[slot];
+    timers->slotHeads[slot] = -1;
+    for (int index = timers->slotHeads[FIRING_SLOT]; index != -1; index = timers->instances[index].next) {
+        timers->instances[index].slot = FIRING_SLOT;
+    }
+
+    while (timers->slotHeads[FIRING_SLOT] != -1) {
+        int index = timers->slotHeads[FIRING_SLOT];
+        UnlinkTimer(index);
+        Timer *timer = &timers->instances[index];
+
+        // only due timers come down to level 0, but one that was out of reach gets checked anyway
+        if (timer->expireTick != timers->currentTick) {
+            PlaceTimer(index);
+            continue;
+        }
+
+        int event = timer->event;
+        int target = timer->target;
+        ReleaseTimer(index);
+        if (timers->handlers[event] != NULL) {
+            timers->handlers[event](target);
+        }
+    }
+
+    SetGauge(&sPendingTimersMetric, timers->pendingTimerCount);
+}
+
+int GetTimerTick() {
+    return gWorld->timers.currentTick;
+}
+
+float GetTimerProgress(int startTick, int durationTicks) {
+    float progress = (float) (gWorld->timers.currentTick - startTick) / (float) durationTicks;
+    return progress < 0 ? 0 : progress > 1 ? 1 : progress;
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include "training.h"
+#include "game.h"
+#include "bot.h"
+#include "ball.h"
+#include "arena.h"
+#include "sound.h"
+#include "metrics.h"
+#include "particles.h"
+#include "render_list.h"
+#include "math_util.h"
+#include "platform.h"
+
+typedef enum TrainingPhase {
+    TRAINING_PHASE_FULL_HOUSE,
+    TRAINING_PHASE_PARTICLE_STORM,
+    TRAINING_PHASE_RESTARTS,
+    TRAINING_PHASE_COUNT,
+} TrainingPhase;
+
+static const char *sPhaseNames[TRAINING_PHASE_COUNT] = {
+    [TRAINING_PHASE_FULL_HOUSE] = "full house",
+    [TRAINING_PHASE_PARTICLE_STORM] = "particle storm",
+    [TRAINING_PHASE_RESTARTS] = "restarts",
+};
+
+static const int sPhaseBallCounts[TRAINING_PHASE_COUNT] = {
+    [TRAINING_PHASE_FULL_HOUSE] = CROWDED_BALL_COUNT,
+    [TRAINING_PHASE_PARTICLE_STORM] = TRAINING_STORM_BALL_COUNT,
+    [TRAINING_PHASE_RESTARTS] = TRAINING_RESTART_BALL_COUNT,
+};
+
+static const Color sStormColors[] = {YELLOW, ORANGE, PINK, SKYBLUE};
+
+// runs one phase, returns how long it took
+static double RunTrainingPhase(TrainingPhase phase, int tickCount) {
+    SetStartingBallCount(sPhaseBallCounts[phase]);
+    ChangeGameStateTo(GAME_STATE_PLAYING);
+    int restartCount = 0;
+
+    double startTime = GetMonotonicTime();
+    for (int tick = 0; tick < tickCount; ++tick) {
+        ResetFrameArenas();
+        PlayerInput input = GetBotInput(0);
+        SimulateTick(&input);
+
+        if (phase == TRAINING_PHASE_PARTICLE_STORM && tick % TRAINING_STORM_INTERVAL == 0) {
+            Vector2 position = {RandomFloat() * GAME_WIDTH, RandomFloat() * GAME_HEIGHT};
+            int colorCount = sizeof(sStormColors) / sizeof(sStormColors[0]);
+            PlayParticleBurst(position, sStormColors[RandomInt(0, colorCount - 1)], TRAINING_STORM_PARTICLES);
+        }
+
+        // a dead bot restarts straight away, the restart phase doesn't wait for it to die
+        bool isRestartDue = phase == TRAINING_PHASE_RESTARTS && tick % TRAINING_RESTART_INTERVAL == TRAINING_RESTART_INTERVAL - 1;
+        if (GetGameState() == GAME_STATE_OVER || isRestartDue) {
+            ChangeGameStateTo(GAME_STATE_PLAYING);
+            restartCount++;
+        }
+
+        RecordGameWorld();
+        SubmitRenderList(&gRecordingRenderBackend);
+    }
+    double elapsedTime = GetMonotonicTime() - startTime;
+
+    printf("%-16s %d balls, %d restarts, %.2f us per tick\n",
+           sPhaseNames[phase], sPhaseBallCounts[phase], restartCount, elapsedTime / tickCount * 1000000);
+    return elapsedTime;
+}
+
+int RunTrainingWorkload(int phaseTicks, unsigned int seed) {
+    printf("training workload: %d ticks per phase, seed %u\n", phaseTicks, seed);
+    SetSoundsMuted(true);
+    SetMetricsMuted(true);
+    SeedRandom(seed);
+    InitBot();
+
+    double totalTime = 0;
+    for (int i = 0; i < TRAINING_PHASE_COUNT; ++i) {
+        totalTime += RunTrainingPhase(i, phaseTicks);
+    }
+
+    // the release pipeline reads this line to compare builds
+    printf("%.3f us per tick over %d ticks, render checksum %08x\n",
+           totalTime / (phaseTicks * TRAINING_PHASE_COUNT) * 1000000, phaseTicks * TRAINING_PHASE_COUNT, GetRecordingBackendChecksum());
+    return 0;
+}
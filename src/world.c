@@ -0,0 +1,25 @@
+#include <string.h>
+#include "world.h"
+
+THREAD_LOCAL World *gWorld;
+
+// only the main thread plays in this one, so it doesn't have to be thread local
+static World sMainWorld;
+
+void InitWorld(World *world) {
+    memset(world, 0, sizeof(*world));
+    world->randomState = 1;
+    world->game.startingBallCount = STARTING_BALL_COUNT;
+    world->field.width = GAME_WIDTH;
+    world->field.height = GAME_HEIGHT;
+    world->players.count = 1;
+    world->balls.maxSpeed = BALL_MAX_SPEED;
+}
+
+void UseWorld(World *world) {
+    gWorld = world;
+}
+
+World *GetMainWorld() {
+    return &sMainWorld;
+}